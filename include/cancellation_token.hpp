@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Shared flag to cancel work, copies of a token share the flag
+ */
+class CancellationToken
+{
+public:
+    /**
+     * Constructor, creates a flag that isn't cancelled
+     */
+    CancellationToken();
+
+    /**
+     * Cancel the work of this token and of all its copies
+     */
+    void Cancel() const;
+
+    /**
+     * Check if the work has been cancelled
+     * @return `true` if cancelled, else `false`
+     */
+    bool IsCancelled() const;
+
+    /**
+     * Create a token that is also cancelled when this one is, cancelling it leaves this one as is
+     * @return The linked token
+     */
+    CancellationToken CreateLinked() const;
+
+private:
+    /**
+     * Flag shared by the copies of a token
+     */
+    struct State
+    {
+        /// Set once cancelled
+        std::atomic<bool> bCancelled{false};
+
+        /// State of the token this one is linked to, if any
+        std::shared_ptr<const State> parent;
+    };
+
+    /// The shared flag
+    std::shared_ptr<State> m_state;
+};
@@ -2,6 +2,12 @@
 
 #include <immintrin.h>
 
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
 #include "common_types.h"
 #include "kangaroo_twelve.h"
 #include "m256.h"
@@ -90,6 +96,13 @@ typedef struct
 } point_precomp;
 typedef point_precomp point_precomp_t[1];
 
+typedef struct
+{ // Odd multiples of a point Q, Phi(Q), Psi(Q) and Phi(Psi(Q)), the variable-base input of the
+  // double scalar multiplication (for reusing the precomputation of a public key)
+    point_extproj_precomp_t table[4][4];
+} point_double_precomp;
+typedef point_double_precomp point_double_precomp_t[1];
+
 static const unsigned long long PARAMETER_d[4] =
     {0x0000000000000142, 0x00000000000000E4, 0xB3821488F1FC0C8D, 0x5E472F846657E0FC};
 static const unsigned long long curve_order[4] =
@@ -1216,7 +1229,100 @@ static uint64_t __shiftright128(uint64_t LowPart, uint64_t HighPart, uint8_t Shi
 }
 #endif
 
-static void fpmul1271(felm_t a, felm_t b, felm_t c)
+// MULX/ADCX/ADOX field arithmetic backend. When the compiler already targets BMI2 and ADX the
+// backend is selected at compile time, otherwise it is selected at runtime based on CPUID. Both
+// backends compute the same 256-bit product and fold it identically, so results are bit-identical.
+#ifdef _MSC_VER
+#define FOURQ_TARGET_MULX
+#else
+#define FOURQ_TARGET_MULX __attribute__((target("bmi2,adx")))
+#endif
+
+static bool isMulxSupported()
+{ // CPUID.(EAX=07H,ECX=0H):EBX reports BMI2 in bit 8 and ADX in bit 19
+    unsigned int ebx = 0;
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+    {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    ebx = (unsigned int)info[1];
+#else
+    unsigned int eax, ecx, edx;
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx))
+    {
+        return false;
+    }
+#endif
+    return (ebx & (1 << 8)) && (ebx & (1 << 19));
+}
+
+#if defined(__BMI2__) && defined(__ADX__)
+static const bool useMulxFieldArithmetic = true;
+#else
+static const bool useMulxFieldArithmetic = isMulxSupported();
+#endif
+
+FOURQ_TARGET_MULX static void fpmul1271_mulx(felm_t a, felm_t b, felm_t c)
+{ // Field multiplication, c = a*b mod (2^127-1), using two independent carry chains
+    unsigned long long r0, r1, r2, r3, l1, h1, l2, h2, s0, s1;
+
+    r0 = _mulx_u64(a[0], b[0], &r1);
+    r2 = _mulx_u64(a[1], b[1], &r3);
+    l1 = _mulx_u64(a[0], b[1], &h1);
+    l2 = _mulx_u64(a[1], b[0], &h2);
+
+    // (r3,r2,r1,r0) = a0*b0 + (a0*b1 + a1*b0)*2^64 + a1*b1*2^128
+    unsigned char cf = _addcarryx_u64(0, r1, l1, &r1);
+    unsigned char of = _addcarryx_u64(0, r1, l2, &r1);
+    cf = _addcarryx_u64(cf, r2, h1, &r2);
+    of = _addcarryx_u64(of, r2, h2, &r2);
+    _addcarryx_u64(cf, r3, 0, &r3);
+    _addcarryx_u64(of, r3, 0, &r3);
+
+    // (s1,s0) = (product mod 2^127) + (product >> 127)
+    _addcarryx_u64(
+        _addcarryx_u64(0, r0, (r1 >> 63) | (r2 << 1), &s0),
+        r1 & 0x7FFFFFFFFFFFFFFF,
+        (r2 >> 63) | (r3 << 1),
+        &s1);
+    _addcarryx_u64(
+        _addcarryx_u64(0, s0, s1 >> 63, &c[0]),
+        s1 & 0x7FFFFFFFFFFFFFFF,
+        0,
+        &c[1]);
+}
+
+FOURQ_TARGET_MULX static void fpsqr1271_mulx(felm_t a, felm_t c)
+{ // Field squaring, c = a^2 mod (2^127-1), using MULX/ADCX
+    unsigned long long r0, r1, r2, r3, l, h, s0, s1;
+
+    r0 = _mulx_u64(a[0], a[0], &r1);
+    r2 = _mulx_u64(a[1], a[1], &r3);
+    l = _mulx_u64(a[0], a[1], &h);
+
+    // (r3,r2,r1,r0) = a0^2 + 2*a0*a1*2^64 + a1^2*2^128, where 2*a0*a1 < 2^128
+    unsigned char cf = _addcarryx_u64(0, r1, l << 1, &r1);
+    cf = _addcarryx_u64(cf, r2, (h << 1) | (l >> 63), &r2);
+    _addcarryx_u64(cf, r3, 0, &r3);
+
+    // (s1,s0) = (product mod 2^127) + (product >> 127)
+    _addcarryx_u64(
+        _addcarryx_u64(0, r0, (r1 >> 63) | (r2 << 1), &s0),
+        r1 & 0x7FFFFFFFFFFFFFFF,
+        (r2 >> 63) | (r3 << 1),
+        &s1);
+    _addcarryx_u64(
+        _addcarryx_u64(0, s0, s1 >> 63, &c[0]),
+        s1 & 0x7FFFFFFFFFFFFFFF,
+        0,
+        &c[1]);
+}
+
+static void fpmul1271_portable(felm_t a, felm_t b, felm_t c)
 { // Field multiplication, c = a*b mod (2^127-1)
     unsigned long long tt1[2], tt2[2], tt3[2];
 
@@ -1244,7 +1350,7 @@ static void fpmul1271(felm_t a, felm_t b, felm_t c)
         &c[1]);
 }
 
-static void fpsqr1271(felm_t a, felm_t c)
+static void fpsqr1271_portable(felm_t a, felm_t c)
 { // Field squaring, c = a^2 mod (2^127-1)
     unsigned long long tt1[2], tt2[2], tt3[2];
 
@@ -1271,6 +1377,30 @@ static void fpsqr1271(felm_t a, felm_t c)
         &c[1]);
 }
 
+static void fpmul1271(felm_t a, felm_t b, felm_t c)
+{ // Field multiplication, c = a*b mod (2^127-1)
+    if (useMulxFieldArithmetic)
+    {
+        fpmul1271_mulx(a, b, c);
+    }
+    else
+    {
+        fpmul1271_portable(a, b, c);
+    }
+}
+
+static void fpsqr1271(felm_t a, felm_t c)
+{ // Field squaring, c = a^2 mod (2^127-1)
+    if (useMulxFieldArithmetic)
+    {
+        fpsqr1271_mulx(a, c);
+    }
+    else
+    {
+        fpsqr1271_portable(a, c);
+    }
+}
+
 static void fpexp1251(felm_t a, felm_t af)
 { // Exponentiation over GF(p), af = a^(125-1)
     felm_t t1, t2, t3, t4, t5;
@@ -1378,6 +1508,29 @@ static void fp2addsub1271(f2elm_t a, f2elm_t b, f2elm_t c)
     fp2sub1271(a, b, c);
 }
 
+static void fpinv1271(felm_t a)
+{ // Field inversion, a = a^-1 = a^(p-2) mod p
+    felm_t t;
+
+    fpexp1251(a, t);
+    fpsqr1271(t, t);
+    fpsqr1271(t, t);
+    fpmul1271(a, t, a);
+}
+
+static void fp2inv1271(f2elm_t a)
+{ // GF(p^2) inversion, a = (a0-i*a1)/(a0^2+a1^2)
+    f2elm_t t1;
+
+    fpsqr1271(a[0], t1[0]);         // t10 = a0^2
+    fpsqr1271(a[1], t1[1]);         // t11 = a1^2
+    fpadd1271(t1[0], t1[1], t1[0]); // t10 = a0^2+a1^2
+    fpinv1271(t1[0]);               // t10 = (a0^2+a1^2)^-1
+    fpneg1271(a[1]);                // a = a0-i*a1
+    fpmul1271(a[0], t1[0], a[0]);
+    fpmul1271(a[1], t1[0], a[1]); // a = (a0-i*a1)*(a0^2+a1^2)^-1
+}
+
 static void table_lookup_fixed_base(point_precomp_t P, unsigned int digit, unsigned int sign)
 { // Table lookup to extract a point represented as (x+y,y-x,2t) corresponding to extended twisted
   // Edwards coordinates (X:Y:Z:T) with Z=1
@@ -1669,10 +1822,9 @@ static void eccmadd(point_precomp_t Q, point_extproj_t P)
     fp2mul1271(P->ta, t1, P->y);     // Yfinal = alpha*omega
 }
 
-static void ecc_mul_fixed(unsigned long long* k, point_t Q)
-{ // Fixed-base scalar multiplication Q = k*G, where G is the generator. FIXED_BASE_TABLE stores
-  // v*2^(w-1) = 80 multiples of G.
-    unsigned int digits[250];
+static void ecc_mul_fixed_recode(unsigned long long* k, unsigned int* digits)
+{ // Recoding of the scalar k mod r into the 250 digits of the fixed-base comb used by
+  // ecc_mul_fixed(). digits[0..49] form the "sign" row, digits[50..249] the (w-1) value rows
     unsigned long long scalar[4];
 
     Montgomery_multiply_mod_order(k, Montgomery_Rprime, scalar);
@@ -1731,6 +1883,24 @@ static void ecc_mul_fixed(unsigned long long* k, point_t Q)
         scalar[2] += carry;
         scalar[3] += (scalar[2] ? 0 : (carry & 1)); // carry = (scalar[j] < temp);
     }
+}
+
+static unsigned int ecc_mul_fixed_index(unsigned int* digits, unsigned int v, unsigned int column)
+{ // Index into FIXED_BASE_TABLE of the comb entry for table v and the given digit column. The sign
+  // of the entry is digits[10*v + column]
+    return 16 * v + (((((digits[200 + 10 * v + column] << 1) + digits[150 + 10 * v + column])
+                       << 1) +
+                      digits[100 + 10 * v + column])
+                     << 1) +
+           digits[50 + 10 * v + column];
+}
+
+static void ecc_mul_fixed(unsigned long long* k, point_t Q)
+{ // Fixed-base scalar multiplication Q = k*G, where G is the generator. FIXED_BASE_TABLE stores
+  // v*2^(w-1) = 80 multiples of G.
+    unsigned int digits[250];
+
+    ecc_mul_fixed_recode(k, digits);
 
     point_extproj_t R;
     point_precomp_t S;
@@ -2018,6 +2188,112 @@ static void ecc_mul_fixed(unsigned long long* k, point_t Q)
     eccnorm(R, Q);
 }
 
+// Fixed-base scalar multiplication with a signed fixed-window table (opt-in alternative to the comb
+// of ecc_mul_fixed()). The scalar is recoded into FIXED_WINDOW_COUNT(w) odd digits in
+// [-(2^w-1), 2^w-1], one per window of w bits, so k*G takes FIXED_WINDOW_COUNT(w)-1 mixed
+// additions and no doublings. The table holds the 2^(w-1) odd multiples of 2^(w*i)*G for every
+// window i, i.e. FIXED_WINDOW_COUNT(w)*2^(w-1) points of 96 bytes. Like ecc_mul_fixed(), the table
+// lookup is indexed by the secret digits
+#define FIXED_WINDOW_MIN_WIDTH 4
+#define FIXED_WINDOW_MAX_WIDTH 16
+#define FIXED_WINDOW_COUNT(w) (247 / (w) + 1) // Odd k mod r is below 2^247
+
+static void ecc_mul_fixed_window_recode(unsigned long long* k, unsigned int w, int* digits)
+{ // Recoding of the scalar k mod r into FIXED_WINDOW_COUNT(w) odd digits, k = sum digits[i]*2^(w*i)
+    unsigned long long scalar[4];
+
+    Montgomery_multiply_mod_order(k, Montgomery_Rprime, scalar);
+    Montgomery_multiply_mod_order(scalar, ONE, scalar);
+
+    // Converting scalar to odd using the prime subgroup order
+    if (!(scalar[0] & 1))
+    {
+        unsigned char carry = _addcarry_u64(0, scalar[0], CURVE_ORDER_0, &scalar[0]);
+        carry = _addcarry_u64(carry, scalar[1], CURVE_ORDER_1, &scalar[1]);
+        carry = _addcarry_u64(carry, scalar[2], CURVE_ORDER_2, &scalar[2]);
+        _addcarry_u64(carry, scalar[3], CURVE_ORDER_3, &scalar[3]);
+    }
+
+    const unsigned int count = FIXED_WINDOW_COUNT(w);
+    for (unsigned int i = 0; i < count - 1; i++)
+    {
+        // digit = (scalar mod 2^(w+1)) - 2^w is odd, so (scalar - digit)/2^w stays odd
+        const int digit = (int)(scalar[0] & ((2ULL << w) - 1)) - (1 << w);
+        const unsigned long long extension = digit < 0 ? 0xFFFFFFFFFFFFFFFF : 0;
+        digits[i] = digit;
+
+        unsigned char borrow =
+            _subborrow_u64(0, scalar[0], (unsigned long long)(long long)digit, &scalar[0]);
+        borrow = _subborrow_u64(borrow, scalar[1], extension, &scalar[1]);
+        borrow = _subborrow_u64(borrow, scalar[2], extension, &scalar[2]);
+        _subborrow_u64(borrow, scalar[3], extension, &scalar[3]);
+
+        scalar[0] = __shiftright128(scalar[0], scalar[1], (uint8_t)w);
+        scalar[1] = __shiftright128(scalar[1], scalar[2], (uint8_t)w);
+        scalar[2] = __shiftright128(scalar[2], scalar[3], (uint8_t)w);
+        scalar[3] >>= w;
+    }
+    digits[count - 1] = (int)scalar[0];
+}
+
+static void table_lookup_fixed_window(
+    const point_precomp* table,
+    unsigned int w,
+    unsigned int window,
+    int digit,
+    point_precomp_t P)
+{ // Table lookup of digit*2^(w*window)*G, represented as (x+y,y-x,2dt)
+    const point_precomp* entry =
+        table + ((size_t)window << (w - 1)) + ((unsigned int)(digit < 0 ? -digit : digit) >> 1);
+
+    if (digit < 0)
+    {
+        memcpy(P->xy, entry->yx, 32);
+        memcpy(P->yx, entry->xy, 32);
+        P->t2[0][0] = ~entry->t2[0][0];
+        P->t2[0][1] = 0x7FFFFFFFFFFFFFFF - entry->t2[0][1];
+        P->t2[1][0] = ~entry->t2[1][0];
+        P->t2[1][1] = 0x7FFFFFFFFFFFFFFF - entry->t2[1][1];
+    }
+    else
+    {
+        memcpy(P, entry, sizeof(point_precomp));
+    }
+}
+
+static void ecc_mul_fixed_window(
+    const point_precomp* table,
+    unsigned int w,
+    unsigned long long* k,
+    point_t Q)
+{ // Fixed-base scalar multiplication Q = k*G using a table built for window width w
+    int digits[FIXED_WINDOW_COUNT(FIXED_WINDOW_MIN_WIDTH)];
+    point_extproj_t R;
+    point_precomp_t S;
+
+    ecc_mul_fixed_window_recode(k, w, digits);
+
+    table_lookup_fixed_window(table, w, 0, digits[0], S);
+    // Conversion from representation (x+y,y-x,2dt) to (X,Y,Z,Ta,Tb)
+    fp2sub1271(S->xy, S->yx, R->x); // 2*x1
+    fp2add1271(S->xy, S->yx, R->y); // 2*y1
+    fp2div1271(R->x);               // XQ = x1
+    fp2div1271(R->y);               // YQ = y1
+    R->z[0][0] = 1;
+    R->z[0][1] = 0;
+    R->z[1][0] = 0;
+    R->z[1][1] = 0;            // ZQ = 1
+    memcpy(&R->ta, &R->x, 32); // TaQ = x1
+    memcpy(&R->tb, &R->y, 32); // TbQ = y1
+
+    for (unsigned int i = 1; i < FIXED_WINDOW_COUNT(w); i++)
+    {
+        table_lookup_fixed_window(table, w, i, digits[i], S);
+        eccmadd(S, R);
+    }
+    eccnorm(R, Q);
+}
+
 static void ecc_tau(point_extproj_t P)
 { // Apply tau mapping to a point, P = tau(P)
     f2elm_t t0, t1;
@@ -2286,16 +2562,10 @@ static void ecc_precomp_double(point_extproj_t P, point_extproj_precomp_t* Table
     R1_to_R2(Q, Table[3]);        // Converting from (X,Y,Z,Ta,Tb) to (X+Y,Y-X,2Z,2dT)
 }
 
-static bool ecc_mul_double(unsigned long long* k, unsigned long long* l, point_t Q)
-{ // Double scalar multiplication R = k*G + l*Q, where the G is the generator
-  // Uses DOUBLE_SCALAR_TABLE, which contains multiples of G, Phi(G), Psi(G) and Phi(Psi(G))
-  // The function uses wNAF with interleaving.
-    char digits_k1[65], digits_k2[65], digits_k3[65], digits_k4[65];
-    char digits_l1[65], digits_l2[65], digits_l3[65], digits_l4[65];
-    point_precomp_t V;
-    point_extproj_t Q1, Q2, Q3, Q4, T;
-    point_extproj_precomp_t U, Q_table1[4], Q_table2[4], Q_table3[4], Q_table4[4];
-    unsigned long long k_scalars[4], l_scalars[4];
+static bool ecc_precomp_double_point(point_t Q, point_double_precomp_t P)
+{ // Generation of the variable-base precomputation tables of the double scalar multiplication
+  // function ecc_mul_double(), returns false if Q does not lie on the curve
+    point_extproj_t Q1, Q2, Q3, Q4;
 
     point_setup(Q, Q1); // Convert to representation (X,Y,1,Ta,Tb)
 
@@ -2324,6 +2594,34 @@ static bool ecc_mul_double(unsigned long long* k, unsigned long long* l, point_t
     memcpy(&Q4->tb, &Q2->tb, 32);
     ecc_psi(Q4);
 
+    ecc_precomp_double(Q1, P->table[0]);
+    ecc_precomp_double(Q2, P->table[1]);
+    ecc_precomp_double(Q3, P->table[2]);
+    ecc_precomp_double(Q4, P->table[3]);
+
+    return true;
+}
+
+static void ecc_mul_double_precomp(
+    unsigned long long* k,
+    unsigned long long* l,
+    point_double_precomp_t P,
+    point_t Q)
+{ // Double scalar multiplication Q = k*G + l*P, where the G is the generator and P holds the
+  // tables generated by ecc_precomp_double_point()
+  // Uses DOUBLE_SCALAR_TABLE, which contains multiples of G, Phi(G), Psi(G) and Phi(Psi(G))
+  // The function uses wNAF with interleaving.
+    char digits_k1[65], digits_k2[65], digits_k3[65], digits_k4[65];
+    char digits_l1[65], digits_l2[65], digits_l3[65], digits_l4[65];
+    point_precomp_t V;
+    point_extproj_t T;
+    point_extproj_precomp_t U;
+    point_extproj_precomp_t* Q_table1 = P->table[0];
+    point_extproj_precomp_t* Q_table2 = P->table[1];
+    point_extproj_precomp_t* Q_table3 = P->table[2];
+    point_extproj_precomp_t* Q_table4 = P->table[3];
+    unsigned long long k_scalars[4], l_scalars[4];
+
     decompose((unsigned long long*)k, k_scalars); // Scalar decomposition
     decompose((unsigned long long*)l, l_scalars);
     wNAF_recode(k_scalars[0], 8, digits_k1); // Scalar recoding
@@ -2334,10 +2632,6 @@ static bool ecc_mul_double(unsigned long long* k, unsigned long long* l, point_t
     wNAF_recode(l_scalars[1], 4, digits_l2);
     wNAF_recode(l_scalars[2], 4, digits_l3);
     wNAF_recode(l_scalars[3], 4, digits_l4);
-    ecc_precomp_double(Q1, Q_table1);
-    ecc_precomp_double(Q2, Q_table2);
-    ecc_precomp_double(Q3, Q_table3);
-    ecc_precomp_double(Q4, Q_table4);
 
     T->x[0][0] = 0;
     T->x[0][1] = 0;
@@ -2444,6 +2738,17 @@ static bool ecc_mul_double(unsigned long long* k, unsigned long long* l, point_t
     }
 
     eccnorm(T, Q);
+}
+
+static bool ecc_mul_double(unsigned long long* k, unsigned long long* l, point_t Q)
+{ // Double scalar multiplication R = k*G + l*Q, where the G is the generator, R is returned in Q
+    point_double_precomp_t P;
+
+    if (!ecc_precomp_double_point(Q, P))
+    {
+        return false;
+    }
+    ecc_mul_double_precomp(k, l, P, Q);
 
     return true;
 }
@@ -2508,6 +2813,31 @@ static void cofactor_clearing(point_extproj_t R)
     eccdouble(R);
 }
 
+static void ecc_mul_recode(
+    unsigned long long* scalars,
+    unsigned int* digits,
+    unsigned int* sign_masks)
+{ // Recoding sub-scalars for use in the variable-base scalar multiplication. On return
+  // scalars[1..3] hold the bits of the most significant digit
+    for (unsigned int i = 0; i < 64; i++)
+    {
+        scalars[0] >>= 1;
+        const unsigned int bit0 = scalars[0] & 1;
+        sign_masks[i] = bit0;
+
+        digits[i] = scalars[1] & 1;
+        scalars[1] = (scalars[1] >> 1) + ((bit0 | digits[i]) ^ bit0);
+
+        unsigned int bit = scalars[2] & 1;
+        scalars[2] = (scalars[2] >> 1) + ((bit0 | bit) ^ bit0);
+        digits[i] += (bit << 1);
+
+        bit = scalars[3] & 1;
+        scalars[3] = (scalars[3] >> 1) + ((bit0 | bit) ^ bit0);
+        digits[i] += (bit << 2);
+    }
+}
+
 static bool ecc_mul(point_t P, unsigned long long* k, point_t Q)
 { // Variable-base scalar multiplication Q = k*P using a 4-dimensional decomposition
   // This function performs point validation and (if selected) cofactor clearing
@@ -2527,24 +2857,7 @@ static bool ecc_mul(point_t P, unsigned long long* k, point_t Q)
 
     cofactor_clearing(R);
 
-    // Recoding sub-scalars for use in the variable-base scalar multiplication
-    for (unsigned int i = 0; i < 64; i++)
-    {
-        scalars[0] >>= 1;
-        const unsigned int bit0 = scalars[0] & 1;
-        sign_masks[i] = bit0;
-
-        digits[i] = scalars[1] & 1;
-        scalars[1] = (scalars[1] >> 1) + ((bit0 | digits[i]) ^ bit0);
-
-        unsigned int bit = scalars[2] & 1;
-        scalars[2] = (scalars[2] >> 1) + ((bit0 | bit) ^ bit0);
-        digits[i] += (bit << 1);
-
-        bit = scalars[3] & 1;
-        scalars[3] = (scalars[3] >> 1) + ((bit0 | bit) ^ bit0);
-        digits[i] += (bit << 2);
-    }
+    ecc_mul_recode(scalars, digits, sign_masks);
 
     ecc_precomp(R, Table[1]); // Precomputation
     for (unsigned int i = 0; i < 8; i++)
@@ -2825,30 +3138,47 @@ static void getIdentity(unsigned char* publicKey, char* identity, bool isLowerCa
     }
 }
 
-static void sign(
-    const unsigned char* subseed,
-    const unsigned char* publicKey,
-    const unsigned char* messageDigest,
-    unsigned char* signature)
-{ // SchnorrQ signature generation
-  // It produces the signature signature of a message messageDigest of size 32 in bytes
-  // Inputs: 32-byte subseed, 32-byte publicKey, and messageDigest of size 32 in bytes
-  // Output: 64-byte signature
-    point_t R;
-    unsigned char k[64], h[64], temp[32 + 64];
-    unsigned long long r[8];
+static void sign_expand_key(const unsigned char* subseed, unsigned char* expandedKey)
+{ // Expansion of a subseed into the 64-byte key used by sign_expanded(): the secret scalar in
+  // Montgomery representation followed by the 32-byte prefix that is hashed into the nonce
+    unsigned char k[64];
 
     KangarooTwelve((unsigned char*)subseed, 32, k, 64);
 
-    memcpy(temp + 32, k + 32, 32);
-    memcpy(temp + 64, messageDigest, 32);
+    Montgomery_multiply_mod_order(
+        (unsigned long long*)k,
+        Montgomery_Rprime,
+        (unsigned long long*)expandedKey);
+    memcpy(expandedKey + 32, k + 32, 32);
+}
 
-    KangarooTwelve(temp + 32, 32 + 32, (unsigned char*)r, 64);
+static void sign_nonce(
+    const unsigned char* expandedKey,
+    const unsigned char* messageDigest,
+    unsigned long long* r)
+{ // Computation of the 64-byte nonce r of sign_expanded(), hashed from the prefix of the expanded
+  // key and the message digest
+    unsigned char temp[32 + 32];
+
+    memcpy(temp, expandedKey + 32, 32);
+    memcpy(temp + 32, messageDigest, 32);
+
+    KangarooTwelve(temp, 32 + 32, (unsigned char*)r, 64);
+}
+
+static void sign_finish(
+    const unsigned char* expandedKey,
+    const unsigned char* publicKey,
+    const unsigned char* messageDigest,
+    unsigned long long* r,
+    unsigned char* signature)
+{ // Completion of sign_expanded() from the nonce r and the encoding of R = r*G in the lowest
+  // 32 bytes of the signature, computes the highest 32 bytes s = r - h*k mod order
+    unsigned char h[64], temp[32 + 64];
 
-    ecc_mul_fixed(r, R);
-    encode(R, signature); // Encode lowest 32 bytes of signature
     memcpy(temp, signature, 32);
     memcpy(temp + 32, publicKey, 32);
+    memcpy(temp + 64, messageDigest, 32);
 
     KangarooTwelve(temp, 32 + 64, h, 64);
     Montgomery_multiply_mod_order(r, Montgomery_Rprime, r);
@@ -2858,10 +3188,7 @@ static void sign(
         Montgomery_Rprime,
         (unsigned long long*)h);
     Montgomery_multiply_mod_order((unsigned long long*)h, ONE, (unsigned long long*)h);
-    Montgomery_multiply_mod_order(
-        (unsigned long long*)k,
-        Montgomery_Rprime,
-        (unsigned long long*)(signature + 32));
+    memcpy(signature + 32, expandedKey, 32);
     Montgomery_multiply_mod_order(
         (unsigned long long*)h,
         Montgomery_Rprime,
@@ -2912,6 +3239,68 @@ static void sign(
     }
 }
 
+static void sign_expanded(
+    const unsigned char* expandedKey,
+    const unsigned char* publicKey,
+    const unsigned char* messageDigest,
+    unsigned char* signature)
+{ // SchnorrQ signature generation with a key expanded by sign_expand_key()
+  // Inputs: 64-byte expandedKey, 32-byte publicKey, and messageDigest of size 32 in bytes
+  // Output: 64-byte signature
+    point_t R;
+    unsigned long long r[8];
+
+    sign_nonce(expandedKey, messageDigest, r);
+    ecc_mul_fixed(r, R);
+    encode(R, signature); // Encode lowest 32 bytes of signature
+    sign_finish(expandedKey, publicKey, messageDigest, r, signature);
+}
+
+static void sign(
+    const unsigned char* subseed,
+    const unsigned char* publicKey,
+    const unsigned char* messageDigest,
+    unsigned char* signature)
+{ // SchnorrQ signature generation
+  // It produces the signature signature of a message messageDigest of size 32 in bytes
+  // Inputs: 32-byte subseed, 32-byte publicKey, and messageDigest of size 32 in bytes
+  // Output: 64-byte signature
+    unsigned char expandedKey[64];
+
+    sign_expand_key(subseed, expandedKey);
+    sign_expanded(expandedKey, publicKey, messageDigest, signature);
+}
+
+static bool verify_precomp(
+    point_double_precomp_t P,
+    const unsigned char* publicKey,
+    const unsigned char* messageDigest,
+    const unsigned char* signature)
+{ // SchnorrQ signature verification with the precomputed tables P of the decoded PublicKey,
+  // generated by ecc_precomp_double_point(), skipping the decoding and precomputation of verify()
+  // Inputs: tables P, 32-byte PublicKey, 64-byte Signature, and MessageDigest of size 32 in bytes
+  // Output: TRUE (valid signature) or FALSE (invalid signature)
+    point_t A;
+    unsigned char temp[32 + 64], h[64];
+
+    if ((signature[15] & 0x80) || (signature[62] & 0xC0) || signature[63])
+    { // Are bit128(Signature) = 0 and Signature+32 < 2^246?
+        return false;
+    }
+
+    memcpy(temp, signature, 32);
+    memcpy(temp + 32, publicKey, 32);
+    memcpy(temp + 64, messageDigest, 32);
+
+    KangarooTwelve(temp, 32 + 64, h, 64);
+
+    ecc_mul_double_precomp((unsigned long long*)(signature + 32), (unsigned long long*)h, P, A);
+
+    encode(A, (unsigned char*)A);
+
+    return memcmp(A, signature, 32) == 0;
+}
+
 static bool verify(
     const unsigned char* publicKey,
     const unsigned char* messageDigest,
@@ -2921,7 +3310,7 @@ static bool verify(
   // Inputs: 32-byte PublicKey, 64-byte Signature, and MessageDigest of size 32 in bytes
   // Output: TRUE (valid signature) or FALSE (invalid signature)
     point_t A;
-    unsigned char temp[32 + 64], h[64];
+    point_double_precomp_t P;
 
     if ((publicKey[15] & 0x80) || (signature[15] & 0x80) || (signature[62] & 0xC0) || signature[63])
     { // Are bit128(PublicKey) = bit128(Signature) = 0 and Signature+32 < 2^246?
@@ -2933,18 +3322,276 @@ static bool verify(
         return false;
     }
 
-    memcpy(temp, signature, 32);
-    memcpy(temp + 32, publicKey, 32);
-    memcpy(temp + 64, messageDigest, 32);
+    if (!ecc_precomp_double_point(A, P))
+    {
+        return false;
+    }
 
-    KangarooTwelve(temp, 32 + 64, h, 64);
+    return verify_precomp(P, publicKey, messageDigest, signature);
+}
 
-    if (!ecc_mul_double((unsigned long long*)(signature + 32), (unsigned long long*)h, A))
+// Batch verification with a randomized linear combination. For random 128-bit z_i, a batch of
+// signatures (R_i, s_i) is accepted if
+//     392*[(sum z_i*s_i)*G + sum (z_i*h_i)*A_i - sum z_i*R_i] = 0,
+// which costs one multi-scalar multiplication instead of one double scalar multiplication per
+// signature. The equation is multiplied by the cofactor 392, so it only checks the prime-order
+// part: every signature accepted by verify() passes, but a signature whose s_i*G + h_i*A_i - R_i
+// is a nonzero point of small order also passes. Such signatures cannot be produced without the
+// private key, use verify() where agreement on every individual signature matters
+#define VERIFY_BATCH_CHUNK 128
+#define ECC_MSM_MAX_POINTS (2 * VERIFY_BATCH_CHUNK)
+#define ECC_MSM_MAX_WINDOWS (247 / 4 + 2)
+
+static void add_mod_order(
+    const unsigned long long* a,
+    const unsigned long long* b,
+    unsigned long long* c)
+{ // Addition modulo the curve order, c = a+b mod order, where a,b in [0, order-1]
+    unsigned long long t[4];
+
+    unsigned char carry = _addcarry_u64(0, a[0], b[0], &c[0]);
+    carry = _addcarry_u64(carry, a[1], b[1], &c[1]);
+    carry = _addcarry_u64(carry, a[2], b[2], &c[2]);
+    _addcarry_u64(carry, a[3], b[3], &c[3]);
+
+    unsigned char borrow = _subborrow_u64(0, c[0], CURVE_ORDER_0, &t[0]);
+    borrow = _subborrow_u64(borrow, c[1], CURVE_ORDER_1, &t[1]);
+    borrow = _subborrow_u64(borrow, c[2], CURVE_ORDER_2, &t[2]);
+    borrow = _subborrow_u64(borrow, c[3], CURVE_ORDER_3, &t[3]);
+    if (!borrow)
     {
-        return false;
+        memcpy(c, t, 32);
     }
+}
 
-    encode(A, (unsigned char*)A);
+static void point_precomp_setup(point_t P, point_precomp_t Q)
+{ // Point conversion to representation (x+y,y-x,2dt)
+    fp2add1271(P->x, P->y, Q->xy);                   // x+y
+    fp2sub1271(P->y, P->x, Q->yx);                   // y-x
+    fp2mul1271(P->x, P->y, Q->t2);                   // t = x*y
+    fp2add1271(Q->t2, Q->t2, Q->t2);                 // 2t
+    fp2mul1271(Q->t2, (felm_t*)&PARAMETER_d, Q->t2); // 2dt
+}
 
-    return memcmp(A, signature, 32) == 0;
+static void eccneutral(point_extproj_t P)
+{ // P = (0:1:1), the neutral point, with Ta = 0 and Tb = 1
+    memset(P, 0, sizeof(point_extproj));
+    P->y[0][0] = 1;
+    P->z[0][0] = 1;
+    P->tb[0][0] = 1;
+}
+
+static void ecc_msm_recode(const unsigned long long* k, unsigned int c, signed char* digits)
+{ // Recoding of a scalar k < 2^247 into 247/c+2 signed digits in [-2^(c-1), 2^(c-1)], c <= 7
+    const unsigned int count = 247 / c + 2;
+    const int mask = (1 << c) - 1;
+    int carry = 0;
+
+    for (unsigned int i = 0; i < count; i++)
+    {
+        const unsigned int bit = c * i;
+        unsigned long long window = 0;
+        if (bit < 256)
+        {
+            window = k[bit >> 6] >> (bit & 63);
+            if ((bit & 63) + c > 64 && (bit >> 6) < 3)
+            {
+                window |= k[(bit >> 6) + 1] << (64 - (bit & 63));
+            }
+        }
+
+        const int digit = (int)(window & mask) + carry;
+        carry = digit > (1 << (c - 1));
+        digits[i] = (signed char)(digit - (carry << c));
+    }
+}
+
+static void ecc_msm(
+    point_precomp_t* points,
+    const unsigned long long (*scalars)[4],
+    unsigned int count,
+    point_extproj_t R)
+{ // Multi-scalar multiplication R = sum scalars[i]*points[i] with Pippenger's bucket method, for
+  // up to ECC_MSM_MAX_POINTS affine points and scalars below 2^247. Runs in variable time, only
+  // use it on public data
+    const unsigned int c = count < 32 ? 4 : count < 128 ? 5 : count < 384 ? 6 : 7;
+    const unsigned int windowCount = 247 / c + 2;
+    signed char digits[ECC_MSM_MAX_POINTS][ECC_MSM_MAX_WINDOWS];
+    point_extproj_t buckets[64], running, sum;
+    bool bucketUsed[64];
+    point_extproj_precomp_t Q;
+    point_precomp_t S;
+
+    for (unsigned int i = 0; i < count; i++)
+    {
+        ecc_msm_recode(scalars[i], c, digits[i]);
+    }
+
+    eccneutral(R);
+    for (unsigned int window = windowCount; window--;)
+    {
+        for (unsigned int i = 0; i < c && window != windowCount - 1; i++)
+        {
+            eccdouble(R);
+        }
+
+        memset(bucketUsed, 0, sizeof(bucketUsed));
+        for (unsigned int i = 0; i < count; i++)
+        {
+            const int digit = digits[i][window];
+            if (!digit)
+            {
+                continue;
+            }
+
+            if (digit < 0)
+            {
+                memcpy(S->xy, points[i]->yx, 32);
+                memcpy(S->yx, points[i]->xy, 32);
+                memcpy(S->t2, points[i]->t2, 32);
+                fp2neg1271(S->t2);
+            }
+            else
+            {
+                memcpy(S, points[i], sizeof(point_precomp));
+            }
+
+            const unsigned int bucket = (unsigned int)(digit < 0 ? -digit : digit) - 1;
+            if (bucketUsed[bucket])
+            {
+                eccmadd(S, buckets[bucket]);
+                continue;
+            }
+
+            // Conversion from representation (x+y,y-x,2dt) to (X,Y,Z,Ta,Tb)
+            fp2sub1271(S->xy, S->yx, buckets[bucket]->x); // 2*x1
+            fp2add1271(S->xy, S->yx, buckets[bucket]->y); // 2*y1
+            fp2div1271(buckets[bucket]->x);               // X = x1
+            fp2div1271(buckets[bucket]->y);               // Y = y1
+            memset(buckets[bucket]->z, 0, 32);
+            buckets[bucket]->z[0][0] = 1;                           // Z = 1
+            memcpy(&buckets[bucket]->ta, &buckets[bucket]->x, 32); // Ta = x1
+            memcpy(&buckets[bucket]->tb, &buckets[bucket]->y, 32); // Tb = y1
+            bucketUsed[bucket] = true;
+        }
+
+        // sum = sum_b (b+1)*buckets[b], accumulated from the largest bucket down
+        bool runningUsed = false, sumUsed = false;
+        for (unsigned int bucket = 1u << (c - 1); bucket--;)
+        {
+            if (bucketUsed[bucket])
+            {
+                if (runningUsed)
+                {
+                    R1_to_R2(buckets[bucket], Q);
+                    eccadd(Q, running);
+                }
+                else
+                {
+                    memcpy(running, buckets[bucket], sizeof(point_extproj));
+                    runningUsed = true;
+                }
+            }
+            if (runningUsed)
+            {
+                if (sumUsed)
+                {
+                    R1_to_R2(running, Q);
+                    eccadd(Q, sum);
+                }
+                else
+                {
+                    memcpy(sum, running, sizeof(point_extproj));
+                    sumUsed = true;
+                }
+            }
+        }
+        if (sumUsed)
+        {
+            R1_to_R2(sum, Q);
+            eccadd(Q, R);
+        }
+    }
+}
+
+static bool verify_batch_chunk(
+    const unsigned char* publicKeys,
+    const unsigned char* messageDigests,
+    const unsigned char* signatures,
+    unsigned int count)
+{ // Randomized linear combination check of up to VERIFY_BATCH_CHUNK signatures, returns false if
+  // any signature is invalid and (with overwhelming probability) true if all are valid
+    point_precomp_t points[2 * VERIFY_BATCH_CHUNK];
+    unsigned long long scalars[2 * VERIFY_BATCH_CHUNK][4];
+    unsigned long long sum[4] = {0, 0, 0, 0}, z[4], h[8], term[4];
+    unsigned char temp[32 + 64], encoded[32];
+    point_extproj_t R;
+    point_t P;
+
+    for (unsigned int i = 0; i < count; i++)
+    {
+        const unsigned char* publicKey = publicKeys + 32 * i;
+        const unsigned char* signature = signatures + 64 * i;
+
+        if ((publicKey[15] & 0x80) || (signature[15] & 0x80) || (signature[62] & 0xC0) ||
+            signature[63])
+        {
+            return false;
+        }
+
+        // A_i
+        if (!decode(publicKey, P))
+        {
+            return false;
+        }
+        point_precomp_setup(P, points[2 * i]);
+
+        // -R_i, which must be a canonical encoding to match the byte comparison of verify()
+        if (!decode(signature, P))
+        {
+            return false;
+        }
+        encode(P, encoded);
+        if (memcmp(encoded, signature, 32) != 0)
+        {
+            return false;
+        }
+        fp2neg1271(P->x);
+        point_precomp_setup(P, points[2 * i + 1]);
+
+        memcpy(temp, signature, 32);
+        memcpy(temp + 32, publicKey, 32);
+        memcpy(temp + 64, messageDigests + 32 * i, 32);
+        KangarooTwelve(temp, 32 + 64, (unsigned char*)h, 64);
+
+        // z_i is a random 128-bit value, its Montgomery representation gives z_i*x mod order
+        while (!_rdrand64_step(&z[0]) || !_rdrand64_step(&z[1]))
+        {
+        }
+        z[2] = z[3] = 0;
+        memcpy(scalars[2 * i + 1], z, 32);
+        Montgomery_multiply_mod_order(z, Montgomery_Rprime, z);
+
+        Montgomery_multiply_mod_order(h, z, scalars[2 * i]); // z_i*h_i
+        memcpy(term, signature + 32, 32);
+        Montgomery_multiply_mod_order(term, z, term); // z_i*s_i
+        add_mod_order(sum, term, sum);
+    }
+
+    ecc_msm(points, scalars, 2 * count, R);
+
+    // R = R + (sum z_i*s_i)*G
+    point_extproj_t S;
+    point_extproj_precomp_t Q;
+    ecc_mul_fixed(sum, P);
+    point_setup(P, S);
+    R1_to_R2(S, Q);
+    eccadd(Q, R);
+
+    cofactor_clearing(R);
+    eccnorm(R, P);
+
+    return !(P->x[0][0] | P->x[0][1] | P->x[1][0] | P->x[1][1] | P->y[0][1] | P->y[1][0] |
+             P->y[1][1]) &&
+           P->y[0][0] == 1;
 }
@@ -0,0 +1,790 @@
+#pragma once
+
+#include "four_q.h"
+
+// FourQ 4-way point arithmetic (AVX-512 IFMA)
+//
+// Four independent points are processed in parallel, one per 64-bit lane of a 256-bit vector.
+// Field elements use radix 2^52 and are stored lane-interleaved (structure-of-arrays): limb i of
+// all four lanes lives in one vector. A normalized element has limbs [0] and [1] below 2^52 and
+// limb [2] at most 2^23 + 1, so every limb is a valid input to VPMADD52LUQ/VPMADD52HUQ.
+// The operations below mirror the scalar ones in four_q.h and produce the same points.
+
+#ifdef _MSC_VER
+#define FOURQ_TARGET_IFMA
+#else
+#define FOURQ_TARGET_IFMA __attribute__((target("avx512f,avx512vl,avx512ifma")))
+#endif
+
+#define RADIX52_MASK 0xFFFFFFFFFFFFF
+#define RADIX52_TOP_MASK 0x7FFFFF // Limb [2] holds bits 104..126
+
+typedef __m256i felm_x4_t[3];    // Four GF(2^127-1) elements in radix 2^52
+typedef felm_x4_t f2elm_x4_t[2]; // Four GF((2^127-1)^2) elements
+
+typedef struct
+{ // Four points in extended projective coordinates (X,Y,Z,Ta,Tb)
+    f2elm_x4_t x;
+    f2elm_x4_t y;
+    f2elm_x4_t z;
+    f2elm_x4_t ta;
+    f2elm_x4_t tb;
+} point_extproj_x4;
+typedef point_extproj_x4 point_extproj_x4_t[1];
+
+typedef struct
+{ // Four points in representation (X+Y,Y-X,2Z,2dT)
+    f2elm_x4_t xy;
+    f2elm_x4_t yx;
+    f2elm_x4_t z2;
+    f2elm_x4_t t2;
+} point_extproj_precomp_x4;
+typedef point_extproj_precomp_x4 point_extproj_precomp_x4_t[1];
+
+typedef struct
+{ // Four points in representation (x+y,y-x,2dt)
+    f2elm_x4_t xy;
+    f2elm_x4_t yx;
+    f2elm_x4_t t2;
+} point_precomp_x4;
+typedef point_precomp_x4 point_precomp_x4_t[1];
+
+static bool isIfmaSupported()
+{ // CPUID.(EAX=07H,ECX=0H):EBX reports AVX512F in bit 16, AVX512IFMA in bit 21 and AVX512VL in
+  // bit 31. The OS must also save the opmask and ZMM state, XCR0 bits 1, 2, 5, 6 and 7
+    unsigned int ecx1 = 0, ebx7 = 0;
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+    {
+        return false;
+    }
+    __cpuid(info, 1);
+    ecx1 = (unsigned int)info[2];
+    __cpuidex(info, 7, 0);
+    ebx7 = (unsigned int)info[1];
+#else
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx1, &edx) ||
+        !__get_cpuid_count(7, 0, &eax, &ebx7, &ecx, &edx))
+    {
+        return false;
+    }
+#endif
+    if (!(ecx1 & (1 << 27))) // OSXSAVE
+    {
+        return false;
+    }
+    if (!(ebx7 & (1 << 16)) || !(ebx7 & (1 << 21)) || !(ebx7 & (1u << 31)))
+    {
+        return false;
+    }
+
+#ifdef _MSC_VER
+    const unsigned long long xcr0 = _xgetbv(0);
+#else
+    unsigned int xcr0Low, xcr0High;
+    __asm__ volatile("xgetbv" : "=a"(xcr0Low), "=d"(xcr0High) : "c"(0));
+    const unsigned long long xcr0 = ((unsigned long long)xcr0High << 32) | xcr0Low;
+#endif
+    return (xcr0 & 0xE6) == 0xE6;
+}
+
+#if defined(__AVX512F__) && defined(__AVX512VL__) && defined(__AVX512IFMA__)
+static const bool useIfmaPointArithmetic = true;
+#else
+static const bool useIfmaPointArithmetic = isIfmaSupported();
+#endif
+
+FOURQ_TARGET_IFMA static inline void fpnorm1271_x4(
+    __m256i r0,
+    __m256i r1,
+    __m256i r2,
+    felm_x4_t c)
+{ // Carry propagation and folding of 2^127 = 1, inputs up to 2^62 per limb
+    const __m256i mask = _mm256_set1_epi64x(RADIX52_MASK);
+    const __m256i topMask = _mm256_set1_epi64x(RADIX52_TOP_MASK);
+
+    r1 = _mm256_add_epi64(r1, _mm256_srli_epi64(r0, 52));
+    r0 = _mm256_and_si256(r0, mask);
+    r2 = _mm256_add_epi64(r2, _mm256_srli_epi64(r1, 52));
+    r1 = _mm256_and_si256(r1, mask);
+    r0 = _mm256_add_epi64(r0, _mm256_srli_epi64(r2, 23));
+    r2 = _mm256_and_si256(r2, topMask);
+    r1 = _mm256_add_epi64(r1, _mm256_srli_epi64(r0, 52));
+    r0 = _mm256_and_si256(r0, mask);
+    r2 = _mm256_add_epi64(r2, _mm256_srli_epi64(r1, 52));
+    r1 = _mm256_and_si256(r1, mask);
+
+    c[0] = r0;
+    c[1] = r1;
+    c[2] = r2;
+}
+
+FOURQ_TARGET_IFMA static inline void fpreduce1271_x4(
+    __m256i z0,
+    __m256i z1,
+    __m256i z2,
+    __m256i z3,
+    __m256i z4,
+    felm_x4_t c)
+{ // Reduction of a 5-limb product using 2^156 = 2^29 and 2^208 = 2^81 (mod 2^127-1)
+    const __m256i mask = _mm256_set1_epi64x(RADIX52_MASK);
+    const __m256i topMask = _mm256_set1_epi64x(RADIX52_TOP_MASK);
+
+    z1 = _mm256_add_epi64(z1, _mm256_srli_epi64(z0, 52));
+    z0 = _mm256_and_si256(z0, mask);
+    z2 = _mm256_add_epi64(z2, _mm256_srli_epi64(z1, 52));
+    z1 = _mm256_and_si256(z1, mask);
+    z3 = _mm256_add_epi64(z3, _mm256_srli_epi64(z2, 52));
+    z2 = _mm256_and_si256(z2, mask);
+    z4 = _mm256_add_epi64(z4, _mm256_srli_epi64(z3, 52));
+    z3 = _mm256_and_si256(z3, mask);
+
+    fpnorm1271_x4(
+        _mm256_add_epi64(z0, _mm256_slli_epi64(_mm256_and_si256(z3, topMask), 29)),
+        _mm256_add_epi64(
+            _mm256_add_epi64(z1, _mm256_srli_epi64(z3, 23)),
+            _mm256_slli_epi64(_mm256_and_si256(z4, topMask), 29)),
+        _mm256_add_epi64(z2, _mm256_srli_epi64(z4, 23)),
+        c);
+}
+
+FOURQ_TARGET_IFMA static inline void fpadd1271_x4(felm_x4_t a, felm_x4_t b, felm_x4_t c)
+{ // Field addition, c = a+b mod (2^127-1)
+    fpnorm1271_x4(
+        _mm256_add_epi64(a[0], b[0]),
+        _mm256_add_epi64(a[1], b[1]),
+        _mm256_add_epi64(a[2], b[2]),
+        c);
+}
+
+FOURQ_TARGET_IFMA static inline void fpsub1271_x4(felm_x4_t a, felm_x4_t b, felm_x4_t c)
+{ // Field subtraction, c = a-b mod (2^127-1). Adds 4p = (2^53-4, 2^53-2, 2^25-2) to stay positive
+    fpnorm1271_x4(
+        _mm256_sub_epi64(_mm256_add_epi64(a[0], _mm256_set1_epi64x(0x1FFFFFFFFFFFFC)), b[0]),
+        _mm256_sub_epi64(_mm256_add_epi64(a[1], _mm256_set1_epi64x(0x1FFFFFFFFFFFFE)), b[1]),
+        _mm256_sub_epi64(_mm256_add_epi64(a[2], _mm256_set1_epi64x(0x1FFFFFE)), b[2]),
+        c);
+}
+
+FOURQ_TARGET_IFMA static inline void fpneg1271_x4(felm_x4_t a)
+{ // Field negation, a = -a mod (2^127-1)
+    fpnorm1271_x4(
+        _mm256_sub_epi64(_mm256_set1_epi64x(0x1FFFFFFFFFFFFC), a[0]),
+        _mm256_sub_epi64(_mm256_set1_epi64x(0x1FFFFFFFFFFFFE), a[1]),
+        _mm256_sub_epi64(_mm256_set1_epi64x(0x1FFFFFE), a[2]),
+        a);
+}
+
+FOURQ_TARGET_IFMA static void fpmul1271_x4(felm_x4_t a, felm_x4_t b, felm_x4_t c)
+{ // Field multiplication, c = a*b mod (2^127-1). a[2]*b[2] < 2^52, so there is no sixth limb
+    const __m256i zero = _mm256_setzero_si256();
+
+    const __m256i z0 = _mm256_madd52lo_epu64(zero, a[0], b[0]);
+
+    __m256i z1 = _mm256_madd52hi_epu64(zero, a[0], b[0]);
+    z1 = _mm256_madd52lo_epu64(z1, a[0], b[1]);
+    z1 = _mm256_madd52lo_epu64(z1, a[1], b[0]);
+
+    __m256i z2 = _mm256_madd52hi_epu64(zero, a[0], b[1]);
+    z2 = _mm256_madd52hi_epu64(z2, a[1], b[0]);
+    z2 = _mm256_madd52lo_epu64(z2, a[0], b[2]);
+    z2 = _mm256_madd52lo_epu64(z2, a[1], b[1]);
+    z2 = _mm256_madd52lo_epu64(z2, a[2], b[0]);
+
+    __m256i z3 = _mm256_madd52hi_epu64(zero, a[0], b[2]);
+    z3 = _mm256_madd52hi_epu64(z3, a[1], b[1]);
+    z3 = _mm256_madd52hi_epu64(z3, a[2], b[0]);
+    z3 = _mm256_madd52lo_epu64(z3, a[1], b[2]);
+    z3 = _mm256_madd52lo_epu64(z3, a[2], b[1]);
+
+    __m256i z4 = _mm256_madd52hi_epu64(zero, a[1], b[2]);
+    z4 = _mm256_madd52hi_epu64(z4, a[2], b[1]);
+    z4 = _mm256_madd52lo_epu64(z4, a[2], b[2]);
+
+    fpreduce1271_x4(z0, z1, z2, z3, z4, c);
+}
+
+FOURQ_TARGET_IFMA static inline void fp2add1271_x4(f2elm_x4_t a, f2elm_x4_t b, f2elm_x4_t c)
+{ // GF(p^2) addition, c = a+b in GF((2^127-1)^2)
+    fpadd1271_x4(a[0], b[0], c[0]);
+    fpadd1271_x4(a[1], b[1], c[1]);
+}
+
+FOURQ_TARGET_IFMA static inline void fp2sub1271_x4(f2elm_x4_t a, f2elm_x4_t b, f2elm_x4_t c)
+{ // GF(p^2) subtraction, c = a-b in GF((2^127-1)^2)
+    fpsub1271_x4(a[0], b[0], c[0]);
+    fpsub1271_x4(a[1], b[1], c[1]);
+}
+
+FOURQ_TARGET_IFMA static inline void fp2neg1271_x4(f2elm_x4_t a)
+{ // GF(p^2) negation, a = -a in GF((2^127-1)^2)
+    fpneg1271_x4(a[0]);
+    fpneg1271_x4(a[1]);
+}
+
+FOURQ_TARGET_IFMA static inline void fp2addsub1271_x4(f2elm_x4_t a, f2elm_x4_t b, f2elm_x4_t c)
+{ // GF(p^2) addition followed by subtraction, c = 2a-b in GF((2^127-1)^2)
+    fp2add1271_x4(a, a, a);
+    fp2sub1271_x4(a, b, c);
+}
+
+FOURQ_TARGET_IFMA static void fp2mul1271_x4(f2elm_x4_t a, f2elm_x4_t b, f2elm_x4_t c)
+{ // GF(p^2) multiplication, c = a*b in GF((2^127-1)^2)
+    felm_x4_t t1, t2, t3, t4;
+
+    fpmul1271_x4(a[0], b[0], t1); // t1 = a0*b0
+    fpmul1271_x4(a[1], b[1], t2); // t2 = a1*b1
+    fpadd1271_x4(a[0], a[1], t3); // t3 = a0+a1
+    fpadd1271_x4(b[0], b[1], t4); // t4 = b0+b1
+    fpsub1271_x4(t1, t2, c[0]);   // c[0] = a0*b0 - a1*b1
+    fpmul1271_x4(t3, t4, t3);     // t3 = (a0+a1)*(b0+b1)
+    fpsub1271_x4(t3, t1, t3);     // t3 = (a0+a1)*(b0+b1) - a0*b0
+    fpsub1271_x4(t3, t2, c[1]);   // c[1] = (a0+a1)*(b0+b1) - a0*b0 - a1*b1
+}
+
+FOURQ_TARGET_IFMA static void fp2sqr1271_x4(f2elm_x4_t a, f2elm_x4_t c)
+{ // GF(p^2) squaring, c = a^2 in GF((2^127-1)^2)
+    felm_x4_t t1, t2, t3;
+
+    fpadd1271_x4(a[0], a[1], t1); // t1 = a0+a1
+    fpsub1271_x4(a[0], a[1], t2); // t2 = a0-a1
+    fpmul1271_x4(a[0], a[1], t3); // t3 = a0*a1
+    fpmul1271_x4(t1, t2, c[0]);   // c0 = (a0+a1)(a0-a1)
+    fpadd1271_x4(t3, t3, c[1]);   // c1 = 2a0*a1
+}
+
+FOURQ_TARGET_IFMA static void fp2pack_x4(
+    f2elm_t a0,
+    f2elm_t a1,
+    f2elm_t a2,
+    f2elm_t a3,
+    f2elm_x4_t c)
+{ // Conversion of four GF(p^2) elements to radix 2^52, lane-interleaved
+    felm_t* const a[4] = {a0, a1, a2, a3};
+    alignas(32) unsigned long long limbs[2][3][4];
+
+    for (unsigned int lane = 0; lane < 4; lane++)
+    {
+        for (unsigned int i = 0; i < 2; i++)
+        {
+            limbs[i][0][lane] = a[lane][i][0] & RADIX52_MASK;
+            limbs[i][1][lane] = ((a[lane][i][0] >> 52) | (a[lane][i][1] << 12)) & RADIX52_MASK;
+            limbs[i][2][lane] = a[lane][i][1] >> 40;
+        }
+    }
+    for (unsigned int i = 0; i < 2; i++)
+    {
+        for (unsigned int j = 0; j < 3; j++)
+        {
+            c[i][j] = _mm256_load_si256((const __m256i*)limbs[i][j]);
+        }
+    }
+}
+
+FOURQ_TARGET_IFMA static void fp2unpack_x4(
+    f2elm_x4_t a,
+    f2elm_t c0,
+    f2elm_t c1,
+    f2elm_t c2,
+    f2elm_t c3)
+{ // Conversion of four GF(p^2) elements from radix 2^52 to the representation used in four_q.h.
+  // The result is reduced below 2^127 but not necessarily below p
+    felm_t* const c[4] = {c0, c1, c2, c3};
+    alignas(32) unsigned long long limbs[2][3][4];
+
+    for (unsigned int i = 0; i < 2; i++)
+    {
+        for (unsigned int j = 0; j < 3; j++)
+        {
+            _mm256_store_si256((__m256i*)limbs[i][j], a[i][j]);
+        }
+    }
+    for (unsigned int lane = 0; lane < 4; lane++)
+    {
+        for (unsigned int i = 0; i < 2; i++)
+        {
+            const unsigned long long low = limbs[i][0][lane] | (limbs[i][1][lane] << 52);
+            const unsigned long long high = (limbs[i][1][lane] >> 12) | (limbs[i][2][lane] << 40);
+            _addcarry_u64(
+                _addcarry_u64(0, low, high >> 63, &c[lane][i][0]),
+                high & 0x7FFFFFFFFFFFFFFF,
+                0,
+                &c[lane][i][1]);
+        }
+    }
+}
+
+FOURQ_TARGET_IFMA static void point_extproj_pack_x4(point_extproj_t P[4], point_extproj_x4_t Q)
+{ // Gathering of four extended projective points into one 4-way point
+    fp2pack_x4(P[0]->x, P[1]->x, P[2]->x, P[3]->x, Q->x);
+    fp2pack_x4(P[0]->y, P[1]->y, P[2]->y, P[3]->y, Q->y);
+    fp2pack_x4(P[0]->z, P[1]->z, P[2]->z, P[3]->z, Q->z);
+    fp2pack_x4(P[0]->ta, P[1]->ta, P[2]->ta, P[3]->ta, Q->ta);
+    fp2pack_x4(P[0]->tb, P[1]->tb, P[2]->tb, P[3]->tb, Q->tb);
+}
+
+FOURQ_TARGET_IFMA static void point_precomp_pack_x4(point_precomp_t P[4], point_precomp_x4_t Q)
+{ // Gathering of four points (x+y,y-x,2dt) into one 4-way point
+    fp2pack_x4(P[0]->xy, P[1]->xy, P[2]->xy, P[3]->xy, Q->xy);
+    fp2pack_x4(P[0]->yx, P[1]->yx, P[2]->yx, P[3]->yx, Q->yx);
+    fp2pack_x4(P[0]->t2, P[1]->t2, P[2]->t2, P[3]->t2, Q->t2);
+}
+
+FOURQ_TARGET_IFMA static void point_extproj_unpack_x4(point_extproj_x4_t P, point_extproj_t Q[4])
+{ // Scattering of the (X:Y:Z) coordinates of a 4-way point, as needed by eccnorm()
+    fp2unpack_x4(P->x, Q[0]->x, Q[1]->x, Q[2]->x, Q[3]->x);
+    fp2unpack_x4(P->y, Q[0]->y, Q[1]->y, Q[2]->y, Q[3]->y);
+    fp2unpack_x4(P->z, Q[0]->z, Q[1]->z, Q[2]->z, Q[3]->z);
+}
+
+FOURQ_TARGET_IFMA static void R1_to_R2_x4(point_extproj_x4_t P, point_extproj_precomp_x4_t Q)
+{ // Conversion from representation (X,Y,Z,Ta,Tb) to (X+Y,Y-X,2Z,2dT), where T = Ta*Tb
+    felm_t* const parameterD = (felm_t*)&PARAMETER_d;
+    f2elm_x4_t d;
+
+    fp2pack_x4(parameterD, parameterD, parameterD, parameterD, d);
+
+    fp2add1271_x4(P->ta, P->ta, Q->t2); // T = 2*Ta
+    fp2add1271_x4(P->x, P->y, Q->xy);   // QX = X+Y
+    fp2sub1271_x4(P->y, P->x, Q->yx);   // QY = Y-X
+    fp2mul1271_x4(Q->t2, P->tb, Q->t2); // T = 2*T
+    fp2add1271_x4(P->z, P->z, Q->z2);   // QZ = 2*Z
+    fp2mul1271_x4(Q->t2, d, Q->t2);     // QT = 2d*T
+}
+
+FOURQ_TARGET_IFMA static void R1_to_R3_x4(point_extproj_x4_t P, point_extproj_precomp_x4_t Q)
+{ // Conversion from representation (X,Y,Z,Ta,Tb) to (X+Y,Y-X,Z,T), where T = Ta*Tb
+    fp2add1271_x4(P->x, P->y, Q->xy);   // XQ = (X1+Y1)
+    fp2sub1271_x4(P->y, P->x, Q->yx);   // YQ = (Y1-X1)
+    fp2mul1271_x4(P->ta, P->tb, Q->t2); // TQ = T1
+    memcpy(&Q->z2, &P->z, sizeof(f2elm_x4_t)); // ZQ = Z1
+}
+
+FOURQ_TARGET_IFMA static void eccdouble_x4(point_extproj_x4_t P)
+{ // Point doubling 2P
+    f2elm_x4_t t1, t2;
+
+    fp2sqr1271_x4(P->x, t1);            // t1 = X1^2
+    fp2sqr1271_x4(P->y, t2);            // t2 = Y1^2
+    fp2add1271_x4(P->x, P->y, P->x);    // t3 = X1+Y1
+    fp2add1271_x4(t1, t2, P->tb);       // Tbfinal = X1^2+Y1^2
+    fp2sub1271_x4(t2, t1, t1);          // t1 = Y1^2-X1^2
+    fp2sqr1271_x4(P->x, P->ta);         // Ta = (X1+Y1)^2
+    fp2sqr1271_x4(P->z, t2);            // t2 = Z1^2
+    fp2sub1271_x4(P->ta, P->tb, P->ta); // Tafinal = 2X1*Y1 = (X1+Y1)^2-(X1^2+Y1^2)
+    fp2addsub1271_x4(t2, t1, t2);       // t2 = 2Z1^2-(Y1^2-X1^2)
+    fp2mul1271_x4(t1, P->tb, P->y);     // Yfinal = (X1^2+Y1^2)(Y1^2-X1^2)
+    fp2mul1271_x4(t2, P->ta, P->x);     // Xfinal = 2X1*Y1*[2Z1^2-(Y1^2-X1^2)]
+    fp2mul1271_x4(t1, t2, P->z);        // Zfinal = (Y1^2-X1^2)[2Z1^2-(Y1^2-X1^2)]
+}
+
+FOURQ_TARGET_IFMA static void eccadd_core_x4(
+    point_extproj_precomp_x4_t P,
+    point_extproj_precomp_x4_t Q,
+    point_extproj_x4_t R)
+{ // Basic point addition R = P+Q or R = P+P
+    f2elm_x4_t t1, t2;
+
+    fp2mul1271_x4(P->t2, Q->t2, R->z); // Z = 2dT1*T2
+    fp2mul1271_x4(P->z2, Q->z2, t1);   // t1 = 2Z1*Z2
+    fp2mul1271_x4(P->xy, Q->xy, R->x); // X = (X1+Y1)(X2+Y2)
+    fp2mul1271_x4(P->yx, Q->yx, R->y); // Y = (Y1-X1)(Y2-X2)
+    fp2sub1271_x4(t1, R->z, t2);       // t2 = theta
+    fp2add1271_x4(t1, R->z, t1);       // t1 = alpha
+    fp2sub1271_x4(R->x, R->y, R->tb);  // Tbfinal = beta
+    fp2add1271_x4(R->x, R->y, R->ta);  // Tafinal = omega
+    fp2mul1271_x4(R->tb, t2, R->x);    // Xfinal = beta*theta
+    fp2mul1271_x4(t1, t2, R->z);       // Zfinal = theta*alpha
+    fp2mul1271_x4(R->ta, t1, R->y);    // Yfinal = alpha*omega
+}
+
+FOURQ_TARGET_IFMA static void eccadd_x4(point_extproj_precomp_x4_t Q, point_extproj_x4_t P)
+{ // Complete point addition P = P+Q or P = P+P
+    point_extproj_precomp_x4_t R;
+
+    R1_to_R3_x4(P, R);       // R = (X1+Y1,Y1-Z1,Z1,T1)
+    eccadd_core_x4(Q, R, P); // P = (X2+Y2,Y2-X2,2Z2,2dT2) + (X1+Y1,Y1-Z1,Z1,T1)
+}
+
+FOURQ_TARGET_IFMA static void eccmadd_x4(point_precomp_x4_t Q, point_extproj_x4_t P)
+{ // Mixed point addition P = P+Q or P = P+P
+    f2elm_x4_t t1, t2;
+
+    fp2mul1271_x4(P->ta, P->tb, P->ta); // Ta = T1
+    fp2add1271_x4(P->z, P->z, t1);      // t1 = 2Z1
+    fp2mul1271_x4(P->ta, Q->t2, P->ta); // Ta = 2dT1*t2
+    fp2add1271_x4(P->x, P->y, P->z);    // Z = (X1+Y1)
+    fp2sub1271_x4(P->y, P->x, P->tb);   // Tb = (Y1-X1)
+    fp2sub1271_x4(t1, P->ta, t2);       // t2 = theta
+    fp2add1271_x4(t1, P->ta, t1);       // t1 = alpha
+    fp2mul1271_x4(Q->xy, P->z, P->ta);  // Ta = (X1+Y1)(x2+y2)
+    fp2mul1271_x4(Q->yx, P->tb, P->x);  // X = (Y1-X1)(y2-x2)
+    fp2mul1271_x4(t1, t2, P->z);        // Zfinal = theta*alpha
+    fp2sub1271_x4(P->ta, P->x, P->tb);  // Tbfinal = beta
+    fp2add1271_x4(P->ta, P->x, P->ta);  // Tafinal = omega
+    fp2mul1271_x4(P->tb, t2, P->x);     // Xfinal = beta*theta
+    fp2mul1271_x4(P->ta, t1, P->y);     // Yfinal = alpha*omega
+}
+
+FOURQ_TARGET_IFMA static void ecc_mul_fixed_x4(unsigned long long* k, point_extproj_x4_t R)
+{ // Fixed-base scalar multiplication R = k*G for four scalars of 4 words each, using the same comb
+  // and FIXED_BASE_TABLE as ecc_mul_fixed(). The result is left in projective coordinates
+    unsigned int digits[4][250];
+    point_precomp_t S[4];
+    point_extproj_t T[4];
+    point_precomp_x4_t S4;
+
+    for (unsigned int lane = 0; lane < 4; lane++)
+    {
+        ecc_mul_fixed_recode(k + 4 * lane, digits[lane]);
+
+        table_lookup_fixed_base(S[lane], ecc_mul_fixed_index(digits[lane], 4, 9), 0);
+        // Conversion from representation (x+y,y-x,2dt) to (X,Y,Z,Ta,Tb)
+        fp2sub1271(S[lane]->xy, S[lane]->yx, T[lane]->x); // 2*x1
+        fp2add1271(S[lane]->xy, S[lane]->yx, T[lane]->y); // 2*y1
+        fp2div1271(T[lane]->x);                           // XQ = x1
+        fp2div1271(T[lane]->y);                           // YQ = y1
+        T[lane]->z[0][0] = 1;
+        T[lane]->z[0][1] = 0;
+        T[lane]->z[1][0] = 0;
+        T[lane]->z[1][1] = 0;                      // ZQ = 1
+        memcpy(&T[lane]->ta, &T[lane]->x, 32);     // TaQ = x1
+        memcpy(&T[lane]->tb, &T[lane]->y, 32);     // TbQ = y1
+    }
+    point_extproj_pack_x4(T, R);
+
+    for (unsigned int column = 10; column--;)
+    {
+        if (column != 9)
+        {
+            eccdouble_x4(R);
+        }
+        for (unsigned int v = (column == 9 ? 4 : 5); v--;)
+        {
+            for (unsigned int lane = 0; lane < 4; lane++)
+            {
+                table_lookup_fixed_base(
+                    S[lane],
+                    ecc_mul_fixed_index(digits[lane], v, column),
+                    digits[lane][10 * v + column]);
+            }
+            point_precomp_pack_x4(S, S4);
+            eccmadd_x4(S4, R);
+        }
+    }
+}
+
+FOURQ_TARGET_IFMA static void ecc_mul_x4(point_t P[4], unsigned long long* k, point_extproj_x4_t R)
+{ // Variable-base scalar multiplication R = k*P for four points and four scalars of 4 words each,
+  // using the decomposition and recoding of ecc_mul(). The points must already be validated, there
+  // is no cofactor clearing and the result is left in projective coordinates.
+  // The signed tables of all lanes are stored in radix 2^52, 24 limbs per entry, and gathered
+    alignas(32) unsigned long long table[4][16][24];
+    unsigned int digits[4][64], signMasks[4][64];
+    point_extproj_t T[4];
+
+    for (unsigned int lane = 0; lane < 4; lane++)
+    {
+        point_extproj_precomp_t Table[2][8];
+        unsigned long long scalars[4];
+
+        point_setup(P[lane], T[lane]);
+        decompose(k + 4 * lane, scalars);
+        ecc_mul_recode(scalars, digits[lane], signMasks[lane]);
+
+        ecc_precomp(T[lane], Table[1]);
+        for (unsigned int i = 0; i < 8; i++)
+        {
+            memcpy(Table[0][i]->xy, Table[1][i]->yx, 32);
+            memcpy(Table[0][i]->yx, Table[1][i]->xy, 32);
+            memcpy(Table[0][i]->t2, Table[1][i]->t2, 32);
+            memcpy(Table[0][i]->z2, Table[1][i]->z2, 32);
+            fp2neg1271(Table[0][i]->t2);
+        }
+        R2_to_R4(Table[1][scalars[1] + (scalars[2] << 1) + (scalars[3] << 2)], T[lane]);
+
+        for (unsigned int entry = 0; entry < 16; entry++)
+        {
+            felm_t* coordinates[4] = {
+                Table[entry >> 3][entry & 7]->xy,
+                Table[entry >> 3][entry & 7]->yx,
+                Table[entry >> 3][entry & 7]->z2,
+                Table[entry >> 3][entry & 7]->t2};
+            unsigned long long* limbs = table[lane][entry];
+            for (unsigned int i = 0; i < 8; i++, limbs += 3)
+            {
+                const felm_t& a = coordinates[i >> 1][i & 1];
+                limbs[0] = a[0] & RADIX52_MASK;
+                limbs[1] = ((a[0] >> 52) | (a[1] << 12)) & RADIX52_MASK;
+                limbs[2] = a[1] >> 40;
+            }
+        }
+    }
+    // R2_to_R4() only sets (X:Y:Z), which is all eccdouble() reads
+    for (unsigned int lane = 0; lane < 4; lane++)
+    {
+        memset(&T[lane]->ta, 0, 64);
+    }
+    point_extproj_pack_x4(T, R);
+
+    point_extproj_precomp_x4_t U;
+    __m256i* const coordinates[4] = {U->xy[0], U->yx[0], U->z2[0], U->t2[0]};
+    for (unsigned int i = 64; i--;)
+    {
+        eccdouble_x4(R);
+
+        const __m256i index = _mm256_set_epi64x(
+            (3 * 16 + signMasks[3][i] * 8 + digits[3][i]) * 24,
+            (2 * 16 + signMasks[2][i] * 8 + digits[2][i]) * 24,
+            (1 * 16 + signMasks[1][i] * 8 + digits[1][i]) * 24,
+            (0 * 16 + signMasks[0][i] * 8 + digits[0][i]) * 24);
+        for (unsigned int limb = 0; limb < 24; limb++)
+        {
+            coordinates[limb / 6][limb % 6] = _mm256_i64gather_epi64(
+                (const long long*)table,
+                _mm256_add_epi64(index, _mm256_set1_epi64x(limb)),
+                8);
+        }
+        eccadd_x4(U, R);
+    }
+}
+
+FOURQ_TARGET_IFMA static void getPublicKeys_x4(
+    const unsigned char* privateKeys,
+    unsigned char* publicKeys)
+{ // Four SchnorrQ public keys at once, see getPublicKey()
+    unsigned long long k[4][4];
+    point_extproj_x4_t R;
+    point_extproj_t T[4];
+    point_t P;
+
+    memcpy(k, privateKeys, sizeof(k));
+    ecc_mul_fixed_x4(k[0], R);
+    point_extproj_unpack_x4(R, T);
+    for (unsigned int lane = 0; lane < 4; lane++)
+    {
+        eccnorm(T[lane], P);
+        encode(P, publicKeys + 32 * lane);
+    }
+}
+
+FOURQ_TARGET_IFMA static void verify_x4(
+    const unsigned char* publicKeys,
+    const unsigned char* messageDigests,
+    const unsigned char* signatures,
+    bool* results)
+{ // Four SchnorrQ signature verifications at once, see verify(). Lanes that fail the encoding
+  // checks are computed on a copy of a valid lane and reported as invalid
+    point_t A[4], P;
+    unsigned long long s[4][4], h[4][4];
+    unsigned char temp[32 + 64], hash[64];
+    int validLane = -1;
+
+    for (unsigned int lane = 0; lane < 4; lane++)
+    {
+        const unsigned char* publicKey = publicKeys + 32 * lane;
+        const unsigned char* signature = signatures + 64 * lane;
+
+        results[lane] =
+            !((publicKey[15] & 0x80) || (signature[15] & 0x80) || (signature[62] & 0xC0) ||
+              signature[63]) &&
+            decode(publicKey, A[lane]);
+        if (!results[lane])
+        {
+            continue;
+        }
+
+        memcpy(temp, signature, 32);
+        memcpy(temp + 32, publicKey, 32);
+        memcpy(temp + 64, messageDigests + 32 * lane, 32);
+        KangarooTwelve(temp, 32 + 64, hash, 64);
+        memcpy(h[lane], hash, 32); // ecc_mul_double() also only reads the first 256 bits
+        memcpy(s[lane], signature + 32, 32);
+        validLane = lane;
+    }
+    if (validLane < 0)
+    {
+        return;
+    }
+    for (unsigned int lane = 0; lane < 4; lane++)
+    {
+        if (!results[lane])
+        {
+            memcpy(A[lane], A[validLane], sizeof(point_t));
+            memcpy(h[lane], h[validLane], 32);
+            memcpy(s[lane], s[validLane], 32);
+        }
+    }
+
+    point_extproj_x4_t R, Q;
+    point_extproj_precomp_x4_t Q2;
+    point_extproj_t T[4];
+
+    ecc_mul_fixed_x4(s[0], Q); // Q = s*G
+    ecc_mul_x4(A, h[0], R);    // R = h*A
+    R1_to_R2_x4(Q, Q2);
+    eccadd_x4(Q2, R); // R = s*G + h*A
+
+    point_extproj_unpack_x4(R, T);
+    for (unsigned int lane = 0; lane < 4; lane++)
+    {
+        if (results[lane])
+        {
+            eccnorm(T[lane], P);
+            encode(P, (unsigned char*)P);
+            results[lane] = memcmp(P, signatures + 64 * lane, 32) == 0;
+        }
+    }
+}
+
+FOURQ_TARGET_IFMA static void sign_expanded_x4(
+    const unsigned char* expandedKey,
+    const unsigned char* publicKey,
+    const unsigned char* messageDigests,
+    unsigned char* signatures)
+{ // Four SchnorrQ signatures of consecutive 32-byte message digests with one expanded key, see
+  // sign_expanded()
+    unsigned long long r[4][8], k[4][4];
+    point_extproj_x4_t R;
+    point_extproj_t T[4];
+    point_t P;
+
+    for (unsigned int lane = 0; lane < 4; lane++)
+    {
+        sign_nonce(expandedKey, messageDigests + 32 * lane, r[lane]);
+        memcpy(k[lane], r[lane], 32);
+    }
+    ecc_mul_fixed_x4(k[0], R);
+    point_extproj_unpack_x4(R, T);
+    for (unsigned int lane = 0; lane < 4; lane++)
+    {
+        eccnorm(T[lane], P);
+        encode(P, signatures + 64 * lane);
+        sign_finish(
+            expandedKey,
+            publicKey,
+            messageDigests + 32 * lane,
+            r[lane],
+            signatures + 64 * lane);
+    }
+}
+
+static void getPublicKeys(
+    const unsigned char* privateKeys,
+    unsigned char* publicKeys,
+    unsigned int count)
+{ // Batch SchnorrQ public key generation for count consecutive 32-byte private keys
+  // Groups of four keys use the 4-way engine when IFMA is available, the rest use getPublicKey()
+    unsigned int i = 0;
+
+    if (useIfmaPointArithmetic)
+    {
+        for (; i + 4 <= count; i += 4)
+        {
+            getPublicKeys_x4(privateKeys + 32 * i, publicKeys + 32 * i);
+        }
+    }
+    for (; i < count; i++)
+    {
+        getPublicKey(privateKeys + 32 * i, publicKeys + 32 * i);
+    }
+}
+
+static void signEach(
+    const unsigned char* expandedKey,
+    const unsigned char* publicKey,
+    const unsigned char* messageDigests,
+    unsigned int count,
+    unsigned char* signatures)
+{ // Batch SchnorrQ signature generation with one key expanded by sign_expand_key(), signatures +
+  // 64*i = sign_expanded(expandedKey, publicKey, messageDigests + 32*i). Groups of four signatures
+  // use the 4-way engine when IFMA is available, the rest use sign_expanded()
+    unsigned int i = 0;
+
+    if (useIfmaPointArithmetic)
+    {
+        for (; i + 4 <= count; i += 4)
+        {
+            sign_expanded_x4(expandedKey, publicKey, messageDigests + 32 * i, signatures + 64 * i);
+        }
+    }
+    for (; i < count; i++)
+    {
+        sign_expanded(expandedKey, publicKey, messageDigests + 32 * i, signatures + 64 * i);
+    }
+}
+
+static void verifyEach(
+    const unsigned char* publicKeys,
+    const unsigned char* messageDigests,
+    const unsigned char* signatures,
+    unsigned int count,
+    bool* results)
+{ // Batch SchnorrQ signature verification, results[i] = verify(publicKeys + 32*i,
+  // messageDigests + 32*i, signatures + 64*i). Groups of four signatures use the 4-way engine
+  // when IFMA is available, the rest use verify()
+    unsigned int i = 0;
+
+    if (useIfmaPointArithmetic)
+    {
+        for (; i + 4 <= count; i += 4)
+        {
+            verify_x4(
+                publicKeys + 32 * i,
+                messageDigests + 32 * i,
+                signatures + 64 * i,
+                results + i);
+        }
+    }
+    for (; i < count; i++)
+    {
+        results[i] = verify(publicKeys + 32 * i, messageDigests + 32 * i, signatures + 64 * i);
+    }
+}
+
+static bool verifyBatch(
+    const unsigned char* publicKeys,
+    const unsigned char* messageDigests,
+    const unsigned char* signatures,
+    unsigned int count,
+    bool* results)
+{ // Batch SchnorrQ signature verification with a randomized linear combination, see
+  // verify_batch_chunk() in four_q.h for the cofactor caveat. Signatures are checked in chunks of
+  // VERIFY_BATCH_CHUNK, a chunk that fails falls back to verifyEach() to identify the invalid
+  // signatures. Returns true if all signatures are valid, results[i] holds the outcome per
+  // signature
+    bool allValid = true;
+
+    for (unsigned int i = 0; i < count; i += VERIFY_BATCH_CHUNK)
+    {
+        const unsigned int chunk = count - i < VERIFY_BATCH_CHUNK ? count - i : VERIFY_BATCH_CHUNK;
+
+        const bool chunkValid = verify_batch_chunk(
+            publicKeys + 32 * i,
+            messageDigests + 32 * i,
+            signatures + 64 * i,
+            chunk);
+        if (!chunkValid)
+        {
+            verifyEach(
+                publicKeys + 32 * i,
+                messageDigests + 32 * i,
+                signatures + 64 * i,
+                chunk,
+                results + i);
+        }
+        for (unsigned int j = i; j < i + chunk; j++)
+        {
+            if (chunkValid)
+            {
+                results[j] = true;
+            }
+            allValid &= results[j];
+        }
+    }
+
+    return allValid;
+}
@@ -1102,6 +1102,24 @@ static void KangarooTwelve_F_Absorb(KangarooTwelve_F* instance, const unsigned c
     }
 }
 
+// Completes KangarooTwelve() of an input shorter than K12_chunkSize that was absorbed into a zeroed
+// instance, copying the instance beforehand allows hashing several inputs that share a prefix
+static void KangarooTwelve_F_Final(KangarooTwelve_F* instance, unsigned char* output, unsigned int outputByteLen)
+{
+    if (++instance->byteIOIndex == K12_rateInBytes)
+    {
+        KeccakP1600_Permute_12rounds(instance->state);
+        instance->state[0] ^= 0x07;
+    }
+    else
+    {
+        instance->state[instance->byteIOIndex] ^= 0x07;
+    }
+    instance->state[K12_rateInBytes - 1] ^= 0x80;
+    KeccakP1600_Permute_12rounds(instance->state);
+    copyMem(output, instance->state, outputByteLen);
+}
+
 static void KangarooTwelve(const unsigned char* input, unsigned int inputByteLen, unsigned char* output, unsigned int outputByteLen)
 {
     KangarooTwelve_F queueNode;
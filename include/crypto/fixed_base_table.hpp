@@ -0,0 +1,149 @@
+#pragma once
+
+#include <tl/expected.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Fixed-base table smart pointer
+ */
+typedef std::shared_ptr<const class FixedBaseTable> FixedBaseTablePtr;
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Fixed-base table error message
+ */
+struct FixedBaseTableError
+{
+    std::string message;
+};
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Larger precomputed multiples of the FourQ generator for public key generation
+ *
+ * The compiled-in comb table of `getPublicKey` is 7.5 KB and costs 50 point additions and 9
+ * doublings per key. This table trades memory for speed: with window width w it stores
+ * (247 / w + 1) * 2^(w - 1) points of 96 bytes and needs 247 / w point additions per key,
+ * e.g. w = 8 uses 372 KB and 30 additions, w = 12 uses 3.9 MB and 20 additions and w = 16 uses
+ * 48 MB and 15 additions.
+ */
+class FixedBaseTable
+{
+private:
+    /**
+     * Hidden constructor
+     * @param windowWidth The window width in bits
+     * @param entries The table entries, 12 words per point
+     */
+    FixedBaseTable(unsigned int windowWidth, std::vector<unsigned long long> entries) noexcept;
+
+public:
+    /**
+     * Factory functions
+     */
+    friend tl::expected<FixedBaseTablePtr, FixedBaseTableError> CreateFixedBaseTable(
+        unsigned int windowWidth);
+    friend tl::expected<FixedBaseTablePtr, FixedBaseTableError> LoadFixedBaseTable(
+        const std::string& path);
+
+    /**
+     * Get the window width
+     * @return The window width in bits
+     */
+    unsigned int GetWindowWidth() const;
+
+    /**
+     * Get the size of the table
+     * @return The size of the table in bytes
+     */
+    size_t GetMemorySize() const;
+
+    /**
+     * Compute the public key belonging to a private key, equal to `getPublicKey`
+     * @param privateKey The 32-byte private key
+     * @param publicKey The 32-byte public key
+     */
+    void GetPublicKey(const unsigned char* privateKey, unsigned char* publicKey) const;
+
+    /**
+     * Save the table to a cache file
+     * @param path The path of the cache file
+     * @return `true` upon success, else an error message
+     */
+    tl::expected<bool, FixedBaseTableError> Save(const std::string& path) const;
+
+private:
+    /// Window width in bits
+    unsigned int m_windowWidth;
+
+    /// Entries in the representation (x+y,y-x,2dt), 12 words per point
+    std::vector<unsigned long long> m_entries;
+};
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Build a new table, this takes milliseconds for small windows and a few hundred milliseconds for
+ * the largest window
+ * @param windowWidth The window width in bits, 4 to 16
+ * @return The table or encountered error
+ */
+tl::expected<FixedBaseTablePtr, FixedBaseTableError> CreateFixedBaseTable(unsigned int windowWidth);
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Load a table from a cache file written by `FixedBaseTable::Save`
+ * @param path The path of the cache file
+ * @return The table or encountered error
+ */
+tl::expected<FixedBaseTablePtr, FixedBaseTableError> LoadFixedBaseTable(const std::string& path);
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Load a table from a cache file, or build it and try to write the cache file when the file is
+ * missing, invalid or was built for a different window width
+ * @param path The path of the cache file
+ * @param windowWidth The window width in bits, 4 to 16
+ * @return The table or encountered error
+ */
+tl::expected<FixedBaseTablePtr, FixedBaseTableError> LoadOrCreateFixedBaseTable(
+    const std::string& path,
+    unsigned int windowWidth);
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Select the table used for public key generation by this process
+ * @param table The table to use, or `nullptr` for the compiled-in table
+ */
+void SelectFixedBaseTable(FixedBaseTablePtr table);
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Get the table used for public key generation by this process
+ * @return The selected table, or `nullptr` if the compiled-in table is used
+ */
+FixedBaseTablePtr GetSelectedFixedBaseTable();
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Compute a public key with the selected table
+ * @param privateKey The 32-byte private key
+ * @param publicKey The 32-byte public key
+ */
+void ComputePublicKey(const unsigned char* privateKey, unsigned char* publicKey);
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Compute consecutive public keys with the selected table, the compiled-in table uses the
+ * 4-way batch engine when available
+ * @param privateKeys The 32-byte private keys
+ * @param publicKeys The 32-byte public keys
+ * @param count The number of keys
+ */
+void ComputePublicKeys(
+    const unsigned char* privateKeys,
+    unsigned char* publicKeys,
+    unsigned int count);
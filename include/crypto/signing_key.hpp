@@ -0,0 +1,91 @@
+#pragma once
+
+#include <tl/expected.hpp>
+
+#include <memory>
+#include <string>
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Signing key smart pointer
+ */
+typedef std::shared_ptr<const class SigningKey> SigningKeyPtr;
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Signing key error message
+ */
+struct SigningKeyError
+{
+    std::string message;
+};
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Keys derived from a seed, kept in binary form to sign any number of messages
+ *
+ * `sign` derives the secret scalar and nonce prefix from the subseed on every call, and callers
+ * usually recompute the subseed and public key from the seed and identity strings as well. This
+ * object does all of that once, so a signature only costs the nonce hash, one fixed-base scalar
+ * multiplication and the challenge hash.
+ */
+class SigningKey
+{
+private:
+    /**
+     * Hidden constructor
+     */
+    SigningKey() = default;
+
+public:
+    /**
+     * Factory function
+     */
+    friend tl::expected<SigningKeyPtr, SigningKeyError> CreateSigningKey(const std::string& seed);
+
+    /**
+     * Get the public key
+     * @return The 32-byte public key
+     */
+    const unsigned char* GetPublicKey() const;
+
+    /**
+     * Get the identity
+     * @return The 60-character identity
+     */
+    const std::string& GetIdentity() const;
+
+    /**
+     * Sign a message digest, equal to `sign` with the subseed of the seed
+     * @param messageDigest The 32-byte message digest
+     * @param signature The 64-byte signature
+     */
+    void Sign(const unsigned char* messageDigest, unsigned char* signature) const;
+
+    /**
+     * Sign consecutive message digests, using the 4-way engine when available
+     * @param messageDigests The 32-byte message digests
+     * @param count The number of message digests
+     * @param signatures The 64-byte signatures
+     */
+    void Sign(const unsigned char* messageDigests, unsigned int count, unsigned char* signatures)
+        const;
+
+private:
+    /// Secret scalar in Montgomery representation followed by the nonce prefix
+    unsigned char m_expandedKey[64];
+
+    /// Public key
+    unsigned char m_publicKey[32];
+
+    /// Identity of the public key
+    std::string m_identity;
+};
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Derive the signing key of a seed
+ * @param seed The 55-character seed
+ * @return The signing key or encountered error
+ */
+tl::expected<SigningKeyPtr, SigningKeyError> CreateSigningKey(const std::string& seed);
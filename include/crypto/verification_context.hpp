@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "core/m256.h"
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * SchnorrQ verification with cached per-public-key precomputation
+ *
+ * `verify` decodes the public key, which includes a square root, and builds the variable-base
+ * tables of the double scalar multiplication on every call. Most signatures come from a small set
+ * of keys, e.g. the 676 computors or our own wallets, so this context keeps the tables of the most
+ * recently used public keys. An entry takes 2 KB, the default capacity of 1024 keys covers all
+ * computors with room to spare. The context is thread-safe.
+ */
+class VerificationContext
+{
+public:
+    /// Default number of cached public keys
+    static constexpr size_t defaultCapacity = 1024;
+
+    /**
+     * Constructor
+     * @param capacity The maximum number of cached public keys, at least one
+     */
+    explicit VerificationContext(size_t capacity = defaultCapacity);
+
+    /**
+     * Verify a signature, equal to `verify`
+     * @param publicKey The 32-byte public key
+     * @param messageDigest The 32-byte message digest
+     * @param signature The 64-byte signature
+     * @return `true` if the signature is valid, else `false`
+     */
+    bool Verify(
+        const unsigned char* publicKey,
+        const unsigned char* messageDigest,
+        const unsigned char* signature);
+
+    /**
+     * Get the number of cached public keys
+     * @return The number of cached public keys
+     */
+    size_t GetSize() const;
+
+    /**
+     * Get the maximum number of cached public keys
+     * @return The maximum number of cached public keys
+     */
+    size_t GetCapacity() const;
+
+    /**
+     * Remove all cached public keys
+     */
+    void Clear();
+
+private:
+    /// Decoded public key and its precomputed tables, defined in the translation unit
+    struct Entry;
+
+    /**
+     * Public key hash, public keys are uniformly distributed so one word suffices
+     */
+    struct PublicKeyHash
+    {
+        size_t operator()(const m256i& publicKey) const { return publicKey.m256i_u64[0]; }
+    };
+
+    /**
+     * Public key comparison, `operator==` of m256i needs 32-byte alignment which the nodes of the
+     * containers don't guarantee
+     */
+    struct PublicKeyEqual
+    {
+        bool operator()(const m256i& a, const m256i& b) const
+        {
+            return memcmp(&a, &b, sizeof(m256i)) == 0;
+        }
+    };
+
+    /**
+     * Find or create the entry of a public key and mark it as most recently used
+     * @param publicKey The public key
+     * @return The entry
+     */
+    std::shared_ptr<const Entry> GetEntry(const m256i& publicKey);
+
+private:
+    /// Maximum number of cached public keys
+    size_t m_capacity;
+
+    /// Public keys, most recently used first
+    std::list<m256i> m_recentlyUsed;
+
+    /// Cached entries and their position in `m_recentlyUsed`
+    std::unordered_map<
+        m256i,
+        std::pair<std::shared_ptr<const Entry>, std::list<m256i>::iterator>,
+        PublicKeyHash,
+        PublicKeyEqual>
+        m_entries;
+
+    /// Guard for the cache
+    mutable std::mutex m_mutex;
+};
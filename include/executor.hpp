@@ -0,0 +1,288 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "cancellation_token.hpp"
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Lanes of the executor, a worker always takes a job of the highest priority first
+ */
+enum class TaskPriority
+{
+    /// Work a user is waiting for, e.g. a balance query
+    Interactive,
+
+    /// Work nobody is waiting for, e.g. confirming transactions
+    Background,
+
+    /// Long running computations, e.g. brute forcing a wallet prefix
+    Bulk
+};
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Lock-free queue of completions, filled by any thread and drained by one thread
+ *
+ * Producers push onto an atomic stack, the consumer takes the whole stack at once and runs it in
+ * the order of pushing. Neither side ever waits for the other.
+ */
+class CompletionQueue
+{
+public:
+    CompletionQueue() = default;
+    CompletionQueue(const CompletionQueue&) = delete;
+    CompletionQueue& operator=(const CompletionQueue&) = delete;
+
+    /**
+     * Destructor, discards the completions that were not drained
+     */
+    ~CompletionQueue();
+
+    /**
+     * Add a completion, can be called from any thread
+     * @param completion The function to run on the draining thread
+     * @param token The completion is discarded if the token is cancelled before it runs
+     */
+    void Push(std::function<void()> completion, CancellationToken token);
+
+    /**
+     * Run the completions pushed so far on the calling thread, only one thread may drain
+     * @return The number of completions that ran
+     */
+    size_t Drain();
+
+private:
+    /**
+     * Pushed completion
+     */
+    struct Node
+    {
+        /// The function to run
+        std::function<void()> completion;
+
+        /// Discard the completion if cancelled
+        CancellationToken token;
+
+        /// The completion pushed before this one
+        Node* next = nullptr;
+    };
+
+    /// The last pushed completion
+    std::atomic<Node*> m_head{nullptr};
+};
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Bounded pool of worker threads with priority lanes and work stealing
+ *
+ * Every worker has a queue per lane. Jobs scheduled from a worker go to its own queue, others are
+ * spread over the workers. A worker takes the oldest job of its own queues, else steals the newest
+ * job of another worker, always trying the highest priority lane first. Bulk jobs never occupy all
+ * workers, so interactive work starts right away even while a long computation runs.
+ *
+ * Work receives the cancellation token it was scheduled with. Jobs of which the token is cancelled
+ * are not started, and their completions are discarded. Results can be handed back to one thread,
+ * e.g. the GUI thread, through a completion queue that it drains.
+ */
+class Executor
+{
+public:
+    /**
+     * Constructor, starts the workers
+     * @param threadCount The number of workers, zero for the number of hardware threads
+     */
+    explicit Executor(unsigned int threadCount = 0);
+
+    Executor(const Executor&) = delete;
+    Executor& operator=(const Executor&) = delete;
+
+    /**
+     * Destructor, waits for running jobs and discards queued jobs and completions
+     */
+    ~Executor();
+
+    /**
+     * Run work on a worker
+     * @param priority The lane of the work
+     * @param work The function to run, receives the cancellation token
+     * @param token The token to cancel the work
+     * @return The future result, a `std::future_error` if the work was cancelled before it started
+     */
+    template <typename F>
+    std::future<std::invoke_result_t<F&, const CancellationToken&>> Submit(
+        TaskPriority priority,
+        F work,
+        CancellationToken token = {});
+
+    /**
+     * Run work on a worker, and hand its result to a completion on the draining thread
+     * @param priority The lane of the work
+     * @param work The function to run, receives the cancellation token
+     * @param completion Receives the result of the work during `DrainCompletions`
+     * @param token The token to cancel the work and its completion
+     */
+    template <typename F, typename C>
+    void Post(TaskPriority priority, F work, C completion, CancellationToken token = {});
+
+    /**
+     * Run a function on the draining thread, can be called from any thread
+     * @param completion The function to run during `DrainCompletions`
+     * @param token The completion is discarded if the token is cancelled before it runs
+     */
+    void PostCompletion(std::function<void()> completion, CancellationToken token = {});
+
+    /**
+     * Run the completions posted so far, only one thread may drain, e.g. once per frame
+     * @return The number of completions that ran
+     */
+    size_t DrainCompletions();
+
+    /**
+     * Get the number of workers
+     * @return The number of worker threads
+     */
+    unsigned int GetThreadCount() const;
+
+private:
+    /// Number of lanes
+    static constexpr size_t laneCount = 3;
+
+    /**
+     * Scheduled work
+     */
+    struct Job
+    {
+        /// The function to run
+        std::function<void(const CancellationToken&)> run;
+
+        /// Skip the job if cancelled
+        CancellationToken token;
+    };
+
+    /**
+     * Queues of a worker
+     */
+    struct Worker
+    {
+        /// Jobs by lane
+        std::array<std::deque<Job>, laneCount> lanes;
+
+        /// Guard for `lanes`
+        std::mutex mutex;
+    };
+
+    /**
+     * Queue a job
+     * @param priority The lane of the job
+     * @param job The job
+     */
+    void Schedule(TaskPriority priority, Job job);
+
+    /**
+     * Run jobs until stopped
+     * @param index The index of the worker
+     */
+    void Run(size_t index);
+
+    /**
+     * Take the job of the highest priority, from the own queues or from another worker
+     * @param index The index of the worker
+     * @param outJob Receives the job
+     * @param outLane Receives the lane of the job
+     * @return `true` if a job was taken, else `false`
+     */
+    bool TakeJob(size_t index, Job& outJob, size_t& outLane);
+
+    /**
+     * Reserve a worker for a bulk job
+     * @return `true` if fewer bulk jobs run than allowed, else `false`
+     */
+    bool ReserveBulk();
+
+    /**
+     * Free a worker reserved for a bulk job
+     */
+    void ReleaseBulk();
+
+    /**
+     * Check if a sleeping worker could take a job, requires `m_mutex`
+     * @return `true` if a job can be taken, else `false`
+     */
+    bool HasRunnableJob() const;
+
+private:
+    /// Queues of the workers
+    std::vector<std::unique_ptr<Worker>> m_workers;
+
+    /// Number of queued jobs by lane, at least the number in the queues
+    std::array<std::atomic<size_t>, laneCount> m_queuedCounts{};
+
+    /// Number of running bulk jobs
+    std::atomic<unsigned int> m_bulkCount{0};
+
+    /// Maximum number of running bulk jobs
+    unsigned int m_maximumBulkCount;
+
+    /// Worker to queue the next job from outside the pool on
+    std::atomic<size_t> m_nextWorker{0};
+
+    /// Completions to run on the draining thread
+    CompletionQueue m_completions;
+
+    /// Tell the workers to stop, guarded by `m_mutex`
+    bool m_bStop = false;
+
+    /// Guard for sleeping workers
+    std::mutex m_mutex;
+
+    /// Wakes sleeping workers
+    std::condition_variable m_condition;
+
+    /// The worker threads
+    std::vector<std::thread> m_threads;
+};
+
+// ------------------------------------------------------------------------------------------------
+template <typename F>
+std::future<std::invoke_result_t<F&, const CancellationToken&>> Executor::Submit(
+    TaskPriority priority,
+    F work,
+    CancellationToken token)
+{
+    typedef std::invoke_result_t<F&, const CancellationToken&> Result;
+
+    // Shared, a job must be copyable
+    auto task = std::make_shared<std::packaged_task<Result(const CancellationToken&)>>(
+        std::move(work));
+    auto future = task->get_future();
+    Schedule(
+        priority,
+        {[task](const CancellationToken& token) { (*task)(token); }, std::move(token)});
+    return future;
+}
+
+// ------------------------------------------------------------------------------------------------
+template <typename F, typename C>
+void Executor::Post(TaskPriority priority, F work, C completion, CancellationToken token)
+{
+    Schedule(
+        priority,
+        {[this, work = std::move(work), completion = std::move(completion)](
+             const CancellationToken& token) mutable {
+             PostCompletion(
+                 [completion, result = work(token)]() mutable { completion(std::move(result)); },
+                 token);
+         },
+         std::move(token)});
+}
@@ -1,9 +1,17 @@
 #pragma once
 
-#include <atomic>
-#include <future>
+#include <unordered_map>
 
+#include "executor.hpp"
 #include "gui/window.hpp"
+#include "network/async_engine.hpp"
+#include "network/hedging.hpp"
+#include "network/node_registry.hpp"
+#include "network/peer_crawler.hpp"
+#include "network/request_coalescer.hpp"
+#include "network/tick_offset.hpp"
+#include "network/tick_tracker.hpp"
+#include "network/transfer_retrier.hpp"
 #include "network/transactions.hpp"
 #include "wallet.hpp"
 
@@ -78,8 +86,8 @@ protected:
      * Helper function to verify the input of the transaction tab
      * @param seed The seed of the sender
      * @param recipient The identity of the recipient
-     * @param ipAddress The ip-address of the node to broadcast to
-     * @param port The port of the node to broadcast to
+     * @param ipAddress The ip-address of a node, added to the node registry
+     * @param port The port of the node
      * @param amount The amount to transact
      * @return `true` upon success, else an error message
      */
@@ -90,15 +98,31 @@ protected:
         const std::string& port,
         unsigned long long amount);
 
+    /**
+     * Update the status of the transactions in a tick
+     * @param tickData The tick data of the node
+     */
+    void ConfirmTickData(const TickData& tickData);
+
+    /**
+     * Sign and broadcast a failed transfer again in the background
+     * @param request The failed transfer
+     */
+    void RetryTransfer(const RetryRequest& request);
+
+    /**
+     * Add a node typed by the user to the registry, invalid addresses are ignored
+     * @param ipAddress The ip-address of the node
+     * @param port The port of the node
+     */
+    void AddNode(const std::string& ipAddress, const std::string& port);
+
 private:
     /// Is brute force running
     bool m_bWaitingForBruteForce = false;
 
-    /// Future to receive brute force result
-    std::future<Wallet> m_bruteForceFuture;
-
-    /// Tell brute force threads to stop
-    std::atomic<bool> m_stopBruteForce = false;
+    /// Token to stop the brute force
+    CancellationToken m_bruteForceToken;
 
     /// History of transactions made during the runtime of the program
     std::vector<Receipt> m_history;
@@ -106,7 +130,50 @@ private:
     /// Transactions that are not confirmed yet
     std::vector<Receipt> m_confirmingTransactions;
 
+    /// Tick offset of each transaction that is not confirmed yet, by hash
+    std::unordered_map<std::string, unsigned int> m_tickOffsets;
+
+    /// Picks the tick offset of new transactions
+    TickOffsetEstimator m_tickOffsetEstimator;
+
+    /// Health of the known nodes, every request picks its node from here
+    NodeRegistry m_nodeRegistry;
+
+    /// Shares the balance and tick queries of the tabs and transfers that run at the same time
+    RequestCoalescer m_coalescer;
+
+    /// Current tick of the registered nodes, sampled in the background
+    TickTracker m_tickTracker;
+
+    /// Discovers nodes through the peers of the registered nodes, and keeps the best on disk
+    PeerCrawler m_peerCrawler;
+
+    /// Should failed transfers be broadcast again
+    bool m_bRetryFailedTransactions = false;
+
+    /// Attempts of every transfer, by the hash of the first attempt
+    TransferRetrier m_transferRetrier;
+
+    /// Signing key of the last verified transaction input, reused while the seed is unchanged
+    SigningKeyPtr m_signingKey;
+
+    /// Seed belonging to `m_signingKey`
+    std::string m_signingKeySeed;
+
     /// todo: read these from some configuration file
     std::string m_ipAddress{};
     std::string m_port{"21841"};
+
+    /// Cancels all work of the window once it closes
+    CancellationToken m_cancellation;
+
+    /// Runs the work of the window, declared after the members its work uses
+    Executor m_executor;
+
+    /// Runs the network requests that don't need a thread of their own, declared after the
+    /// executor that its requests complete on
+    AsyncEngine m_networkEngine;
+
+    /// Sends the requests of the engine to the best nodes of the registry
+    RequestHedger m_hedger{m_networkEngine, m_nodeRegistry};
 };
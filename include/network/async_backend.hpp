@@ -0,0 +1,170 @@
+#pragma once
+
+#include <tl/expected.hpp>
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "network/async_engine.hpp"
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * State of a request of an `AsyncEngine`, backends derive from it to add their own state
+ */
+struct AsyncOperation
+{
+    virtual ~AsyncOperation() = default;
+
+    /// Id of the request, unique for the lifetime of the engine
+    unsigned long long id = 0;
+
+    /// The node
+    NodeAddress node;
+
+    /// The packets to send
+    std::vector<char> request;
+
+    /// Should a response be received
+    bool bExpectResponse = true;
+
+    /// Complete once connected, and hand the socket over in `connection` instead of closing it
+    bool bConnectOnly = false;
+
+    /// The connection of a request that only connects
+    ConnectionPtr connection;
+
+    /// The header type of the response
+    unsigned char responseType = 0;
+
+    /// Received data, starting at a frame
+    std::vector<char> received;
+
+    /// Number of bytes in `received`
+    size_t receivedSize = 0;
+
+    /// Time at which the request fails
+    std::chrono::steady_clock::time_point deadline;
+
+    /// Aborts the request once cancelled
+    CancellationToken token;
+
+    /// Receives the response
+    RequestCallback callback;
+};
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Drives the sockets of the requests of an `AsyncEngine`, all functions except `CreateOperation`
+ * and `Wake` are called on the engine thread
+ */
+class AsyncBackend
+{
+public:
+    /**
+     * Constructor
+     * @param engine The engine that owns the backend
+     */
+    explicit AsyncBackend(AsyncEngine& engine);
+
+    virtual ~AsyncBackend() = default;
+
+    /**
+     * Create the state of a request
+     * @return The state, including the state of this backend
+     */
+    virtual std::unique_ptr<AsyncOperation> CreateOperation() const;
+
+    /**
+     * Start a request, may complete it right away
+     * @param operation The request
+     */
+    virtual void Start(AsyncOperation& operation) = 0;
+
+    /**
+     * Wait for sockets to become ready, or be woken up, and continue their requests
+     * @param timeout The maximum time to wait, negative to wait without limit
+     */
+    virtual void Poll(std::chrono::milliseconds timeout) = 0;
+
+    /**
+     * Make `Poll` return, can be called from any thread
+     */
+    virtual void Wake() = 0;
+
+    /**
+     * Stop all work of a request before its callback is called
+     * @param operation The completed request
+     */
+    virtual void Stop(AsyncOperation& operation);
+
+    /**
+     * Take ownership of a completed request after its callback was called
+     * @param operation The completed request
+     */
+    virtual void Release(std::unique_ptr<AsyncOperation> operation);
+
+    /**
+     * Wait until the work of the completed requests is done, called before the engine thread exits
+     */
+    virtual void Drain();
+
+protected:
+    /**
+     * Find a request in flight
+     * @param id The id of the request
+     * @return The request, or `nullptr` if it completed already
+     */
+    AsyncOperation* FindOperation(unsigned long long id) const;
+
+    /**
+     * Finish a request and call its callback, the request must not be used afterwards
+     * @param operation The request
+     * @param result The response frame or the error that occurred
+     */
+    void Complete(AsyncOperation& operation, tl::expected<const char*, ConnectionError> result);
+
+    /**
+     * Fail a request, the request must not be used afterwards
+     * @param operation The request
+     * @param message The error message
+     */
+    void Fail(AsyncOperation& operation, std::string message);
+
+    /**
+     * Look for the response in the received data, like `Connection::ReceiveFrame`, and complete
+     * the request if it is found or invalid. Otherwise frames of other types are discarded and
+     * `received` is grown to fit the partial frame.
+     * @param operation The request
+     * @return `true` if the request completed, else `false`
+     */
+    bool ParseResponse(AsyncOperation& operation);
+
+private:
+    /// The engine that owns the backend
+    AsyncEngine& m_engine;
+};
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Create the io_uring backend
+ * @param engine The engine that owns the backend
+ * @return The backend, or `nullptr` if the host doesn't support the required io_uring features
+ */
+std::unique_ptr<AsyncBackend> CreateIoUringBackend(AsyncEngine& engine);
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Create the epoll backend
+ * @param engine The engine that owns the backend
+ * @return The backend, or `nullptr` if the host doesn't support epoll
+ */
+std::unique_ptr<AsyncBackend> CreateEpollBackend(AsyncEngine& engine);
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Create the backend that runs a blocking `Connection` on a thread per request
+ * @param engine The engine that owns the backend
+ * @return The backend
+ */
+std::unique_ptr<AsyncBackend> CreateThreadBackend(AsyncEngine& engine);
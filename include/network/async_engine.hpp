@@ -0,0 +1,326 @@
+#pragma once
+
+#include <tl/expected.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "network/connection.hpp"
+#include "network/task.hpp"
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Callback of a request, receives the response frame including its header, or `nullptr` if no
+ * response was expected. The frame is only valid during the callback.
+ */
+typedef std::function<void(tl::expected<const char*, ConnectionError>)> RequestCallback;
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Callback of a typed request
+ */
+template <typename T>
+using AsyncCallback = std::function<void(tl::expected<T, ConnectionError>)>;
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Ways of the engine to wait for sockets, from least to most efficient
+ */
+enum class AsyncEngineBackend
+{
+    /// A blocking `Connection` on a thread per request, available everywhere
+    Threads,
+
+    /// Non-blocking sockets watched by one epoll instance, Linux only
+    Epoll,
+
+    /// Batched submissions and multishot receives into registered buffers, Linux 6.0 and later
+    IoUring
+};
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Non-blocking network engine that multiplexes all requests on a single thread
+ *
+ * Every request connects to a node, sends its packets and waits for the first response frame of
+ * a type, like the blocking functions do on a `Connection`. Instead of a blocked thread per
+ * request, the sockets of all requests are driven by one backend, so thousands of requests can be
+ * in flight at once. Callbacks run on the engine thread and must not block.
+ */
+class AsyncEngine
+{
+public:
+    /// Default time a request may take, from connecting until the response is complete
+    static constexpr std::chrono::milliseconds defaultTimeout{5000};
+
+    /// Longest time before cancelled requests are noticed
+    static constexpr std::chrono::milliseconds cancellationInterval{50};
+
+    /**
+     * Constructor, starts the engine thread
+     * @param preferredBackend The most efficient backend to try, falls back to the less efficient
+     * ones if it isn't available on this host
+     */
+    explicit AsyncEngine(AsyncEngineBackend preferredBackend = AsyncEngineBackend::IoUring);
+
+    AsyncEngine(const AsyncEngine&) = delete;
+    AsyncEngine& operator=(const AsyncEngine&) = delete;
+
+    /**
+     * Destructor, fails all pending requests and stops the engine thread
+     */
+    ~AsyncEngine();
+
+    /**
+     * Start a request, can be called from any thread including callbacks
+     * @param node The node to send the request to
+     * @param request The packets to send
+     * @param responseType The header type of the response, ignored if `bExpectResponse` is false
+     * @param bExpectResponse `false` to complete as soon as the request has been sent
+     * @param timeout The maximum time the request may take
+     * @param callback Receives the response frame or the error that occurred
+     * @param token Aborts the request once cancelled
+     */
+    void Request(
+        const NodeAddress& node,
+        std::vector<char> request,
+        unsigned char responseType,
+        bool bExpectResponse,
+        std::chrono::milliseconds timeout,
+        RequestCallback callback,
+        CancellationToken token = {});
+
+    /**
+     * Connect to a node without blocking, can be called from any thread including callbacks
+     * @param node The node to connect to
+     * @param timeout The maximum time to wait for the connection to be accepted
+     * @param callback Receives the blocking connection or the error that occurred
+     * @param token Aborts connecting once cancelled
+     */
+    void Connect(
+        const NodeAddress& node,
+        std::chrono::milliseconds timeout,
+        AsyncCallback<ConnectionPtr> callback,
+        CancellationToken token = {});
+
+    /**
+     * Start a request of which the response payload is a specific type
+     * @param node The node to send the request to
+     * @param request The packets to send
+     * @param responseType The header type of the response
+     * @param timeout The maximum time the request may take
+     * @param callback Receives a copy of the response payload or the error that occurred
+     * @param token Aborts the request once cancelled
+     */
+    template <typename T>
+    void RequestAs(
+        const NodeAddress& node,
+        std::vector<char> request,
+        unsigned char responseType,
+        std::chrono::milliseconds timeout,
+        AsyncCallback<T> callback,
+        CancellationToken token = {});
+
+    /**
+     * Run a function on the engine thread once a delay passed, can be called from any thread
+     * including callbacks. Functions still waiting when the engine stops are discarded.
+     * @param delay The time to wait
+     * @param callback The function to run, must not block
+     * @param token The function is discarded if the token is cancelled before it runs
+     */
+    void RunAfter(
+        std::chrono::milliseconds delay,
+        std::function<void()> callback,
+        CancellationToken token = {});
+
+    /**
+     * Get the number of requests in flight
+     * @return The number of requests that have not completed yet
+     */
+    size_t GetPendingCount() const;
+
+    /**
+     * Get the backend in use
+     * @return The backend that drives the sockets
+     */
+    AsyncEngineBackend GetBackend() const;
+
+private:
+    friend class AsyncBackend;
+
+    /// Clock of the deadlines
+    typedef std::chrono::steady_clock Clock;
+
+    /**
+     * Run the event loop until stopped, then destroy the backend
+     */
+    void Run();
+
+    /**
+     * Hand a request to the engine thread
+     * @param operation The request
+     */
+    void Submit(std::unique_ptr<struct AsyncOperation> operation);
+
+    /**
+     * Start the submitted requests
+     */
+    void StartSubmitted();
+
+    /**
+     * Fail the requests that ran out of time or were cancelled
+     */
+    void FailExpired();
+
+    /**
+     * Run the functions of which the delay passed
+     */
+    void RunTimers();
+
+    /**
+     * Finish a request and call its callback
+     * @param id The id of the request
+     * @param result The response frame or the error that occurred
+     */
+    void Complete(unsigned long long id, tl::expected<const char*, ConnectionError> result);
+
+private:
+    /**
+     * Function waiting to run on the engine thread
+     */
+    struct Timer
+    {
+        /// The function to run
+        std::function<void()> callback;
+
+        /// Discard the function if cancelled
+        CancellationToken token;
+    };
+
+    /// Drives the sockets
+    std::unique_ptr<class AsyncBackend> m_backend;
+
+    /// Type of `m_backend`
+    AsyncEngineBackend m_backendType;
+
+    /// Requests not started yet, guarded by `m_mutex`
+    std::vector<std::unique_ptr<AsyncOperation>> m_submitted;
+
+    /// Requests in flight by id, only used by the engine thread
+    std::unordered_map<unsigned long long, std::unique_ptr<AsyncOperation>> m_operations;
+
+    /// Ids of requests in flight by deadline, only used by the engine thread
+    std::multimap<Clock::time_point, unsigned long long> m_deadlines;
+
+    /// Functions waiting to run by time, guarded by `m_mutex`
+    std::multimap<Clock::time_point, Timer> m_timers;
+
+    /// Last time the requests were checked for cancellation, only used by the engine thread
+    Clock::time_point m_lastCancellationCheck;
+
+    /// Id of the next request
+    unsigned long long m_nextId = 1;
+
+    /// Number of requests that have not completed yet
+    std::atomic<size_t> m_pendingCount{0};
+
+    /// Tell the engine thread to stop, guarded by `m_mutex`
+    bool m_bStop = false;
+
+    /// Guard for submitted requests and timers
+    mutable std::mutex m_mutex;
+
+    /// The engine thread
+    std::thread m_thread;
+};
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Create a request callback that hands a copy of the response payload to a typed callback
+ * @param callback Receives a copy of the response payload or the error that occurred
+ * @return The request callback
+ */
+template <typename T>
+RequestCallback CreatePayloadCallback(AsyncCallback<T> callback)
+{
+    return [callback = std::move(callback)](tl::expected<const char*, ConnectionError> frame) {
+        if (!frame.has_value())
+        {
+            callback(tl::make_unexpected(frame.error()));
+            return;
+        }
+
+        RequestResponseHeader header;
+        memcpy(&header, frame.value(), sizeof(header));
+        if (!header.checkPayloadSize(sizeof(T)))
+        {
+            callback(tl::make_unexpected(ConnectionError{
+                "Response of type " + std::to_string(header.type()) +
+                " had the size: " + std::to_string(header.getPayloadSize()) +
+                " instead of expected size: " + std::to_string(sizeof(T))}));
+            return;
+        }
+
+        T result;
+        memcpy((void*)&result, frame.value() + sizeof(header), sizeof(T));
+        callback(std::move(result));
+    };
+}
+
+// ------------------------------------------------------------------------------------------------
+template <typename T>
+void AsyncEngine::RequestAs(
+    const NodeAddress& node,
+    std::vector<char> request,
+    unsigned char responseType,
+    std::chrono::milliseconds timeout,
+    AsyncCallback<T> callback,
+    CancellationToken token)
+{
+    Request(
+        node,
+        std::move(request),
+        responseType,
+        true,
+        timeout,
+        CreatePayloadCallback(std::move(callback)),
+        std::move(token));
+}
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Create a callback that fulfills a promise, to wait for an asynchronous request with a future
+ * @param promise The promise to fulfill
+ * @return The callback
+ */
+template <typename T, typename E>
+std::function<void(tl::expected<T, E>)> FulfillPromise(
+    std::shared_ptr<std::promise<tl::expected<T, E>>> promise)
+{
+    return [promise = std::move(promise)](tl::expected<T, E> result) {
+        promise->set_value(std::move(result));
+    };
+}
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Connect to a node from a coroutine, see `AsyncEngine::Connect`
+ * @param engine The engine to connect on
+ * @param node The node to connect to
+ * @param timeout The maximum time to wait for the connection to be accepted
+ * @param token Aborts connecting once cancelled
+ * @return The task that produces the connection or the error that occurred
+ */
+Task<tl::expected<ConnectionPtr, ConnectionError>> CreateConnectionTask(
+    AsyncEngine& engine,
+    NodeAddress node,
+    std::chrono::milliseconds timeout = AsyncEngine::defaultTimeout,
+    CancellationToken token = {});
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "network/connection.hpp"
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Outcome of sending data to one node
+ */
+struct NodeBroadcastResult
+{
+    /// The node
+    NodeAddress node;
+
+    /// `true` if the node accepted all data, else `false`
+    bool bAccepted;
+
+    /// The error that occurred if the data was not accepted
+    std::string error;
+
+    /// Time from connecting until the data was accepted or the attempt failed
+    std::chrono::milliseconds elapsed;
+};
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Send identical data to multiple nodes at once, e.g. signed transactions. The data is more
+ * likely to reach the computors in time through several nodes, and a slow node no longer delays
+ * the broadcast: every node gets its own connection and the same timeout, so this returns within
+ * about `timeout` regardless of the number of nodes.
+ * @param nodes The nodes to send to
+ * @param data The data to send
+ * @param size The size of the data in bytes
+ * @param timeout The maximum time to connect, and the maximum time to send, per node
+ * @return The outcome of each node, in the order of `nodes`
+ */
+std::vector<NodeBroadcastResult> BroadcastToNodes(
+    const std::vector<NodeAddress>& nodes,
+    const char* data,
+    size_t size,
+    std::chrono::milliseconds timeout);
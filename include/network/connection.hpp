@@ -2,10 +2,14 @@
 
 #include <tl/expected.hpp>
 
+#include <chrono>
+#include <cstdint>
 #include <cstring>
 #include <memory>
 #include <string>
+#include <vector>
 
+#include "cancellation_token.hpp"
 #include "network_messages/header.h"
 
 // ------------------------------------------------------------------------------------------------
@@ -23,6 +27,91 @@ struct ConnectionError
     std::string message;
 };
 
+// ------------------------------------------------------------------------------------------------
+/**
+ * Address of a node
+ */
+struct NodeAddress
+{
+    /// The ip-address of the node
+    std::string ipAddress;
+
+    /// The port of the node
+    unsigned short port;
+};
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Time limit and cancellation token of a network call, from connecting until the last receive
+ */
+struct Deadline
+{
+    /// Clock of the deadline
+    typedef std::chrono::steady_clock Clock;
+
+    /// Time at which the call fails, never by default
+    Clock::time_point time = Clock::time_point::max();
+
+    /// Aborts the call once cancelled
+    CancellationToken token;
+
+    /**
+     * Create a deadline relative to now
+     * @param timeout The maximum time the call may take
+     * @param token The token to abort the call
+     * @return The deadline
+     */
+    static Deadline After(std::chrono::milliseconds timeout, CancellationToken token = {});
+
+    /**
+     * Check if the call must stop
+     * @return The reason to stop, else nothing
+     */
+    tl::expected<void, ConnectionError> Check() const;
+};
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Default time a connection may take to be accepted
+ */
+constexpr std::chrono::milliseconds defaultConnectTimeout{5000};
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Outcome of searching received data for a frame
+ */
+struct FrameSearch
+{
+    enum Status
+    {
+        /// The frame is complete at `offset`
+        Found,
+
+        /// More data is needed, frames before `offset` can be discarded and the frame at `offset`
+        /// needs `size` bytes
+        Incomplete,
+
+        /// The frame at `offset` has an invalid size `size`, the data can't be parsed further
+        Invalid
+    } status;
+
+    /// Offset of the frame
+    size_t offset;
+
+    /// Size of the frame
+    size_t size;
+};
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Search received data for the first frame of a specific type, bounds-safe
+ * @param data The received data, starting at a frame
+ * @param size The size of the received data in bytes
+ * @param headerType The type (index) of the header
+ * @return Where the frame is, or why it wasn't found
+ */
+FrameSearch FindFrame(const char* data, size_t size, unsigned char headerType);
+
 // ------------------------------------------------------------------------------------------------
 /**
  * Socket wrapper
@@ -38,11 +127,16 @@ private:
 
 public:
     /**
-     * Factory function
+     * Factory functions
      */
     friend tl::expected<ConnectionPtr, ConnectionError> CreateConnection(
         const std::string& ipAddress,
         unsigned short port);
+    friend tl::expected<ConnectionPtr, ConnectionError> CreateConnection(
+        const std::string& ipAddress,
+        unsigned short port,
+        const Deadline& deadline);
+    friend ConnectionPtr CreateConnection(long socket);
 
     Connection(Connection&& other) noexcept;
     Connection(const Connection&) = delete;
@@ -59,7 +153,27 @@ public:
     bool Send(char* buffer, int bufferLength) const;
 
     /**
-     * Receive data
+     * Set the send and receive timeout
+     * @param timeout The maximum time a single send or receive may block
+     * @return `true` upon success, else `false`
+     */
+    bool SetTimeout(std::chrono::milliseconds timeout) const;
+
+    /**
+     * Set the deadline of the calls on this connection, sends and receives fail once it expires or
+     * its token is cancelled
+     * @param deadline The deadline
+     */
+    void SetDeadline(Deadline deadline) const;
+
+    /**
+     * Get the deadline of the calls on this connection
+     * @return The deadline
+     */
+    const Deadline& GetDeadline() const;
+
+    /**
+     * Receive data until the connection times out
      * @return The received data
      */
     std::vector<char> Receive() const;
@@ -72,42 +186,112 @@ public:
     template <typename T>
     tl::expected<T, ConnectionError> ReceiveAs(unsigned char headerType) const;
 
+    /**
+     * Receive data as a specific type without copying it out of the receive buffer
+     * @param headerType The type (index) of the header that should contain the data
+     * @return The data, valid until the next receive on this connection, or encountered error
+     */
+    template <typename T>
+    tl::expected<const T*, ConnectionError> ReceiveView(unsigned char headerType) const;
+
+    /**
+     * Receive until a complete frame of a specific type is buffered, returns as soon as it is
+     * @param headerType The type (index) of the header
+     * @return The frame, header included, valid until the next receive on this connection, or
+     * encountered error
+     */
+    tl::expected<const char*, ConnectionError> ReceiveFrame(unsigned char headerType) const;
+
+private:
+    /**
+     * Copy a payload to storage aligned for any type
+     * @param payload The payload
+     * @param size The size of the payload in bytes
+     * @return The aligned copy, valid until the next receive on this connection
+     */
+    const char* AlignPayload(const char* payload, size_t size) const;
+
+    /**
+     * Wait until the socket is ready, a time passes or the deadline stops the call
+     * @param bWrite `true` to wait until data can be sent, `false` until data can be received
+     * @param until The time to give up waiting
+     * @return `true` if ready, `false` if `until` passed, else the reason the deadline stopped
+     * the call
+     */
+    tl::expected<bool, ConnectionError> Wait(bool bWrite, Deadline::Clock::time_point until) const;
+
 private:
+    /// Longest wait before the token is checked again
+    static constexpr std::chrono::milliseconds cancellationInterval{50};
+
+    /**
+     * Unit of the receive buffers, frames at the start of the buffer are aligned for any type
+     */
+    struct alignas(64) ReceiveBlock
+    {
+        char bytes[64];
+    };
+
     long m_socket;
+
+    /// Maximum time a single send or receive may block
+    mutable std::chrono::milliseconds m_timeout{1000};
+
+    /// Deadline of the calls on this connection
+    mutable Deadline m_deadline;
+
+    /// Received data, reused by every receive so it only grows to the largest response
+    mutable std::vector<ReceiveBlock> m_receiveBuffer;
+
+    /// Number of bytes in the receive buffer
+    mutable size_t m_receivedSize = 0;
+
+    /// Number of bytes at the start of the receive buffer that have been handed out already
+    mutable size_t m_consumedSize = 0;
+
+    /// Storage for payloads that are not aligned inside the receive buffer
+    mutable std::vector<ReceiveBlock> m_alignedPayload;
 };
 
 // ------------------------------------------------------------------------------------------------
 template <typename T>
 tl::expected<T, ConnectionError> Connection::ReceiveAs(unsigned char headerType) const
 {
-    std::vector<char> buffer = Receive();
-    if (buffer.empty())
+    auto view = ReceiveView<T>(headerType);
+    if (!view.has_value())
     {
-        return tl::make_unexpected(ConnectionError{"Connection failed to get a response"});
+        return tl::make_unexpected(view.error());
+    }
+    return *view.value();
+}
+
+// ------------------------------------------------------------------------------------------------
+template <typename T>
+tl::expected<const T*, ConnectionError> Connection::ReceiveView(unsigned char headerType) const
+{
+    auto frame = ReceiveFrame(headerType);
+    if (!frame.has_value())
+    {
+        return tl::make_unexpected(frame.error());
     }
 
-    for (int offset = 0; offset < buffer.size();)
+    // todo: there's also a function to check min/max, which packets have dynamic size?
+    RequestResponseHeader header;
+    memcpy(&header, frame.value(), sizeof(header));
+    if (!header.checkPayloadSize(sizeof(T)))
     {
-        auto* header = reinterpret_cast<RequestResponseHeader*>(buffer.data() + offset);
-        if (header->type() == headerType)
-        {
-            // todo: there's also a function to check min/max, which packets have dynamic size?
-            if (header->checkPayloadSize(sizeof(T)))
-            {
-                T result = *header->getPayload<T>();
-                return result;
-            }
-            return tl::make_unexpected(ConnectionError{
-                "Response of type " + std::to_string(header->type()) +
-                " had the size: " + std::to_string(header->getPayloadSize()) +
-                " instead of expected size: " + std::to_string(sizeof(T))});
-        }
-
-        offset += header->size();
+        return tl::make_unexpected(ConnectionError{
+            "Response of type " + std::to_string(header.type()) +
+            " had the size: " + std::to_string(header.getPayloadSize()) +
+            " instead of expected size: " + std::to_string(sizeof(T))});
     }
 
-    return tl::make_unexpected(ConnectionError{
-        "Response did not contain header type: " + std::to_string((int)headerType)});
+    const char* payload = frame.value() + sizeof(header);
+    if (reinterpret_cast<uintptr_t>(payload) % alignof(T) != 0)
+    {
+        payload = AlignPayload(payload, sizeof(T));
+    }
+    return reinterpret_cast<const T*>(payload);
 }
 
 // ------------------------------------------------------------------------------------------------
@@ -124,12 +308,47 @@ bool DestroyConnection();
 
 // ------------------------------------------------------------------------------------------------
 /**
- * Create a new connection
+ * Create a new connection, giving up if the node doesn't accept it within `defaultConnectTimeout`
  */
 tl::expected<ConnectionPtr, ConnectionError> CreateConnection(
     const std::string& ipAddress,
     unsigned short port);
 
+// ------------------------------------------------------------------------------------------------
+/**
+ * Create a new connection, giving up if the node doesn't accept it in time
+ * @param ipAddress The ip-address of the node
+ * @param port The port of the node
+ * @param timeout The maximum time to wait for the connection to be accepted
+ * @return The connection upon success, else the error that occurred
+ */
+tl::expected<ConnectionPtr, ConnectionError> CreateConnection(
+    const std::string& ipAddress,
+    unsigned short port,
+    std::chrono::milliseconds timeout);
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Create a new connection of which every call shares one deadline, e.g. to bound a request from
+ * connecting until the response or to abort it once the user navigates away
+ * @param ipAddress The ip-address of the node
+ * @param port The port of the node
+ * @param deadline The deadline of connecting and of the calls on the connection
+ * @return The connection upon success, else the error that occurred
+ */
+tl::expected<ConnectionPtr, ConnectionError> CreateConnection(
+    const std::string& ipAddress,
+    unsigned short port,
+    const Deadline& deadline);
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Take ownership of a connected socket, e.g. one connected by an `AsyncEngine`
+ * @param socket The connected socket, switched to blocking mode
+ * @return The connection
+ */
+ConnectionPtr CreateConnection(long socket);
+
 // ------------------------------------------------------------------------------------------------
 /**
  * Check if string contains a valid ip-address
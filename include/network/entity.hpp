@@ -2,7 +2,11 @@
 
 #include <tl/expected.hpp>
 
+#include "network/async_engine.hpp"
 #include "network/connection.hpp"
+#include "network/hedging.hpp"
+#include "network/node_registry.hpp"
+#include "network/request_coalescer.hpp"
 #include "network_messages/entity.h"
 
 // ------------------------------------------------------------------------------------------------
@@ -26,3 +30,108 @@ tl::expected<RespondedEntity, ConnectionError> GetEntity(
 tl::expected<unsigned long long, ConnectionError> GetBalance(
     const ConnectionPtr& connection,
     const std::string& identity);
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Query entity from the best node of a registry, sharing the request with concurrent queries of
+ * the same entity
+ * @param coalescer The coalescer to share the request through, only used with this registry
+ * @param registry The registry to select the node from
+ * @param identity The identity of the entity to query
+ * @param deadline The deadline of the request, shared by the queries that join it
+ * @return The entity or an error
+ */
+tl::expected<RespondedEntity, ConnectionError> GetEntity(
+    RequestCoalescer& coalescer,
+    NodeRegistry& registry,
+    const std::string& identity,
+    const Deadline& deadline);
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Get balance of an entity from the best node of a registry, sharing the request with concurrent
+ * queries of the same entity
+ * @param coalescer The coalescer to share the request through, only used with this registry
+ * @param registry The registry to select the node from
+ * @param identity The identity of the entity to query
+ * @param deadline The deadline of the request, shared by the queries that join it
+ * @return The balance or an error
+ */
+tl::expected<unsigned long long, ConnectionError> GetBalance(
+    RequestCoalescer& coalescer,
+    NodeRegistry& registry,
+    const std::string& identity,
+    const Deadline& deadline);
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Query entity without blocking, see `GetEntity`
+ * @param engine The engine to run the request on
+ * @param node The node to query
+ * @param identity The identity of the entity to query
+ * @param callback Receives the entity or an error, on the engine thread
+ * @param timeout The maximum time the request may take
+ * @param token Aborts the request once cancelled
+ */
+void GetEntityAsync(
+    AsyncEngine& engine,
+    const NodeAddress& node,
+    const std::string& identity,
+    AsyncCallback<RespondedEntity> callback,
+    std::chrono::milliseconds timeout = AsyncEngine::defaultTimeout,
+    CancellationToken token = {});
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Query entity from the first of several nodes to respond
+ * @param hedger The hedger to run the request on
+ * @param nodes The nodes to query, best first
+ * @param identity The identity of the entity to query
+ * @param callback Receives the entity or an error, on the engine thread
+ * @param timeout The maximum time the request may take
+ * @param token Aborts the request once cancelled
+ */
+void GetEntityAsync(
+    RequestHedger& hedger,
+    const std::vector<NodeAddress>& nodes,
+    const std::string& identity,
+    AsyncCallback<RespondedEntity> callback,
+    std::chrono::milliseconds timeout = AsyncEngine::defaultTimeout,
+    CancellationToken token = {});
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Get balance of an entity on which several nodes agree, see `RequestAgreedAs`
+ * @param engine The engine to run the requests on
+ * @param nodes The nodes to query
+ * @param identity The identity of the entity to query
+ * @param requiredCount The number of nodes that must report the same balance
+ * @param callback Receives the balance or an error, on the engine thread
+ * @param timeout The maximum time the requests may take
+ * @param token Aborts the requests once cancelled
+ */
+void GetBalanceAsync(
+    AsyncEngine& engine,
+    const std::vector<NodeAddress>& nodes,
+    const std::string& identity,
+    size_t requiredCount,
+    AsyncCallback<unsigned long long> callback,
+    std::chrono::milliseconds timeout = AsyncEngine::defaultTimeout,
+    CancellationToken token = {});
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Query entity from a coroutine, see `GetEntity`
+ * @param engine The engine to run the request on
+ * @param node The node to query
+ * @param identity The identity of the entity to query
+ * @param timeout The maximum time the request may take
+ * @param token Aborts the request once cancelled
+ * @return The task that produces the entity or an error
+ */
+Task<tl::expected<RespondedEntity, ConnectionError>> GetEntityTask(
+    AsyncEngine& engine,
+    NodeAddress node,
+    std::string identity,
+    std::chrono::milliseconds timeout = AsyncEngine::defaultTimeout,
+    CancellationToken token = {});
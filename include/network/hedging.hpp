@@ -0,0 +1,263 @@
+#pragma once
+
+#include <tl/expected.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "network/async_engine.hpp"
+#include "network/latency_tracker.hpp"
+#include "network/node_registry.hpp"
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * When a hedged request asks another node
+ */
+struct HedgingPolicy
+{
+    /// Quantile of the observed latency after which the next node is asked
+    double quantile = 0.9;
+
+    /// Number of observed latencies before the quantile is trusted
+    size_t minimumSampleCount = 10;
+
+    /// Delay before the next node is asked while too few latencies were observed
+    std::chrono::milliseconds defaultDelay{500};
+
+    /// Shortest delay before the next node is asked
+    std::chrono::milliseconds minimumDelay{10};
+
+    /// Maximum number of nodes asked by one request, the first one included
+    size_t maximumAttempts = 2;
+};
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Sends read-only requests to several nodes, the first response wins
+ *
+ * A request goes to the first node. If no response arrived once the observed latency quantile
+ * passed, e.g. the p90, the same request goes to the next node, and so on. A failing node is
+ * replaced right away. The first response completes the request and the others are cancelled, so
+ * a single slow node no longer drives the tail latency. The latencies are observed by the hedger
+ * itself, from the responses that won.
+ *
+ * With a node registry, the outcome of every request to a node is reported to it, a node is given
+ * its own timeout, and the next node is asked once the latency quantile of the node passed.
+ */
+class RequestHedger
+{
+public:
+    /**
+     * Constructor
+     * @param engine The engine to run the requests on, must outlive the requests
+     * @param policy When to ask another node
+     */
+    explicit RequestHedger(AsyncEngine& engine, HedgingPolicy policy = {});
+
+    /**
+     * Constructor
+     * @param engine The engine to run the requests on, must outlive the requests
+     * @param registry Receives the outcomes and gives the timeouts, must outlive the requests
+     * @param policy When to ask another node
+     */
+    RequestHedger(AsyncEngine& engine, NodeRegistry& registry, HedgingPolicy policy = {});
+
+    /**
+     * Start a hedged request, can be called from any thread including callbacks
+     * @param nodes The nodes to ask, best first
+     * @param request The packets to send
+     * @param responseType The header type of the response
+     * @param timeout The maximum time the request may take, over all nodes
+     * @param callback Receives the first response frame, or the last error if every node failed
+     * @param token Aborts the request once cancelled
+     */
+    void Request(
+        const std::vector<NodeAddress>& nodes,
+        std::vector<char> request,
+        unsigned char responseType,
+        std::chrono::milliseconds timeout,
+        RequestCallback callback,
+        CancellationToken token = {});
+
+    /**
+     * Start a hedged request of which the response payload is a specific type
+     * @param nodes The nodes to ask, best first
+     * @param request The packets to send
+     * @param responseType The header type of the response
+     * @param timeout The maximum time the request may take, over all nodes
+     * @param callback Receives a copy of the first response payload or the last error
+     * @param token Aborts the request once cancelled
+     */
+    template <typename T>
+    void RequestAs(
+        const std::vector<NodeAddress>& nodes,
+        std::vector<char> request,
+        unsigned char responseType,
+        std::chrono::milliseconds timeout,
+        AsyncCallback<T> callback,
+        CancellationToken token = {});
+
+    /**
+     * Get the time after which the next node is asked
+     * @return The delay
+     */
+    std::chrono::milliseconds GetDelay() const;
+
+    /**
+     * Get the observed latencies
+     * @return The latencies of the responses that won
+     */
+    const LatencyTracker& GetLatencies() const;
+
+private:
+    /// Runs the requests
+    AsyncEngine& m_engine;
+
+    /// Registry of the nodes, if any
+    NodeRegistry* m_registry = nullptr;
+
+    /// When to ask another node
+    HedgingPolicy m_policy;
+
+    /// Shared with the requests in flight, which may complete after the hedger is gone
+    std::shared_ptr<LatencyTracker> m_latencies;
+};
+
+// ------------------------------------------------------------------------------------------------
+template <typename T>
+void RequestHedger::RequestAs(
+    const std::vector<NodeAddress>& nodes,
+    std::vector<char> request,
+    unsigned char responseType,
+    std::chrono::milliseconds timeout,
+    AsyncCallback<T> callback,
+    CancellationToken token)
+{
+    Request(
+        nodes,
+        std::move(request),
+        responseType,
+        timeout,
+        CreatePayloadCallback(std::move(callback)),
+        std::move(token));
+}
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Send a request to several nodes and only accept a response on which enough of them agree, e.g.
+ * to not trust a single node with a balance. The remaining requests are cancelled once enough
+ * nodes agree, or once they no longer can.
+ * @param engine The engine to run the requests on
+ * @param nodes The nodes to ask, all at once
+ * @param request The packets to send
+ * @param responseType The header type of the response
+ * @param requiredCount The number of nodes that must agree
+ * @param key Maps a response payload to what must be equal, e.g. the balance of an entity
+ * @param timeout The maximum time the requests may take
+ * @param callback Receives a response on which `requiredCount` nodes agree, or an error
+ * @param token Aborts the requests once cancelled
+ */
+template <typename T, typename F>
+void RequestAgreedAs(
+    AsyncEngine& engine,
+    const std::vector<NodeAddress>& nodes,
+    const std::vector<char>& request,
+    unsigned char responseType,
+    size_t requiredCount,
+    F key,
+    std::chrono::milliseconds timeout,
+    AsyncCallback<T> callback,
+    CancellationToken token = {})
+{
+    typedef std::invoke_result_t<F&, const T&> Key;
+
+    if (requiredCount == 0 || nodes.size() < requiredCount)
+    {
+        callback(tl::make_unexpected(ConnectionError{
+            "Agreement of " + std::to_string(requiredCount) + " nodes required, but " +
+            std::to_string(nodes.size()) + " nodes given"}));
+        return;
+    }
+
+    // Only touched by the callbacks, which all run on the engine thread
+    struct State
+    {
+        F key;
+        AsyncCallback<T> callback;
+        CancellationToken token;
+        size_t requiredCount;
+        size_t pendingCount;
+        std::vector<std::pair<Key, size_t>> votes;
+        std::optional<ConnectionError> lastError;
+        bool bDone = false;
+    };
+    auto state = std::make_shared<State>(State{
+        std::move(key),
+        std::move(callback),
+        token.CreateLinked(),
+        requiredCount,
+        nodes.size()});
+
+    for (const auto& node : nodes)
+    {
+        engine.RequestAs<T>(
+            node,
+            request,
+            responseType,
+            timeout,
+            [state](tl::expected<T, ConnectionError> response) {
+                if (state->bDone)
+                {
+                    return;
+                }
+                --state->pendingCount;
+
+                if (response.has_value())
+                {
+                    auto responseKey = state->key(response.value());
+                    auto vote = std::find_if(
+                        state->votes.begin(),
+                        state->votes.end(),
+                        [&](const auto& vote) { return vote.first == responseKey; });
+                    if (vote == state->votes.end())
+                    {
+                        vote = state->votes.insert(vote, {std::move(responseKey), 0});
+                    }
+                    if (++vote->second == state->requiredCount)
+                    {
+                        state->bDone = true;
+                        state->token.Cancel();
+                        state->callback(std::move(response));
+                        return;
+                    }
+                }
+                else
+                {
+                    state->lastError = response.error();
+                }
+
+                size_t agreedCount = 0;
+                for (const auto& vote : state->votes)
+                {
+                    agreedCount = std::max(agreedCount, vote.second);
+                }
+                if (agreedCount + state->pendingCount < state->requiredCount)
+                {
+                    state->bDone = true;
+                    state->token.Cancel();
+                    state->callback(tl::make_unexpected(
+                        state->votes.empty() ? state->lastError.value()
+                                             : ConnectionError{
+                                                   "Only " + std::to_string(agreedCount) + " of " +
+                                                   std::to_string(state->requiredCount) +
+                                                   " required nodes agreed"}));
+                }
+            },
+            state->token);
+    }
+}
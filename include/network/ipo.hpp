@@ -0,0 +1,83 @@
+#pragma once
+
+#include <tl/expected.hpp>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "network/tick_tracker.hpp"
+#include "network/transactions.hpp"
+#include "network_messages/contract.h"
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Get the current bids of a contract IPO, one winning bid per share
+ * @param connection The node to query
+ * @param contractIndex The index of the contract
+ * @return The IPO upon success, else a connection error
+ */
+tl::expected<RespondContractIPO, ConnectionError> GetContractIPO(
+    const ConnectionPtr& connection,
+    unsigned int contractIndex);
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Get the lowest price that currently wins a share, a new bid must exceed it
+ * @param ipo The bids of the IPO
+ * @return The lowest price of all shares, zero while some share has no bid
+ */
+long long GetMinimumWinningPrice(const RespondContractIPO& ipo);
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Get the number of shares an identity currently wins
+ * @param ipo The bids of the IPO
+ * @param publicKey The 32-byte public key of the bidder
+ * @return The number of shares
+ */
+unsigned int GetWinningShareCount(const RespondContractIPO& ipo, const unsigned char* publicKey);
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Add a signed IPO bid, a procedure call on the contract with a `ContractIPOBid` as input
+ * @param builder The builder to add the bid to
+ * @param contractIndex The index of the contract
+ * @param price The price per share
+ * @param quantity The number of shares, at most `NUMBER_OF_COMPUTORS`
+ * @param tick The tick at which the bid should be executed
+ * @return The receipt upon success, else the error that occurred
+ */
+tl::expected<Receipt, TransactionError> AddIPOBid(
+    TransactionBuilder& builder,
+    unsigned int contractIndex,
+    long long price,
+    unsigned short quantity,
+    unsigned int tick);
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Submit an IPO bid for an exact tick, e.g. the last ticks of the epoch. Blocks until the tick
+ * tracker predicts the bid's tick is `leadTicks` ahead, then signs it and broadcasts it to all
+ * nodes at once.
+ * @param nodes The nodes to broadcast to
+ * @param signingKey The signing key of the bidder
+ * @param tickTracker The tracker that predicts the current tick
+ * @param contractIndex The index of the contract
+ * @param price The price per share
+ * @param quantity The number of shares
+ * @param tick The tick at which the bid should be executed
+ * @param leadTicks The number of ticks ahead of `tick` to broadcast, see `TickOffsetEstimator`
+ * @param timeout The maximum time to connect, and the maximum time to send, per node
+ * @return The receipt upon success, else the error that occurred, e.g. the tick was missed
+ */
+tl::expected<Receipt, TransactionError> SubmitIPOBidAtTick(
+    const std::vector<NodeAddress>& nodes,
+    const SigningKeyPtr& signingKey,
+    const TickTracker& tickTracker,
+    unsigned int contractIndex,
+    long long price,
+    unsigned short quantity,
+    unsigned int tick,
+    unsigned int leadTicks,
+    std::chrono::milliseconds timeout);
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <optional>
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Window of recent response times, to derive delays and timeouts from the observed distribution
+ * instead of fixed values. The tracker is thread-safe.
+ */
+class LatencyTracker
+{
+public:
+    /**
+     * Constructor
+     * @param maximumSamples The number of recent latencies to keep
+     */
+    explicit LatencyTracker(size_t maximumSamples = 128);
+
+    /**
+     * Add the time a response took
+     * @param latency The latency
+     */
+    void AddLatency(std::chrono::milliseconds latency);
+
+    /**
+     * Get a quantile of the recent latencies
+     * @param probability The fraction of latencies at or below the quantile, in [0, 1]
+     * @return The quantile, or nothing if no latency was added yet
+     */
+    std::optional<std::chrono::milliseconds> GetQuantile(double probability) const;
+
+    /**
+     * Get the number of recent latencies
+     * @return The number of latencies in the window
+     */
+    size_t GetSampleCount() const;
+
+private:
+    /// Number of recent latencies to keep
+    size_t m_maximumSamples;
+
+    /// Recent latencies
+    std::deque<std::chrono::milliseconds> m_latencies;
+
+    /// Guard for the latencies
+    mutable std::mutex m_mutex;
+};
@@ -0,0 +1,239 @@
+#pragma once
+
+#include <tl/expected.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "network/connection.hpp"
+#include "network/latency_tracker.hpp"
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Health of a node as observed by the registry
+ */
+struct NodeHealth
+{
+    /// Clock of the observations
+    typedef std::chrono::steady_clock Clock;
+
+    /// The node
+    NodeAddress node;
+
+    /// Moving average of the round trip time in milliseconds, zero if unknown
+    double roundTripTime = 0.0;
+
+    /// Moving average of the fraction of failed calls
+    double errorRate = 0.0;
+
+    /// Number of calls that failed in a row
+    unsigned int consecutiveFailures = 0;
+
+    /// Highest tick the node reported, zero if unknown
+    unsigned int lastTick = 0;
+
+    /// Number of ticks the node is behind the highest tick of all nodes, zero if unknown
+    unsigned int tickLag = 0;
+
+    /// Last time a call succeeded
+    std::optional<Clock::time_point> lastSeen;
+
+    /// Time until which the circuit breaker keeps the node out of selection, if open
+    std::optional<Clock::time_point> retryTime;
+};
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Tracks the health of nodes and picks the ones to call
+ *
+ * Every call reports its outcome: a round trip time and a tick upon success, else a failure. The
+ * registry keeps moving averages of the round trip time and error rate, the latency distribution
+ * and the tick lag of each node. Nodes are selected by a score of these, the fastest, most reliable
+ * and most current first. A node that fails several calls in a row trips its circuit breaker and
+ * is skipped until its backoff passed, which doubles every time it trips again. Once the backoff
+ * passed, the node is selected after the healthy ones so that a call can find out if it is back.
+ * The timeout of a call to a node follows the latencies observed of it. The registry is
+ * thread-safe.
+ */
+class NodeRegistry
+{
+public:
+    /// Clock of the observations
+    typedef NodeHealth::Clock Clock;
+
+    /// Timeout of a node until enough latencies are known
+    static constexpr std::chrono::milliseconds defaultTimeout{5000};
+
+    /// Shortest timeout of a node
+    static constexpr std::chrono::milliseconds minimumTimeout{250};
+
+    /// Number of failed calls in a row that trips the circuit breaker
+    static constexpr unsigned int failureThreshold = 3;
+
+    /// Backoff of a node the first time its circuit breaker trips
+    static constexpr std::chrono::milliseconds minimumBackoff{1000};
+
+    /// Longest backoff of a node
+    static constexpr std::chrono::milliseconds maximumBackoff{300000};
+
+    /**
+     * Add a node, nothing happens if it was added already
+     * @param node The node
+     */
+    void AddNode(const NodeAddress& node);
+
+    /**
+     * Add a node of which the round trip time is known from before, e.g. from a saved peer table,
+     * nothing happens if it was added already
+     * @param node The node
+     * @param roundTripTime The round trip time of the node, zero if unknown
+     */
+    void AddNode(const NodeAddress& node, std::chrono::milliseconds roundTripTime);
+
+    /**
+     * Remove a node
+     * @param node The node
+     */
+    void RemoveNode(const NodeAddress& node);
+
+    /**
+     * Report a successful call
+     * @param node The node that was called, added if unknown
+     * @param roundTripTime The time of a round trip to the node
+     */
+    void ReportSuccess(const NodeAddress& node, std::chrono::milliseconds roundTripTime);
+
+    /**
+     * Report a failed call, cancelled calls should not be reported
+     * @param node The node that was called, added if unknown
+     */
+    void ReportFailure(const NodeAddress& node);
+
+    /**
+     * Report the current tick of a node
+     * @param node The node, added if unknown
+     * @param tick The tick the node is at
+     */
+    void ReportTick(const NodeAddress& node, unsigned int tick);
+
+    /**
+     * Select the nodes to call
+     * @param count The maximum number of nodes
+     * @return The nodes of which the circuit breaker is closed, best first, followed by the nodes
+     * of which the backoff passed
+     */
+    std::vector<NodeAddress> SelectNodes(size_t count = SIZE_MAX) const;
+
+    /**
+     * Get the timeout of a call to a node
+     * @param node The node
+     * @return The timeout, derived from the latencies observed of the node
+     */
+    std::chrono::milliseconds GetTimeout(const NodeAddress& node) const;
+
+    /**
+     * Get a quantile of the latencies observed of a node
+     * @param node The node
+     * @param probability The fraction of latencies at or below the quantile, in [0, 1]
+     * @return The quantile, or nothing if the node has too few latencies
+     */
+    std::optional<std::chrono::milliseconds> GetLatency(const NodeAddress& node, double probability)
+        const;
+
+    /**
+     * Get the health of all nodes
+     * @return The health of every node, in no particular order
+     */
+    std::vector<NodeHealth> GetHealth() const;
+
+private:
+    /**
+     * Observations of a node
+     */
+    struct Entry
+    {
+        /// Health of the node, the tick lag is derived when read
+        NodeHealth health;
+
+        /// Recent latencies
+        LatencyTracker latencies;
+
+        /// Backoff the next time the circuit breaker trips
+        std::chrono::milliseconds backoff = minimumBackoff;
+    };
+
+    /**
+     * Find or add a node, requires `m_mutex`
+     * @param node The node
+     * @return The entry of the node
+     */
+    Entry& GetEntry(const NodeAddress& node);
+
+    /**
+     * Get the health of a node with its tick lag, requires `m_mutex`
+     * @param entry The entry of the node
+     * @return The health
+     */
+    NodeHealth GetHealth(const Entry& entry) const;
+
+private:
+    /// Weight of a new round trip time in the moving average
+    static constexpr double roundTripTimeWeight = 0.2;
+
+    /// Weight of a new outcome in the moving error rate
+    static constexpr double errorRateWeight = 0.1;
+
+    /// Number of latencies of a node before its timeout follows them
+    static constexpr size_t minimumLatencyCount = 5;
+
+    /// Quantile of the latencies that the timeout is a multiple of
+    static constexpr double timeoutQuantile = 0.99;
+
+    /// Multiple of the latency quantile that a call may take
+    static constexpr double timeoutFactor = 3.0;
+
+    /// Round trip time assumed of a node that has none yet, in milliseconds
+    static constexpr double unknownRoundTripTime = 500.0;
+
+    /// Penalty of a tick of lag in the score, in milliseconds
+    static constexpr double tickLagPenalty = 1000.0;
+
+    /// Nodes by address
+    std::map<std::string, Entry> m_entries;
+
+    /// Highest tick of all nodes
+    unsigned int m_highestTick = 0;
+
+    /// Guard for all members above
+    mutable std::mutex m_mutex;
+};
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Connect to a node, reporting the outcome and the time the connection took to the registry
+ * @param registry The registry of the node
+ * @param node The node to connect to
+ * @param deadline The deadline of the connection, connecting is further limited by the timeout of
+ * the node
+ * @return The connection upon success, else the error that occurred
+ */
+tl::expected<ConnectionPtr, ConnectionError> CreateConnection(
+    NodeRegistry& registry,
+    const NodeAddress& node,
+    const Deadline& deadline = {});
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Connect to the best node of a registry that accepts the connection, in order of selection
+ * @param registry The registry to select the node from
+ * @param deadline The deadline of the connection
+ * @return The connection upon success, else the last error that occurred
+ */
+tl::expected<ConnectionPtr, ConnectionError> CreateConnection(
+    NodeRegistry& registry,
+    const Deadline& deadline = {});
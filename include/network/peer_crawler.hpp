@@ -0,0 +1,169 @@
+#pragma once
+
+#include <tl/expected.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cancellation_token.hpp"
+#include "network/connection.hpp"
+#include "network/node_registry.hpp"
+#include "network_messages/public_peers.h"
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Discovers nodes through the peers that nodes share, and keeps the best of them on disk
+ *
+ * A node sends `ExchangePublicPeers` right after accepting a connection. The crawler connects to
+ * the nodes of a registry, collects the peers they share and adds them to the registry, then
+ * probes the new peers in turn until no new peers turn up. Every probe is a connection and a
+ * `CurrentTickInfo` request, so the registry learns the round trip time and tick of each node and
+ * ranks them. All nodes of a round are probed at once. Discovered peers that never answered are
+ * dropped once their circuit breaker trips and not added again, so that stale addresses don't
+ * take the place of live ones. The ranked nodes are written to a peer table after every round, from
+ * which a client starts with the fastest nodes of its previous run.
+ */
+class PeerCrawler
+{
+public:
+    /// Clock of the rounds
+    typedef std::chrono::steady_clock Clock;
+
+    /// Default time between rounds
+    static constexpr std::chrono::milliseconds defaultInterval{60000};
+
+    /// Time a probe may take, from connecting until the tick info is received
+    static constexpr std::chrono::milliseconds probeTimeout{5000};
+
+    /// Number of nodes in the registry above which discovered peers are no longer added
+    static constexpr size_t maximumNodeCount = 64;
+
+    /// Number of nodes written to the peer table at most
+    static constexpr size_t maximumSavedCount = 32;
+
+    /**
+     * Constructor, nothing is crawled until started
+     * @param registry The registry to crawl from and add peers to, must outlive the crawler
+     * @param tablePath The peer table to write after every round, none if empty
+     * @param interval The time between rounds
+     */
+    explicit PeerCrawler(
+        NodeRegistry& registry,
+        std::string tablePath = {},
+        std::chrono::milliseconds interval = defaultInterval);
+
+    PeerCrawler(const PeerCrawler&) = delete;
+    PeerCrawler& operator=(const PeerCrawler&) = delete;
+
+    /**
+     * Destructor, aborts the running round and stops crawling
+     */
+    ~PeerCrawler();
+
+    /**
+     * Start crawling in the background, nothing happens if started already
+     */
+    void Start();
+
+    /**
+     * Crawl one round on the calling thread, done by the background thread every interval
+     * @param token The token to abort the round
+     * @return The number of peers added to the registry
+     */
+    size_t Crawl(const CancellationToken& token = {});
+
+    /**
+     * Probe a node: receive the peers it shares and its tick, reporting both to the registry
+     * @param node The node
+     * @param deadline The deadline of the probe
+     * @return The peers shared by the node, on the port of the node, or the error that occurred
+     */
+    tl::expected<std::vector<NodeAddress>, ConnectionError> Probe(
+        const NodeAddress& node,
+        const Deadline& deadline);
+
+private:
+    /**
+     * Crawl until stopped
+     */
+    void Run();
+
+    /**
+     * Drop the discovered peers that never answered and of which the circuit breaker tripped
+     */
+    void DropDeadPeers();
+
+private:
+    /// Registry to crawl from and add peers to
+    NodeRegistry& m_registry;
+
+    /// Peer table to write after every round
+    std::string m_tablePath;
+
+    /// Time between rounds
+    std::chrono::milliseconds m_interval;
+
+    /// Keys of the peers added by the crawler, only these are dropped again
+    std::set<std::string> m_discovered;
+
+    /// Keys of the discovered peers that were dropped
+    std::set<std::string> m_dropped;
+
+    /// Guard for `m_discovered` and `m_dropped`
+    std::mutex m_discoveredMutex;
+
+    /// Aborts the running round once the crawler is destroyed
+    CancellationToken m_token;
+
+    /// Tell the background thread to stop
+    bool m_bStop = false;
+
+    /// Background thread, started by `Start`
+    std::thread m_thread;
+
+    /// Guard for `m_bStop` and `m_thread`
+    std::mutex m_mutex;
+
+    /// Wakes the background thread to stop
+    std::condition_variable m_condition;
+};
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Get the nodes shared in a peer exchange, unused slots are skipped
+ * @param peers The shared peers
+ * @param port The port of the nodes, peers are shared without one
+ * @return The nodes
+ */
+std::vector<NodeAddress> GetPeerNodes(const ExchangePublicPeers& peers, unsigned short port);
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Write the best nodes of a registry to a peer table, one node per line: the ip-address, port and
+ * round trip time in milliseconds
+ * @param registry The registry
+ * @param path The path of the peer table
+ * @param count The maximum number of nodes to write
+ * @return The number of nodes written, else the error that occurred
+ */
+tl::expected<size_t, ConnectionError> SavePeerTable(
+    const NodeRegistry& registry,
+    const std::string& path,
+    size_t count = PeerCrawler::maximumSavedCount);
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Add the nodes of a peer table to a registry, ranked by their saved round trip times until they
+ * are called, invalid lines are skipped
+ * @param registry The registry
+ * @param path The path of the peer table
+ * @return The number of nodes read, else the error that occurred
+ */
+tl::expected<size_t, ConnectionError> LoadPeerTable(
+    NodeRegistry& registry,
+    const std::string& path);
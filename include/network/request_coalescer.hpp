@@ -0,0 +1,170 @@
+#pragma once
+
+#include <tl/expected.hpp>
+
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <typeindex>
+#include <utility>
+#include <vector>
+
+#include "network/async_engine.hpp"
+#include "network/connection.hpp"
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Identifies a request, requests with equal keys receive the same response
+ */
+struct RequestKey
+{
+    /// Node class of any node of a registry
+    static constexpr const char* anyNode = "*";
+
+    /// The message type of the request
+    unsigned char type;
+
+    /// The payload of the request, without the header of which the dejavu is random
+    std::string payload;
+
+    /// The nodes that may answer, e.g. the ip-address and port of one node or `anyNode`
+    std::string nodeClass = anyNode;
+
+    /**
+     * Order keys, to look them up
+     * @param other The other key
+     * @return `true` if this key comes first, else `false`
+     */
+    bool operator<(const RequestKey& other) const
+    {
+        return std::tie(type, payload, nodeClass) <
+               std::tie(other.type, other.payload, other.nodeClass);
+    }
+};
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Shares one request between all callers that ask for the same data at the same time
+ *
+ * The first caller of a key starts the request, callers that join while it is in flight don't
+ * send anything and receive a copy of its response. Once the response is handed out the key is
+ * free again, so a later caller gets fresh data: nothing is cached. The response of the first
+ * caller is shared as is, including an error caused by its deadline or token, so callers that are
+ * coalesced should share their time limit and cancellation, e.g. those of one window. The
+ * coalescer is thread-safe.
+ */
+class RequestCoalescer
+{
+public:
+    /**
+     * Join the request of a key, or start it if none is in flight
+     * @param key The key of the request
+     * @param callback Receives the response, on the thread that completes the request
+     * @param start Starts the request if none is in flight, must call the completion it receives
+     * exactly once, possibly before returning
+     */
+    template <typename T>
+    void Join(
+        const RequestKey& key,
+        AsyncCallback<T> callback,
+        const std::function<void(AsyncCallback<T>)>& start);
+
+    /**
+     * Join the request of a key and wait for its response, or run it on the calling thread if none
+     * is in flight
+     * @param key The key of the request
+     * @param request The blocking request, returns `tl::expected<T, ConnectionError>`
+     * @return The response
+     */
+    template <typename T, typename F>
+    tl::expected<T, ConnectionError> Run(const RequestKey& key, F request);
+
+    /**
+     * Get the number of requests in flight
+     * @return The number of keys of which a request is in flight
+     */
+    size_t GetInFlightCount() const;
+
+private:
+    /// Key of a request and the type of its response
+    typedef std::pair<RequestKey, std::type_index> FlightKey;
+
+    /**
+     * Request in flight
+     */
+    template <typename T>
+    struct Flight
+    {
+        /// Callers waiting for the response, the first one started the request
+        std::vector<AsyncCallback<T>> callbacks;
+    };
+
+    /// Requests in flight, `Flight<T>` of the type in the key
+    std::map<FlightKey, std::shared_ptr<void>> m_flights;
+
+    /// Guard for `m_flights`
+    mutable std::mutex m_mutex;
+};
+
+// ------------------------------------------------------------------------------------------------
+template <typename T>
+void RequestCoalescer::Join(
+    const RequestKey& key,
+    AsyncCallback<T> callback,
+    const std::function<void(AsyncCallback<T>)>& start)
+{
+    FlightKey flightKey{key, std::type_index(typeid(T))};
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_flights.find(flightKey);
+        if (it != m_flights.end())
+        {
+            static_cast<Flight<T>*>(it->second.get())->callbacks.push_back(std::move(callback));
+            return;
+        }
+
+        auto flight = std::make_shared<Flight<T>>();
+        flight->callbacks.push_back(std::move(callback));
+        m_flights.emplace(flightKey, std::move(flight));
+    }
+
+    start([this, flightKey = std::move(flightKey)](tl::expected<T, ConnectionError> result) {
+        // Taken out before calling back, so that a callback can start the next request
+        std::vector<AsyncCallback<T>> callbacks;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_flights.find(flightKey);
+            if (it == m_flights.end())
+            {
+                return;
+            }
+            callbacks = std::move(static_cast<Flight<T>*>(it->second.get())->callbacks);
+            m_flights.erase(it);
+        }
+
+        for (auto& callback : callbacks)
+        {
+            callback(result);
+        }
+    });
+}
+
+// ------------------------------------------------------------------------------------------------
+template <typename T, typename F>
+tl::expected<T, ConnectionError> RequestCoalescer::Run(const RequestKey& key, F request)
+{
+    // Shared, the caller may return while the completing thread is still setting the value
+    auto promise = std::make_shared<std::promise<tl::expected<T, ConnectionError>>>();
+    auto future = promise->get_future();
+    Join<T>(
+        key,
+        [promise](tl::expected<T, ConnectionError> result) {
+            promise->set_value(std::move(result));
+        },
+        [&request](AsyncCallback<T> complete) { complete(request()); });
+    return future.get();
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <tl/expected.hpp>
+
+#include <string>
+#include <vector>
+
+#include "network/transactions.hpp"
+
+// ------------------------------------------------------------------------------------------------
+/// Index of the utility contract QUTIL
+constexpr unsigned int qutilContractIndex = 4;
+
+/// Input type of the SendToMany procedure of QUTIL
+constexpr unsigned short sendToManyInputType = 1;
+
+/// Maximum number of recipients of a single SendToMany call
+constexpr size_t sendToManyMaxRecipients = 25;
+
+/// Fee of a single SendToMany call, any amount exceeding the payouts and fee is refunded
+constexpr long long sendToManyFee = 10;
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Input of the SendToMany procedure of QUTIL, unused slots are zero
+ */
+struct SendToManyInput
+{
+    unsigned char publicKeys[sendToManyMaxRecipients][32];
+    long long amounts[sendToManyMaxRecipients];
+};
+
+static_assert(sizeof(SendToManyInput) == 1000, "SendToMany input must match the contract");
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Get the identity of the utility contract
+ * @return The identity of QUTIL
+ */
+std::string GetQutilIdentity();
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Get the number of SendToMany calls needed to pay out transfers
+ * @param transferCount The number of transfers
+ * @return The number of calls
+ */
+size_t GetSendToManyCallCount(size_t transferCount);
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Get the total cost of paying out transfers with SendToMany
+ * @param transfers The transfers to pay out
+ * @return The sum of the amounts and the fee of every call
+ */
+long long GetSendToManyCost(const std::vector<Transfer>& transfers);
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Add SendToMany calls paying out transfers, split into calls of at most
+ * `sendToManyMaxRecipients` transfers. A source can only have one transaction per tick, so call
+ * `i` pays transfers `[i * sendToManyMaxRecipients, (i + 1) * sendToManyMaxRecipients)` at
+ * `tick + i`. Nothing is added if any transfer is invalid.
+ * @param builder The builder to add the calls to
+ * @param transfers The transfers to pay out
+ * @param tick The tick of the first call
+ * @return The receipt of each call upon success, else the error that occurred
+ */
+tl::expected<std::vector<Receipt>, TransactionError> AddSendToMany(
+    TransactionBuilder& builder,
+    const std::vector<Transfer>& transfers,
+    unsigned int tick);
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Broadcast a payout to the Qubic network using SendToMany calls
+ * @param connection The node to broadcast to
+ * @param signingKey The signing key of the sender
+ * @param transfers The transfers to pay out
+ * @param tickOffset The number of ticks in the future to schedule the first call
+ * @return The receipt of each call upon success, else the error that occurred
+ */
+tl::expected<std::vector<Receipt>, TransactionError> BroadcastSendToMany(
+    const ConnectionPtr& connection,
+    const SigningKeyPtr& signingKey,
+    const std::vector<Transfer>& transfers,
+    unsigned int tickOffset);
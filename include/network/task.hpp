@@ -0,0 +1,243 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Lazily started coroutine that produces a value
+ *
+ * A task only runs once it is awaited by another coroutine, or started with `StartTask`. It then
+ * runs on the calling thread until it awaits a request, and continues on the thread that completes
+ * the request, usually the engine thread. The awaiting coroutine is resumed right after the task
+ * returns, without a thread in between, so a chain of requests never blocks a thread.
+ */
+template <typename T>
+class Task
+{
+public:
+    struct promise_type;
+
+    /// Handle of the coroutine
+    typedef std::coroutine_handle<promise_type> Handle;
+
+    /**
+     * Resumes the awaiting coroutine once the task returns
+     */
+    struct FinalAwaiter
+    {
+        bool await_ready() const noexcept { return false; }
+
+        std::coroutine_handle<> await_suspend(Handle handle) noexcept
+        {
+            return handle.promise().continuation;
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    /**
+     * State of the coroutine
+     */
+    struct promise_type
+    {
+        /// The returned value
+        std::optional<T> value;
+
+        /// The exception that escaped the coroutine
+        std::exception_ptr exception;
+
+        /// The awaiting coroutine
+        std::coroutine_handle<> continuation = std::noop_coroutine();
+
+        Task get_return_object() { return Task(Handle::from_promise(*this)); }
+
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+
+        FinalAwaiter final_suspend() const noexcept { return {}; }
+
+        template <typename U>
+        void return_value(U&& result)
+        {
+            value.emplace(std::forward<U>(result));
+        }
+
+        void unhandled_exception() { exception = std::current_exception(); }
+    };
+
+    Task(Task&& other) noexcept
+        : m_handle(std::exchange(other.m_handle, nullptr))
+    {}
+
+    Task& operator=(Task&& other) noexcept
+    {
+        if (this != &other)
+        {
+            Reset();
+            m_handle = std::exchange(other.m_handle, nullptr);
+        }
+        return *this;
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    /**
+     * Destructor, destroys the coroutine
+     */
+    ~Task() { Reset(); }
+
+    bool await_ready() const noexcept { return false; }
+
+    /**
+     * Start the task, and resume the awaiting coroutine once it returns
+     * @param awaiting The awaiting coroutine
+     * @return The task, to run it without growing the stack
+     */
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+    {
+        m_handle.promise().continuation = awaiting;
+        return m_handle;
+    }
+
+    /**
+     * Get the result of the task
+     * @return The returned value, exceptions are rethrown
+     */
+    T await_resume()
+    {
+        if (m_handle.promise().exception)
+        {
+            std::rethrow_exception(m_handle.promise().exception);
+        }
+        return std::move(*m_handle.promise().value);
+    }
+
+private:
+    /**
+     * Hidden constructor
+     * @param handle The coroutine
+     */
+    explicit Task(Handle handle) noexcept
+        : m_handle(handle)
+    {}
+
+    /**
+     * Destroy the coroutine, if any
+     */
+    void Reset()
+    {
+        if (m_handle)
+        {
+            m_handle.destroy();
+            m_handle = nullptr;
+        }
+    }
+
+private:
+    /// The coroutine
+    Handle m_handle;
+};
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Awaits a function that reports its result to a callback, e.g. the `Async` network functions
+ */
+template <typename T>
+class CallbackAwaitable
+{
+public:
+    /// Function that starts the work, and calls the callback once with its result
+    typedef std::function<void(std::function<void(T)>)> StartFunction;
+
+    /**
+     * Constructor
+     * @param start The function that starts the work
+     */
+    explicit CallbackAwaitable(StartFunction start)
+        : m_start(std::move(start))
+    {}
+
+    bool await_ready() const noexcept { return false; }
+
+    /**
+     * Start the work, the callback resumes the coroutine on the thread that calls it
+     * @param awaiting The awaiting coroutine
+     */
+    void await_suspend(std::coroutine_handle<> awaiting)
+    {
+        // The callback may resume and finish the coroutine, which destroys this awaitable, before
+        // the start function returns
+        auto start = std::move(m_start);
+        start([this, awaiting](T result) {
+            m_result.emplace(std::move(result));
+            awaiting.resume();
+        });
+    }
+
+    /**
+     * Get the result of the work
+     * @return The result passed to the callback
+     */
+    T await_resume() { return std::move(*m_result); }
+
+private:
+    /// The function that starts the work
+    StartFunction m_start;
+
+    /// The result passed to the callback
+    std::optional<T> m_result;
+};
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Coroutine that starts right away and frees itself once done, the base of `StartTask`
+ */
+struct DetachedTask
+{
+    struct promise_type
+    {
+        DetachedTask get_return_object() const noexcept { return {}; }
+
+        std::suspend_never initial_suspend() const noexcept { return {}; }
+
+        std::suspend_never final_suspend() const noexcept { return {}; }
+
+        void return_void() const noexcept {}
+
+        void unhandled_exception() const noexcept { std::terminate(); }
+    };
+};
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Start a task without waiting for it
+ * @param task The task to start
+ * @param callback Receives the result, on the thread that completes the task
+ */
+template <typename T>
+DetachedTask StartTask(Task<T> task, std::type_identity_t<std::function<void(T)>> callback)
+{
+    callback(co_await std::move(task));
+}
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Start a task, to wait for it or poll it with a future
+ * @param task The task to start
+ * @return The future result of the task
+ */
+template <typename T>
+std::future<T> StartTask(Task<T> task)
+{
+    auto promise = std::make_shared<std::promise<T>>();
+    auto future = promise->get_future();
+    StartTask<T>(std::move(task), [promise](T result) { promise->set_value(std::move(result)); });
+    return future;
+}
@@ -2,7 +2,11 @@
 
 #include <tl/expected.hpp>
 
+#include "network/async_engine.hpp"
 #include "network/connection.hpp"
+#include "network/hedging.hpp"
+#include "network/node_registry.hpp"
+#include "network/request_coalescer.hpp"
 #include "network_messages/tick.h"
 
 // ------------------------------------------------------------------------------------------------
@@ -13,6 +17,67 @@
  */
 tl::expected<CurrentTickInfo, ConnectionError> GetCurrentTickInfo(const ConnectionPtr& connection);
 
+// ------------------------------------------------------------------------------------------------
+/**
+ * Get current tick info from the best node of a registry, sharing the request with concurrent
+ * queries
+ * @param coalescer The coalescer to share the request through, only used with this registry
+ * @param registry The registry to select the node from
+ * @param deadline The deadline of the request, shared by the queries that join it
+ * @return The tick info upon success, else a connection error
+ */
+tl::expected<CurrentTickInfo, ConnectionError> GetCurrentTickInfo(
+    RequestCoalescer& coalescer,
+    NodeRegistry& registry,
+    const Deadline& deadline);
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Get current tick info from a node without blocking
+ * @param engine The engine to run the request on
+ * @param node The node to query
+ * @param callback Receives the tick info or a connection error, on the engine thread
+ * @param timeout The maximum time the request may take
+ * @param token Aborts the request once cancelled
+ */
+void GetCurrentTickInfoAsync(
+    AsyncEngine& engine,
+    const NodeAddress& node,
+    AsyncCallback<CurrentTickInfo> callback,
+    std::chrono::milliseconds timeout = AsyncEngine::defaultTimeout,
+    CancellationToken token = {});
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Get current tick info from the first of several nodes to respond
+ * @param hedger The hedger to run the request on
+ * @param nodes The nodes to query, best first
+ * @param callback Receives the tick info or a connection error, on the engine thread
+ * @param timeout The maximum time the request may take
+ * @param token Aborts the request once cancelled
+ */
+void GetCurrentTickInfoAsync(
+    RequestHedger& hedger,
+    const std::vector<NodeAddress>& nodes,
+    AsyncCallback<CurrentTickInfo> callback,
+    std::chrono::milliseconds timeout = AsyncEngine::defaultTimeout,
+    CancellationToken token = {});
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Get current tick info from a coroutine
+ * @param engine The engine to run the request on
+ * @param node The node to query
+ * @param timeout The maximum time the request may take
+ * @param token Aborts the request once cancelled
+ * @return The task that produces the tick info or a connection error
+ */
+Task<tl::expected<CurrentTickInfo, ConnectionError>> GetCurrentTickInfoTask(
+    AsyncEngine& engine,
+    NodeAddress node,
+    std::chrono::milliseconds timeout = AsyncEngine::defaultTimeout,
+    CancellationToken token = {});
+
 // ------------------------------------------------------------------------------------------------
 /**
  * Get the current tick duration
@@ -37,6 +102,20 @@ tl::expected<unsigned short, ConnectionError> GetEpoch(const ConnectionPtr& conn
  */
 tl::expected<unsigned int, ConnectionError> GetTick(const ConnectionPtr& connection);
 
+// ------------------------------------------------------------------------------------------------
+/**
+ * Get the current tick number from the best node of a registry, sharing the request with
+ * concurrent queries
+ * @param coalescer The coalescer to share the request through, only used with this registry
+ * @param registry The registry to select the node from
+ * @param deadline The deadline of the request, shared by the queries that join it
+ * @return The current tick number upon success, else a connection error
+ */
+tl::expected<unsigned int, ConnectionError> GetTick(
+    RequestCoalescer& coalescer,
+    NodeRegistry& registry,
+    const Deadline& deadline);
+
 // ------------------------------------------------------------------------------------------------
 /**
  * Get the number of aligned votes of the current tick
@@ -74,6 +153,70 @@ tl::expected<BroadcastFutureTickData, ConnectionError> GetTickData(
     const ConnectionPtr& connection,
     unsigned int tick);
 
+// ------------------------------------------------------------------------------------------------
+/**
+ * Get tick data without copying it out of the receive buffer of the connection
+ * @param connection The node to query
+ * @param tick The tick to request
+ * @return The tick data, valid until the next receive on the connection, or a connection error
+ */
+tl::expected<const BroadcastFutureTickData*, ConnectionError> GetTickDataView(
+    const ConnectionPtr& connection,
+    unsigned int tick);
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Get tick data without blocking
+ * @param engine The engine to run the request on
+ * @param node The node to query
+ * @param tick The tick to request
+ * @param callback Receives the tick data or a connection error, on the engine thread
+ * @param timeout The maximum time the request may take
+ * @param token Aborts the request once cancelled
+ */
+void GetTickDataAsync(
+    AsyncEngine& engine,
+    const NodeAddress& node,
+    unsigned int tick,
+    AsyncCallback<BroadcastFutureTickData> callback,
+    std::chrono::milliseconds timeout = AsyncEngine::defaultTimeout,
+    CancellationToken token = {});
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Get tick data from the first of several nodes to respond
+ * @param hedger The hedger to run the request on
+ * @param nodes The nodes to query, best first
+ * @param tick The tick to request
+ * @param callback Receives the tick data or a connection error, on the engine thread
+ * @param timeout The maximum time the request may take
+ * @param token Aborts the request once cancelled
+ */
+void GetTickDataAsync(
+    RequestHedger& hedger,
+    const std::vector<NodeAddress>& nodes,
+    unsigned int tick,
+    AsyncCallback<BroadcastFutureTickData> callback,
+    std::chrono::milliseconds timeout = AsyncEngine::defaultTimeout,
+    CancellationToken token = {});
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Get tick data from a coroutine
+ * @param engine The engine to run the request on
+ * @param node The node to query
+ * @param tick The tick to request
+ * @param timeout The maximum time the request may take
+ * @param token Aborts the request once cancelled
+ * @return The task that produces the tick data or a connection error
+ */
+Task<tl::expected<BroadcastFutureTickData, ConnectionError>> GetTickDataTask(
+    AsyncEngine& engine,
+    NodeAddress node,
+    unsigned int tick,
+    std::chrono::milliseconds timeout = AsyncEngine::defaultTimeout,
+    CancellationToken token = {});
+
 // ------------------------------------------------------------------------------------------------
 /**
  * Check if a tick contains a specific transaction
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Picks the tick offset of new transactions from measured network conditions
+ *
+ * A transaction must reach the computors before its tick is proposed, else it is dropped, while
+ * every extra tick of offset delays confirmation by one tick duration. The estimator models the
+ * smallest offset at which a pessimistic latency fits in the time left before the tick: the latency
+ * quantile at the target probability, divided by the opposite quantile of recent tick durations.
+ * Inclusion outcomes then correct the model: the offset grows while enough outcomes show it misses
+ * the target, and shrinks while one tick less is known to meet it. The estimator is thread-safe.
+ */
+class TickOffsetEstimator
+{
+public:
+    /// Smallest offset, the next ticks are usually being proposed already
+    static constexpr unsigned int minimumOffset = 3;
+
+    /// Largest offset
+    static constexpr unsigned int maximumOffset = 100;
+
+    /// Offset used until tick durations are known
+    static constexpr unsigned int defaultOffset = 10;
+
+    /**
+     * Constructor
+     * @param targetInclusion The desired probability that a transaction is included, in (0, 1)
+     */
+    explicit TickOffsetEstimator(double targetInclusion = 0.95);
+
+    /**
+     * Add a tick duration, e.g. `CurrentTickInfo::tickDuration`
+     * @param milliseconds The duration of a tick, zero is ignored
+     */
+    void AddTickDuration(unsigned int milliseconds);
+
+    /**
+     * Add the time between reading the current tick and the transaction being sent
+     * @param milliseconds The latency
+     */
+    void AddLatency(double milliseconds);
+
+    /**
+     * Add the outcome of a transaction
+     * @param offset The tick offset of the transaction
+     * @param bIncluded `true` if the transaction was included in its tick, else `false`
+     */
+    void AddOutcome(unsigned int offset, bool bIncluded);
+
+    /**
+     * Get the smallest offset expected to meet the target inclusion probability
+     * @return The tick offset
+     */
+    unsigned int GetTickOffset() const;
+
+private:
+    /**
+     * Get the observed inclusion rate of an offset
+     * @param offset The tick offset
+     * @param rate The observed inclusion rate
+     * @return `true` if there are enough outcomes for the rate to be meaningful, else `false`
+     */
+    bool GetInclusionRate(unsigned int offset, double& rate) const;
+
+private:
+    /// Number of recent durations and latencies to keep
+    static constexpr size_t maximumSamples = 64;
+
+    /// Number of recent outcomes to keep
+    static constexpr size_t maximumOutcomes = 256;
+
+    /// Number of outcomes of an offset before its inclusion rate is trusted
+    static constexpr size_t minimumOutcomes = 10;
+
+    /// The desired probability that a transaction is included
+    double m_targetInclusion;
+
+    /// Recent tick durations in milliseconds
+    std::deque<double> m_tickDurations;
+
+    /// Recent latencies in milliseconds
+    std::deque<double> m_latencies;
+
+    /// Recent outcomes, the offset and whether it was included
+    std::deque<std::pair<unsigned int, bool>> m_outcomes;
+
+    /// Guard for the samples
+    mutable std::mutex m_mutex;
+};
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <tl/expected.hpp>
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "crypto/signing_key.hpp"
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Struct to wrap tick slot error message
+ */
+struct TickSlotError
+{
+    std::string message;
+};
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * A source wallet and the tick at which it may send one transaction
+ */
+struct TickSlot
+{
+    /// Signing key of the source wallet
+    SigningKeyPtr source;
+
+    /// The tick reserved for the transaction
+    unsigned int tick;
+};
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Assigns transfers to a pool of source wallets without tick collisions
+ *
+ * A node executes at most one transaction per source per tick, a second one is dropped. The
+ * allocator remembers the next free tick of every source and reserves the amount of each transfer
+ * from the known balance, so concurrent senders never get the same slot or overdraw a source.
+ * Transfers go to the source that can send the earliest, which spreads the load over the pool so
+ * throughput grows with the number of sources. The allocator is thread-safe.
+ */
+class TickSlotAllocator
+{
+public:
+    /**
+     * Constructor, balances start at zero
+     * @param sources The signing keys of the source wallets
+     */
+    explicit TickSlotAllocator(std::vector<SigningKeyPtr> sources);
+
+    /**
+     * Set the balance of a source, e.g. after querying its entity, minus pending transfers
+     * @param identity The identity of the source
+     * @param balance The spendable balance
+     * @return `true` if the source is part of the pool, else `false`
+     */
+    bool SetBalance(const std::string& identity, long long balance);
+
+    /**
+     * Get the spendable balance of a source
+     * @param identity The identity of the source
+     * @return The spendable balance, zero if the source is not part of the pool
+     */
+    long long GetBalance(const std::string& identity) const;
+
+    /**
+     * Reserve the earliest slot of a source that can afford a transfer
+     * @param amount The amount to transfer
+     * @param minimumTick The earliest tick at which the transfer may be scheduled
+     * @return The reserved slot upon success, else the error that occurred
+     */
+    tl::expected<TickSlot, TickSlotError> Allocate(long long amount, unsigned int minimumTick);
+
+    /**
+     * Return the amount of a failed transfer to the balance of its source, the tick is not reused
+     * @param slot The slot of the failed transfer
+     * @param amount The amount of the failed transfer
+     */
+    void Release(const TickSlot& slot, long long amount);
+
+    /**
+     * Get the number of source wallets
+     * @return The number of source wallets
+     */
+    size_t GetSourceCount() const;
+
+private:
+    /**
+     * Source wallet state
+     */
+    struct Source
+    {
+        /// Signing key of the source wallet
+        SigningKeyPtr key;
+
+        /// Spendable balance, minus allocated transfers
+        long long balance;
+
+        /// First tick without a transaction of this source
+        unsigned int nextTick;
+    };
+
+    /**
+     * Find a source by identity
+     * @param identity The identity of the source
+     * @return The source, `nullptr` if the source is not part of the pool
+     */
+    Source* FindSource(const std::string& identity);
+
+private:
+    /// Source wallets
+    std::vector<Source> m_sources;
+
+    /// Guard for the sources
+    mutable std::mutex m_mutex;
+};
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <tl/expected.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "network/connection.hpp"
+#include "network/node_registry.hpp"
+#include "network_messages/tick.h"
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Shared clock of the current tick, sampled from nodes in the background
+ *
+ * Querying the tick costs a connection and a round trip every time, while ticks advance at a
+ * steady pace. The tracker samples `CurrentTickInfo` of every node on a background thread, keeps
+ * the highest tick and estimates when it started: halfway between the last sample of the previous
+ * tick and the first sample of the new one. The current tick, or the tick at any future time, is
+ * then predicted from memory with the average tick duration. The tracker is thread-safe.
+ */
+class TickTracker
+{
+public:
+    /// Clock of the sample and prediction times
+    typedef std::chrono::steady_clock Clock;
+
+    /// Default time between samples of each node
+    static constexpr std::chrono::milliseconds defaultInterval{1000};
+
+    /// Ticks to predict beyond the last sampled tick at most, the network does stall at times
+    static constexpr unsigned int maximumPredictedTicks = 10;
+
+    /**
+     * Constructor, nothing is sampled until nodes are set
+     * @param interval The time between samples of each node
+     */
+    explicit TickTracker(std::chrono::milliseconds interval = defaultInterval);
+
+    TickTracker(const TickTracker&) = delete;
+    TickTracker& operator=(const TickTracker&) = delete;
+
+    /**
+     * Destructor, stops sampling
+     */
+    ~TickTracker();
+
+    /**
+     * Set the nodes to sample, starts sampling in the background
+     * @param nodes The nodes to sample
+     */
+    void SetNodes(std::vector<NodeAddress> nodes);
+
+    /**
+     * Sample the nodes selected by a registry instead, and report their ticks and health to it,
+     * starts sampling in the background
+     * @param registry The registry, must outlive the tracker
+     */
+    void SetRegistry(NodeRegistry& registry);
+
+    /**
+     * Add a sample, done by the background thread for every node
+     * @param info The tick info of a node
+     * @param time The time at which the node was queried
+     */
+    void AddSample(const CurrentTickInfo& info, Clock::time_point time);
+
+    /**
+     * Get the predicted current tick
+     * @return The current tick, else an error if no node has been sampled yet
+     */
+    tl::expected<unsigned int, ConnectionError> GetTick() const;
+
+    /**
+     * Get the predicted tick at a point in time
+     * @param time The time of the prediction
+     * @return The predicted tick, else an error if no node has been sampled yet
+     */
+    tl::expected<unsigned int, ConnectionError> PredictTick(Clock::time_point time) const;
+
+    /**
+     * Get the tick info of the highest sampled tick
+     * @return The tick info, else an error if no node has been sampled yet
+     */
+    tl::expected<CurrentTickInfo, ConnectionError> GetTickInfo() const;
+
+    /**
+     * Get the average tick duration
+     * @return The tick duration in milliseconds, zero if unknown
+     */
+    double GetTickDuration() const;
+
+private:
+    /**
+     * Sample all nodes until stopped
+     */
+    void Run();
+
+private:
+    /// Weight of a new tick duration in the average
+    static constexpr double tickDurationWeight = 0.2;
+
+    /// Time between samples of each node
+    std::chrono::milliseconds m_interval;
+
+    /// Nodes to sample
+    std::vector<NodeAddress> m_nodes;
+
+    /// Registry to select the nodes from and report to, if any
+    NodeRegistry* m_registry = nullptr;
+
+    /// Has any node been sampled
+    bool m_bHasSample = false;
+
+    /// Tick info of the highest sampled tick
+    CurrentTickInfo m_info{};
+
+    /// Estimated start of the highest sampled tick
+    Clock::time_point m_tickStart;
+
+    /// Last time the highest sampled tick was seen
+    Clock::time_point m_lastSeen;
+
+    /// Average tick duration in milliseconds
+    double m_tickDuration = 0.0;
+
+    /// Tell the background thread to stop
+    bool m_bStop = false;
+
+    /// Background thread, started by the first `SetNodes`
+    std::thread m_thread;
+
+    /// Guard for all members above
+    mutable std::mutex m_mutex;
+
+    /// Wakes the background thread to stop
+    std::condition_variable m_condition;
+};
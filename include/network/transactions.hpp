@@ -2,10 +2,15 @@
 
 #include <tl/expected.hpp>
 
+#include <functional>
 #include <string>
+#include <vector>
 
+#include "crypto/signing_key.hpp"
+#include "network/async_engine.hpp"
+#include "network/broadcast.hpp"
 #include "network/connection.hpp"
-#include "wallet.hpp"
+#include "network_messages/transactions.h"
 
 // ------------------------------------------------------------------------------------------------
 /**
@@ -45,6 +50,48 @@ struct Receipt
  */
 std::string StatusToString(Receipt::Status status);
 
+// ------------------------------------------------------------------------------------------------
+/**
+ * A transfer to sign as part of a batch
+ */
+struct Transfer
+{
+    /// Identity of the recipient
+    std::string recipient;
+
+    /// The amount to transfer
+    long long amount;
+};
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Wire format of a transaction without input
+ */
+struct TransactionPacket
+{
+    RequestResponseHeader header;
+    Transaction transaction;
+    unsigned char signature[SIGNATURE_SIZE];
+};
+
+static_assert(
+    sizeof(TransactionPacket) ==
+        sizeof(RequestResponseHeader) + sizeof(Transaction) + SIGNATURE_SIZE,
+    "Transaction packets must not contain padding");
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Signed transactions, ready to be broadcast
+ */
+struct SignedTransactions
+{
+    /// Packets back to back, so they can be sent with a single call
+    std::vector<TransactionPacket> packets;
+
+    /// Receipt of each transaction, in the order of the packets
+    std::vector<Receipt> receipts;
+};
+
 // ------------------------------------------------------------------------------------------------
 /**
  * Struct to wrap transaction error mesasge
@@ -54,11 +101,19 @@ struct TransactionError
     std::string message;
 };
 
+// ------------------------------------------------------------------------------------------------
+/**
+ * Get the identity of a contract, the destination of its procedure calls
+ * @param contractIndex The index of the contract
+ * @return The identity of the contract
+ */
+std::string GetContractIdentity(unsigned int contractIndex);
+
 // ------------------------------------------------------------------------------------------------
 /**
  * Broadcast a transaction to the Qubic network
  * @param connection The node to broadcast to
- * @param wallet The wallet of the sender
+ * @param signingKey The signing key of the sender
  * @param recipient The identity of the recipient
  * @param amount The amount to send
  * @param tickOffset The number of ticks in the future to schedule the transaction
@@ -66,7 +121,217 @@ struct TransactionError
  */
 tl::expected<Receipt, TransactionError> BroadcastTransaction(
     const ConnectionPtr& connection,
-    const Wallet& wallet,
+    const SigningKey& signingKey,
     const std::string& recipient,
     long long amount,
     unsigned int tickOffset);
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Broadcast a transaction scheduled at a known tick, e.g. predicted by a `TickTracker`
+ * @param connection The node to broadcast to
+ * @param signingKey The signing key of the sender
+ * @param recipient The identity of the recipient
+ * @param amount The amount to send
+ * @param tick The tick at which the transaction should be executed
+ * @return The receipt upon success, else the error that occurred
+ */
+tl::expected<Receipt, TransactionError> BroadcastTransactionAtTick(
+    const ConnectionPtr& connection,
+    const SigningKey& signingKey,
+    const std::string& recipient,
+    long long amount,
+    unsigned int tick);
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Broadcast a transaction without blocking, see `BroadcastTransaction`
+ * @param engine The engine to run the requests on
+ * @param node The node to broadcast to
+ * @param signingKey The signing key of the sender
+ * @param recipient The identity of the recipient
+ * @param amount The amount to send
+ * @param tickOffset The number of ticks in the future to schedule the transaction
+ * @param callback Receives the receipt or the error that occurred, on the engine thread
+ * @param timeout The maximum time of the tick request, and of the broadcast
+ * @param token Aborts the requests once cancelled
+ */
+void BroadcastTransactionAsync(
+    AsyncEngine& engine,
+    const NodeAddress& node,
+    SigningKeyPtr signingKey,
+    const std::string& recipient,
+    long long amount,
+    unsigned int tickOffset,
+    std::function<void(tl::expected<Receipt, TransactionError>)> callback,
+    std::chrono::milliseconds timeout = AsyncEngine::defaultTimeout,
+    CancellationToken token = {});
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Broadcast a transaction from a coroutine, see `BroadcastTransaction`
+ * @param engine The engine to run the requests on
+ * @param node The node to broadcast to
+ * @param signingKey The signing key of the sender
+ * @param recipient The identity of the recipient
+ * @param amount The amount to send
+ * @param tickOffset The number of ticks in the future to schedule the transaction
+ * @param timeout The maximum time of the tick request, and of the broadcast
+ * @param token Aborts the requests once cancelled
+ * @return The task that produces the receipt or the error that occurred
+ */
+Task<tl::expected<Receipt, TransactionError>> BroadcastTransactionTask(
+    AsyncEngine& engine,
+    NodeAddress node,
+    SigningKeyPtr signingKey,
+    std::string recipient,
+    long long amount,
+    unsigned int tickOffset,
+    std::chrono::milliseconds timeout = AsyncEngine::defaultTimeout,
+    CancellationToken token = {});
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Sign a batch of transfers scheduled at the same tick, the work is split over multiple threads
+ * @param signingKey The signing key of the sender
+ * @param transfers The transfers to sign
+ * @param tick The tick at which the transactions should be executed
+ * @param threadCount The maximum number of threads, 0 for the number of hardware threads
+ * @return The signed transactions, else the first invalid recipient
+ */
+tl::expected<SignedTransactions, TransactionError> SignTransactions(
+    const SigningKey& signingKey,
+    const std::vector<Transfer>& transfers,
+    unsigned int tick,
+    unsigned int threadCount = 0);
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Broadcast signed transactions to the Qubic network
+ * @param connection The node to broadcast to
+ * @param transactions The signed transactions
+ * @return `true` upon success, else the error that occurred
+ */
+tl::expected<bool, TransactionError> BroadcastTransactions(
+    const ConnectionPtr& connection,
+    const SignedTransactions& transactions);
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Broadcast signed transactions to multiple nodes at once, see `BroadcastToNodes`
+ * @param nodes The nodes to broadcast to
+ * @param transactions The signed transactions
+ * @param timeout The maximum time to connect, and the maximum time to send, per node
+ * @return The outcome of each node if any node accepted the transactions, else an error
+ */
+tl::expected<std::vector<NodeBroadcastResult>, TransactionError> BroadcastTransactions(
+    const std::vector<NodeAddress>& nodes,
+    const SignedTransactions& transactions,
+    std::chrono::milliseconds timeout);
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Builds signed transactions with an optional input payload, e.g. contract procedure calls,
+ * directly into one reusable buffer
+ *
+ * The transaction and input are absorbed into the hash only once: the digest to sign and the
+ * transaction hash, which also covers the signature, continue from the same hash state.
+ */
+class TransactionBuilder
+{
+public:
+    /**
+     * Constructor
+     * @param signingKey The signing key of the sender
+     */
+    explicit TransactionBuilder(SigningKeyPtr signingKey);
+
+    /**
+     * Append a signed transaction
+     * @param recipient The identity of the recipient or contract
+     * @param amount The amount to transfer
+     * @param tick The tick at which the transaction should be executed
+     * @param inputType The type of the input
+     * @param input The input payload, can be `nullptr` if `inputSize` is zero
+     * @param inputSize The size of the input payload in bytes, at most `MAX_INPUT_SIZE`
+     * @return The receipt upon success, else the error that occurred
+     */
+    tl::expected<Receipt, TransactionError> Add(
+        const std::string& recipient,
+        long long amount,
+        unsigned int tick,
+        unsigned short inputType = 0,
+        const void* input = nullptr,
+        unsigned short inputSize = 0);
+
+    /**
+     * Append a signed transaction with a struct as input, e.g. `ContractIPOBid`
+     * @param recipient The identity of the recipient or contract
+     * @param amount The amount to transfer
+     * @param tick The tick at which the transaction should be executed
+     * @param inputType The type of the input
+     * @param input The input payload
+     * @return The receipt upon success, else the error that occurred
+     */
+    template <typename T>
+    tl::expected<Receipt, TransactionError> Add(
+        const std::string& recipient,
+        long long amount,
+        unsigned int tick,
+        unsigned short inputType,
+        const T& input)
+    {
+        static_assert(sizeof(T) <= MAX_INPUT_SIZE, "Transaction input is too large");
+        return Add(recipient, amount, tick, inputType, &input, (unsigned short)sizeof(T));
+    }
+
+    /**
+     * Get the packets
+     * @return The packets back to back
+     */
+    const char* GetData() const;
+
+    /**
+     * Get the size of the packets
+     * @return The size of all packets in bytes
+     */
+    size_t GetSize() const;
+
+    /**
+     * Get the receipts
+     * @return The receipt of each transaction, in the order of the packets
+     */
+    const std::vector<Receipt>& GetReceipts() const;
+
+    /**
+     * Remove all transactions, the buffer keeps its capacity
+     */
+    void Clear();
+
+    /**
+     * Broadcast all transactions with a single send
+     * @param connection The node to broadcast to
+     * @return `true` upon success, else the error that occurred
+     */
+    tl::expected<bool, TransactionError> Broadcast(const ConnectionPtr& connection) const;
+
+    /**
+     * Broadcast all transactions to multiple nodes at once, see `BroadcastToNodes`
+     * @param nodes The nodes to broadcast to
+     * @param timeout The maximum time to connect, and the maximum time to send, per node
+     * @return The outcome of each node if any node accepted the transactions, else an error
+     */
+    tl::expected<std::vector<NodeBroadcastResult>, TransactionError> Broadcast(
+        const std::vector<NodeAddress>& nodes,
+        std::chrono::milliseconds timeout) const;
+
+private:
+    /// Signing key of the sender
+    SigningKeyPtr m_signingKey;
+
+    /// Header, transaction, input and signature of each packet, back to back
+    std::vector<char> m_buffer;
+
+    /// Receipt of each transaction
+    std::vector<Receipt> m_receipts;
+};
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <tl/expected.hpp>
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "network/transactions.hpp"
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * A failed transfer that should be signed and broadcast again
+ */
+struct RetryRequest
+{
+    /// Idempotency key of the transfer
+    std::string key;
+
+    /// Signing key of the sender
+    SigningKeyPtr signingKey;
+
+    /// The transfer to retry
+    Transfer transfer;
+
+    /// Number of attempts so far
+    size_t attempts;
+};
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Re-broadcasts failed transfers at a new tick, at most once per failed attempt
+ *
+ * Every transfer is tracked under an idempotency key chosen by the caller, e.g. a payout id or
+ * the hash of the first attempt. A key only accepts a new attempt when all previous attempts
+ * failed, and a failed transaction can no longer be executed once its tick has passed, so a
+ * transfer is paid at most once however often it is retried. All attempts of a key are kept in
+ * order, from the original receipt to the last retry. The retrier is thread-safe.
+ */
+class TransferRetrier
+{
+public:
+    /// Default number of attempts of a transfer, including the first broadcast
+    static constexpr size_t defaultMaximumAttempts = 3;
+
+    /**
+     * Constructor
+     * @param maximumAttempts The number of attempts of a transfer, including the first broadcast
+     */
+    explicit TransferRetrier(size_t maximumAttempts = defaultMaximumAttempts);
+
+    /**
+     * Track a broadcast transfer, either the first attempt or a retry
+     * @param key The idempotency key of the transfer
+     * @param signingKey The signing key of the sender
+     * @param receipt The receipt of the broadcast
+     * @return `true` upon success, else an error if the key has an attempt that did not fail or
+     * has no attempts left
+     */
+    tl::expected<bool, TransactionError> Track(
+        const std::string& key,
+        SigningKeyPtr signingKey,
+        const Receipt& receipt);
+
+    /**
+     * Check if a key accepts a new attempt, i.e. it is unknown or all its attempts failed
+     * @param key The idempotency key of the transfer
+     * @return `true` if a transfer may be broadcast under the key, else `false`
+     */
+    bool CanBroadcast(const std::string& key) const;
+
+    /**
+     * Update the status of an attempt
+     * @param receipt The confirmed receipt of an attempt
+     * @return The transfer to retry if the attempt failed and attempts are left, else the reason
+     * it is not retried
+     */
+    tl::expected<RetryRequest, TransactionError> Confirm(const Receipt& receipt);
+
+    /**
+     * Sign and broadcast a retry at a new tick, and track it
+     * @param connection The node to broadcast to
+     * @param request The retry
+     * @param tick The tick at which the retry should be executed
+     * @return The receipt of the retry upon success, else the error that occurred
+     */
+    tl::expected<Receipt, TransactionError> Retry(
+        const ConnectionPtr& connection,
+        const RetryRequest& request,
+        unsigned int tick);
+
+    /**
+     * Get all attempts of a transfer
+     * @param key The idempotency key of the transfer
+     * @return The receipts of all attempts, oldest first
+     */
+    std::vector<Receipt> GetAttempts(const std::string& key) const;
+
+    /**
+     * Get the idempotency key of an attempt
+     * @param hash The transaction hash of the attempt
+     * @return The idempotency key, empty if the hash is unknown
+     */
+    std::string GetKey(const std::string& hash) const;
+
+private:
+    /**
+     * A transfer and its attempts
+     */
+    struct Lineage
+    {
+        /// Signing key of the sender
+        SigningKeyPtr signingKey;
+
+        /// Receipts of all attempts, oldest first
+        std::vector<Receipt> attempts;
+    };
+
+private:
+    /// Number of attempts of a transfer, including the first broadcast
+    size_t m_maximumAttempts;
+
+    /// Transfers by idempotency key
+    std::unordered_map<std::string, Lineage> m_lineages;
+
+    /// Idempotency keys by transaction hash
+    std::unordered_map<std::string, std::string> m_keys;
+
+    /// Guard for the transfers
+    mutable std::mutex m_mutex;
+};
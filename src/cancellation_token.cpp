@@ -0,0 +1,30 @@
+#include "cancellation_token.hpp"
+
+// ------------------------------------------------------------------------------------------------
+CancellationToken::CancellationToken()
+    : m_state(std::make_shared<State>())
+{}
+
+// ------------------------------------------------------------------------------------------------
+void CancellationToken::Cancel() const { m_state->bCancelled = true; }
+
+// ------------------------------------------------------------------------------------------------
+bool CancellationToken::IsCancelled() const
+{
+    for (const State* state = m_state.get(); state; state = state->parent.get())
+    {
+        if (state->bCancelled)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// ------------------------------------------------------------------------------------------------
+CancellationToken CancellationToken::CreateLinked() const
+{
+    CancellationToken linked;
+    linked.m_state->parent = m_state;
+    return linked;
+}
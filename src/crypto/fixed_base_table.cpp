@@ -0,0 +1,296 @@
+#include "crypto/fixed_base_table.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <mutex>
+
+#include "core/four_q.h"
+#include "core/four_q_x4.h"
+
+// ------------------------------------------------------------------------------------------------
+namespace
+{
+
+/// Words per table entry (x+y,y-x,2dt)
+constexpr size_t entryWords = sizeof(point_precomp) / sizeof(unsigned long long);
+
+/// Cache file identification, bump the version when the layout changes
+constexpr char cacheMagic[8] = {'Q', 'W', 'F', 'B', 'T', 'B', 'L', '1'};
+
+/**
+ * Cache file header, followed by the table entries
+ */
+struct CacheHeader
+{
+    char magic[8];
+    unsigned int windowWidth;
+    unsigned int reserved;
+    unsigned long long entryWordCount;
+    unsigned char digest[32];
+};
+
+/// Table used by `ComputePublicKey`, `nullptr` for the compiled-in table
+FixedBaseTablePtr selectedTable;
+
+/// Guard for the selected table
+std::mutex selectedTableMutex;
+
+size_t GetEntryWordCount(unsigned int windowWidth)
+{
+    return (size_t)FIXED_WINDOW_COUNT(windowWidth) * ((size_t)1 << (windowWidth - 1)) *
+           entryWords;
+}
+
+bool IsValidWindowWidth(unsigned int windowWidth)
+{
+    return windowWidth >= FIXED_WINDOW_MIN_WIDTH && windowWidth <= FIXED_WINDOW_MAX_WIDTH;
+}
+
+void ComputeDigest(const std::vector<unsigned long long>& entries, unsigned char* digest)
+{
+    KangarooTwelve(
+        (const unsigned char*)entries.data(),
+        (unsigned int)(entries.size() * sizeof(unsigned long long)),
+        digest,
+        32);
+}
+
+} // namespace
+// ------------------------------------------------------------------------------------------------
+
+// ------------------------------------------------------------------------------------------------
+FixedBaseTable::FixedBaseTable(
+    unsigned int windowWidth,
+    std::vector<unsigned long long> entries) noexcept
+    : m_windowWidth(windowWidth)
+    , m_entries(std::move(entries))
+{}
+
+// ------------------------------------------------------------------------------------------------
+unsigned int FixedBaseTable::GetWindowWidth() const { return m_windowWidth; }
+
+// ------------------------------------------------------------------------------------------------
+size_t FixedBaseTable::GetMemorySize() const
+{
+    return m_entries.size() * sizeof(unsigned long long);
+}
+
+// ------------------------------------------------------------------------------------------------
+void FixedBaseTable::GetPublicKey(const unsigned char* privateKey, unsigned char* publicKey) const
+{
+    unsigned long long scalar[4];
+    point_t P;
+
+    memcpy(scalar, privateKey, sizeof(scalar));
+    ecc_mul_fixed_window((const point_precomp*)m_entries.data(), m_windowWidth, scalar, P);
+    encode(P, publicKey);
+}
+
+// ------------------------------------------------------------------------------------------------
+tl::expected<bool, FixedBaseTableError> FixedBaseTable::Save(const std::string& path) const
+{
+    CacheHeader header{};
+    memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+    header.windowWidth = m_windowWidth;
+    header.entryWordCount = m_entries.size();
+    ComputeDigest(m_entries, header.digest);
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        return tl::make_unexpected(FixedBaseTableError{"Failed to open " + path + " for writing"});
+    }
+
+    file.write((const char*)&header, sizeof(header));
+    file.write((const char*)m_entries.data(), (std::streamsize)GetMemorySize());
+    if (!file)
+    {
+        return tl::make_unexpected(FixedBaseTableError{"Failed to write " + path});
+    }
+
+    return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+tl::expected<FixedBaseTablePtr, FixedBaseTableError> CreateFixedBaseTable(unsigned int windowWidth)
+{
+    if (!IsValidWindowWidth(windowWidth))
+    {
+        return tl::make_unexpected(FixedBaseTableError{
+            "Window width must be between " + std::to_string(FIXED_WINDOW_MIN_WIDTH) + " and " +
+            std::to_string(FIXED_WINDOW_MAX_WIDTH)});
+    }
+
+    const size_t multipleCount = (size_t)1 << (windowWidth - 1);
+    std::vector<unsigned long long> entries(GetEntryWordCount(windowWidth));
+    std::vector<point_extproj> multiples(multipleCount);
+    std::unique_ptr<f2elm_t[]> products(new f2elm_t[multipleCount]);
+
+    // base = G, computed from the compiled-in table
+    unsigned long long one[4] = {1, 0, 0, 0};
+    point_t generator;
+    point_extproj_t base;
+    ecc_mul_fixed(one, generator);
+    point_setup(generator, base);
+
+    auto* entry = (point_precomp*)entries.data();
+    for (unsigned int window = 0; window < FIXED_WINDOW_COUNT(windowWidth); window++)
+    {
+        // odd multiples (2j+1)*base, advancing by 2*base
+        point_extproj_t doubled;
+        point_extproj_precomp_t doubledPrecomp;
+        memcpy(doubled, base, sizeof(point_extproj));
+        eccdouble(doubled);
+        R1_to_R2(doubled, doubledPrecomp);
+
+        memcpy(&multiples[0], base, sizeof(point_extproj));
+        memcpy(products[0], multiples[0].z, sizeof(f2elm_t));
+        for (size_t j = 1; j < multipleCount; j++)
+        {
+            multiples[j] = multiples[j - 1];
+            eccadd(doubledPrecomp, &multiples[j]);
+            fp2mul1271(products[j - 1], multiples[j].z, products[j]);
+        }
+
+        // normalize all multiples with a single inversion
+        f2elm_t inverse, zInverse, x, y;
+        memcpy(inverse, products[multipleCount - 1], sizeof(f2elm_t));
+        fp2inv1271(inverse);
+        for (size_t j = multipleCount; j--;)
+        {
+            if (j > 0)
+            {
+                fp2mul1271(inverse, products[j - 1], zInverse);
+                fp2mul1271(inverse, multiples[j].z, inverse);
+            }
+            else
+            {
+                memcpy(zInverse, inverse, sizeof(f2elm_t));
+            }
+
+            fp2mul1271(multiples[j].x, zInverse, x);
+            fp2mul1271(multiples[j].y, zInverse, y);
+
+            point_precomp& precomp = entry[j];
+            fp2add1271(x, y, precomp.xy);
+            fp2sub1271(y, x, precomp.yx);
+            fp2mul1271(x, y, precomp.t2);
+            fp2add1271(precomp.t2, precomp.t2, precomp.t2);
+            fp2mul1271(precomp.t2, (felm_t*)&PARAMETER_d, precomp.t2);
+            for (auto* coordinate : {precomp.xy, precomp.yx, precomp.t2})
+            {
+                mod1271(coordinate[0]);
+                mod1271(coordinate[1]);
+            }
+        }
+        entry += multipleCount;
+
+        // base = 2^w*base
+        for (unsigned int i = 0; i < windowWidth; i++)
+        {
+            eccdouble(base);
+        }
+    }
+
+    return FixedBaseTablePtr(new FixedBaseTable(windowWidth, std::move(entries)));
+}
+
+// ------------------------------------------------------------------------------------------------
+tl::expected<FixedBaseTablePtr, FixedBaseTableError> LoadFixedBaseTable(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        return tl::make_unexpected(FixedBaseTableError{"Failed to open " + path});
+    }
+
+    CacheHeader header{};
+    if (!file.read((char*)&header, sizeof(header)) ||
+        memcmp(header.magic, cacheMagic, sizeof(cacheMagic)) != 0)
+    {
+        return tl::make_unexpected(FixedBaseTableError{path + " is not a fixed-base table"});
+    }
+
+    if (!IsValidWindowWidth(header.windowWidth) ||
+        header.entryWordCount != GetEntryWordCount(header.windowWidth))
+    {
+        return tl::make_unexpected(FixedBaseTableError{path + " has an invalid table size"});
+    }
+
+    std::vector<unsigned long long> entries(header.entryWordCount);
+    if (!file.read((char*)entries.data(), (std::streamsize)(entries.size() * sizeof(entries[0]))))
+    {
+        return tl::make_unexpected(FixedBaseTableError{path + " is truncated"});
+    }
+
+    unsigned char digest[32];
+    ComputeDigest(entries, digest);
+    if (memcmp(digest, header.digest, sizeof(digest)) != 0)
+    {
+        return tl::make_unexpected(FixedBaseTableError{path + " is corrupted"});
+    }
+
+    return FixedBaseTablePtr(new FixedBaseTable(header.windowWidth, std::move(entries)));
+}
+
+// ------------------------------------------------------------------------------------------------
+tl::expected<FixedBaseTablePtr, FixedBaseTableError> LoadOrCreateFixedBaseTable(
+    const std::string& path,
+    unsigned int windowWidth)
+{
+    auto table = LoadFixedBaseTable(path);
+    if (table && (*table)->GetWindowWidth() == windowWidth)
+    {
+        return table;
+    }
+
+    table = CreateFixedBaseTable(windowWidth);
+    if (table)
+    {
+        // the cache is only an optimization, the table is usable even if it can't be written
+        (*table)->Save(path);
+    }
+    return table;
+}
+
+// ------------------------------------------------------------------------------------------------
+void SelectFixedBaseTable(FixedBaseTablePtr table)
+{
+    std::lock_guard<std::mutex> lock(selectedTableMutex);
+    selectedTable = std::move(table);
+}
+
+// ------------------------------------------------------------------------------------------------
+FixedBaseTablePtr GetSelectedFixedBaseTable()
+{
+    std::lock_guard<std::mutex> lock(selectedTableMutex);
+    return selectedTable;
+}
+
+// ------------------------------------------------------------------------------------------------
+void ComputePublicKey(const unsigned char* privateKey, unsigned char* publicKey)
+{
+    if (const auto table = GetSelectedFixedBaseTable())
+    {
+        table->GetPublicKey(privateKey, publicKey);
+        return;
+    }
+    getPublicKey(privateKey, publicKey);
+}
+
+// ------------------------------------------------------------------------------------------------
+void ComputePublicKeys(
+    const unsigned char* privateKeys,
+    unsigned char* publicKeys,
+    unsigned int count)
+{
+    if (const auto table = GetSelectedFixedBaseTable())
+    {
+        for (unsigned int i = 0; i < count; i++)
+        {
+            table->GetPublicKey(privateKeys + 32 * i, publicKeys + 32 * i);
+        }
+        return;
+    }
+    getPublicKeys(privateKeys, publicKeys, count);
+}
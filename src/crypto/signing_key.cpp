@@ -0,0 +1,52 @@
+#include "crypto/signing_key.hpp"
+
+#include "core/four_q.h"
+#include "core/four_q_x4.h"
+#include "crypto/fixed_base_table.hpp"
+#include "wallet.hpp"
+
+// ------------------------------------------------------------------------------------------------
+const unsigned char* SigningKey::GetPublicKey() const { return m_publicKey; }
+
+// ------------------------------------------------------------------------------------------------
+const std::string& SigningKey::GetIdentity() const { return m_identity; }
+
+// ------------------------------------------------------------------------------------------------
+void SigningKey::Sign(const unsigned char* messageDigest, unsigned char* signature) const
+{
+    sign_expanded(m_expandedKey, m_publicKey, messageDigest, signature);
+}
+
+// ------------------------------------------------------------------------------------------------
+void SigningKey::Sign(
+    const unsigned char* messageDigests,
+    unsigned int count,
+    unsigned char* signatures) const
+{
+    signEach(m_expandedKey, m_publicKey, messageDigests, count, signatures);
+}
+
+// ------------------------------------------------------------------------------------------------
+tl::expected<SigningKeyPtr, SigningKeyError> CreateSigningKey(const std::string& seed)
+{
+    std::string errorMessage;
+    if (!IsValidSeed(errorMessage, seed))
+    {
+        return tl::make_unexpected(SigningKeyError{errorMessage});
+    }
+
+    unsigned char subseed[32] = {0};
+    unsigned char privateKey[32] = {0};
+    getSubseed((const unsigned char*)seed.data(), subseed);
+    getPrivateKey(subseed, privateKey);
+
+    std::shared_ptr<SigningKey> signingKey(new SigningKey());
+    sign_expand_key(subseed, signingKey->m_expandedKey);
+    ComputePublicKey(privateKey, signingKey->m_publicKey);
+
+    char identity[61] = {0};
+    getIdentity(signingKey->m_publicKey, identity, false);
+    signingKey->m_identity = identity;
+
+    return signingKey;
+}
@@ -0,0 +1,99 @@
+#include "crypto/verification_context.hpp"
+
+#include "core/four_q.h"
+
+// ------------------------------------------------------------------------------------------------
+struct VerificationContext::Entry
+{
+    /// `false` if the public key is not a valid point encoding
+    bool bValid;
+
+    /// Variable-base tables of the double scalar multiplication
+    point_double_precomp_t tables;
+};
+
+// ------------------------------------------------------------------------------------------------
+VerificationContext::VerificationContext(size_t capacity)
+    : m_capacity(capacity > 0 ? capacity : 1)
+{}
+
+// ------------------------------------------------------------------------------------------------
+bool VerificationContext::Verify(
+    const unsigned char* publicKey,
+    const unsigned char* messageDigest,
+    const unsigned char* signature)
+{
+    if (publicKey[15] & 0x80)
+    {
+        return false;
+    }
+
+    const auto entry = GetEntry(m256i(publicKey));
+    if (!entry->bValid)
+    {
+        return false;
+    }
+
+    // the tables are only read, the C interface just doesn't know about const
+    return verify_precomp(
+        const_cast<point_double_precomp*>(entry->tables),
+        publicKey,
+        messageDigest,
+        signature);
+}
+
+// ------------------------------------------------------------------------------------------------
+size_t VerificationContext::GetSize() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_entries.size();
+}
+
+// ------------------------------------------------------------------------------------------------
+size_t VerificationContext::GetCapacity() const { return m_capacity; }
+
+// ------------------------------------------------------------------------------------------------
+void VerificationContext::Clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.clear();
+    m_recentlyUsed.clear();
+}
+
+// ------------------------------------------------------------------------------------------------
+std::shared_ptr<const VerificationContext::Entry> VerificationContext::GetEntry(
+    const m256i& publicKey)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const auto it = m_entries.find(publicKey);
+        if (it != m_entries.end())
+        {
+            m_recentlyUsed.splice(m_recentlyUsed.begin(), m_recentlyUsed, it->second.second);
+            return it->second.first;
+        }
+    }
+
+    // decode outside of the lock, another thread may insert the same key meanwhile
+    auto entry = std::make_shared<Entry>();
+    point_t A;
+    entry->bValid = decode(publicKey.m256i_u8, A) && ecc_precomp_double_point(A, entry->tables);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const auto it = m_entries.find(publicKey);
+    if (it != m_entries.end())
+    {
+        m_recentlyUsed.splice(m_recentlyUsed.begin(), m_recentlyUsed, it->second.second);
+        return it->second.first;
+    }
+
+    if (m_entries.size() >= m_capacity)
+    {
+        m_entries.erase(m_recentlyUsed.back());
+        m_recentlyUsed.pop_back();
+    }
+    m_recentlyUsed.push_front(publicKey);
+    m_entries.emplace(publicKey, std::make_pair(entry, m_recentlyUsed.begin()));
+
+    return entry;
+}
@@ -0,0 +1,244 @@
+#include "executor.hpp"
+
+#include <algorithm>
+#include <utility>
+
+// ------------------------------------------------------------------------------------------------
+namespace
+{
+/// Executor of the worker running on this thread, if any
+thread_local const void* currentExecutor = nullptr;
+
+/// Index of the worker running on this thread
+thread_local size_t currentWorker = 0;
+} // namespace
+
+// ------------------------------------------------------------------------------------------------
+CompletionQueue::~CompletionQueue()
+{
+    auto* node = m_head.exchange(nullptr);
+    while (node)
+    {
+        delete std::exchange(node, node->next);
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+void CompletionQueue::Push(std::function<void()> completion, CancellationToken token)
+{
+    auto* node = new Node{std::move(completion), std::move(token)};
+    node->next = m_head.load(std::memory_order_relaxed);
+    while (!m_head.compare_exchange_weak(
+        node->next,
+        node,
+        std::memory_order_release,
+        std::memory_order_relaxed))
+    {
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+size_t CompletionQueue::Drain()
+{
+    // Taking the whole stack at once leaves nothing to race over
+    auto* node = m_head.exchange(nullptr, std::memory_order_acquire);
+
+    // The stack is newest first
+    Node* oldest = nullptr;
+    while (node)
+    {
+        oldest = std::exchange(node, std::exchange(node->next, oldest));
+    }
+
+    size_t count = 0;
+    while (oldest)
+    {
+        std::unique_ptr<Node> current(std::exchange(oldest, oldest->next));
+        if (!current->token.IsCancelled())
+        {
+            current->completion();
+            ++count;
+        }
+    }
+    return count;
+}
+
+// ------------------------------------------------------------------------------------------------
+Executor::Executor(unsigned int threadCount)
+{
+    if (threadCount == 0)
+    {
+        threadCount = std::max(std::thread::hardware_concurrency(), 2u);
+    }
+
+    // Leave a worker for other lanes, unless there is only one
+    m_maximumBulkCount = std::max(threadCount - 1, 1u);
+
+    for (unsigned int i = 0; i < threadCount; ++i)
+    {
+        m_workers.push_back(std::make_unique<Worker>());
+    }
+    for (size_t i = 0; i < threadCount; ++i)
+    {
+        m_threads.emplace_back(&Executor::Run, this, i);
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+Executor::~Executor()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_bStop = true;
+    }
+    m_condition.notify_all();
+
+    for (auto& thread : m_threads)
+    {
+        thread.join();
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+void Executor::PostCompletion(std::function<void()> completion, CancellationToken token)
+{
+    m_completions.Push(std::move(completion), std::move(token));
+}
+
+// ------------------------------------------------------------------------------------------------
+size_t Executor::DrainCompletions() { return m_completions.Drain(); }
+
+// ------------------------------------------------------------------------------------------------
+unsigned int Executor::GetThreadCount() const { return (unsigned int)m_workers.size(); }
+
+// ------------------------------------------------------------------------------------------------
+void Executor::Schedule(TaskPriority priority, Job job)
+{
+    const auto lane = (size_t)priority;
+
+    // Jobs of a worker stay on it, unless another worker runs out of work
+    const auto index = currentExecutor == this ? currentWorker
+                                               : m_nextWorker++ % m_workers.size();
+
+    // Counted before queueing so that the count never drops below the number of queued jobs
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_queuedCounts[lane];
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_workers[index]->mutex);
+        m_workers[index]->lanes[lane].push_back(std::move(job));
+    }
+    m_condition.notify_one();
+}
+
+// ------------------------------------------------------------------------------------------------
+void Executor::Run(size_t index)
+{
+    currentExecutor = this;
+    currentWorker = index;
+
+    while (true)
+    {
+        Job job;
+        size_t lane = 0;
+        if (TakeJob(index, job, lane))
+        {
+            if (!job.token.IsCancelled())
+            {
+                job.run(job.token);
+            }
+            if (lane == (size_t)TaskPriority::Bulk)
+            {
+                ReleaseBulk();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_condition.wait(lock, [this]() { return m_bStop || HasRunnableJob(); });
+        if (m_bStop)
+        {
+            return;
+        }
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+bool Executor::TakeJob(size_t index, Job& outJob, size_t& outLane)
+{
+    for (size_t lane = 0; lane < laneCount; ++lane)
+    {
+        if (m_queuedCounts[lane] == 0)
+        {
+            continue;
+        }
+
+        const bool bBulk = lane == (size_t)TaskPriority::Bulk;
+        if (bBulk && !ReserveBulk())
+        {
+            continue;
+        }
+
+        // The own queue first, then the others
+        for (size_t i = 0; i < m_workers.size(); ++i)
+        {
+            auto& worker = *m_workers[(index + i) % m_workers.size()];
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            auto& queue = worker.lanes[lane];
+            if (queue.empty())
+            {
+                continue;
+            }
+
+            if (i == 0)
+            {
+                outJob = std::move(queue.front());
+                queue.pop_front();
+            }
+            else
+            {
+                outJob = std::move(queue.back());
+                queue.pop_back();
+            }
+            --m_queuedCounts[lane];
+            outLane = lane;
+            return true;
+        }
+
+        if (bBulk)
+        {
+            ReleaseBulk();
+        }
+    }
+    return false;
+}
+
+// ------------------------------------------------------------------------------------------------
+bool Executor::ReserveBulk()
+{
+    auto count = m_bulkCount.load();
+    while (count < m_maximumBulkCount && !m_bulkCount.compare_exchange_weak(count, count + 1))
+    {
+    }
+    return count < m_maximumBulkCount;
+}
+
+// ------------------------------------------------------------------------------------------------
+void Executor::ReleaseBulk()
+{
+    // Under the lock, so that a worker waiting for a bulk slot doesn't miss the wake up
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        --m_bulkCount;
+    }
+    m_condition.notify_one();
+}
+
+// ------------------------------------------------------------------------------------------------
+bool Executor::HasRunnableJob() const
+{
+    return m_queuedCounts[(size_t)TaskPriority::Interactive] > 0 ||
+           m_queuedCounts[(size_t)TaskPriority::Background] > 0 ||
+           (m_queuedCounts[(size_t)TaskPriority::Bulk] > 0 && m_bulkCount < m_maximumBulkCount);
+}
@@ -1,10 +1,11 @@
 #include "gui/wallet_window.hpp"
 
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
 #include <cstring>
-#include <future>
 #include <iostream>
-#include <mutex>
-#include <thread>
+#include <optional>
 
 #include "core/four_q.h"
 #include "network/connection.hpp"
@@ -17,6 +18,19 @@
 namespace
 {
 
+/// Maximum time of a request of the window, from connecting until the last receive
+constexpr std::chrono::seconds requestTimeout{15};
+
+/**
+ * Get the path of the peer table, e.g. QWALLET_PEER_TABLE=<path>, else in the working directory
+ * @return The path
+ */
+std::string GetPeerTablePath()
+{
+    const char* path = std::getenv("QWALLET_PEER_TABLE");
+    return path ? path : "qwallet_peers.txt";
+}
+
 int LowercaseFilter(ImGuiInputTextCallbackData* data)
 {
     if (data->EventChar >= 'A' && data->EventChar <= 'Z')
@@ -92,105 +106,52 @@ unsigned int StatusToColor(Receipt::Status status)
 // ------------------------------------------------------------------------------------------------
 WalletWindow::WalletWindow(std::string name, bool bShow, bool bCanClose)
     : Window(std::move(name), bShow, bCanClose)
-{}
+    , m_peerCrawler(m_nodeRegistry, GetPeerTablePath())
+{
+    // Start with the best nodes of the previous run, the table doesn't exist on the first run
+    LoadPeerTable(m_nodeRegistry, GetPeerTablePath());
+
+    m_tickTracker.SetRegistry(m_nodeRegistry);
+    m_peerCrawler.Start();
+}
 
 // ------------------------------------------------------------------------------------------------
 WalletWindow::~WalletWindow()
 {
-    if (m_bWaitingForBruteForce)
-    {
-        // wait maximally 5 seconds for the brute force threads to clean up, if it is still running
-        // while exiting
-        m_stopBruteForce = true;
-        m_bruteForceFuture.wait_for(std::chrono::seconds(5));
-    }
+    // Stop the brute force right away, and drop results that nobody waits for anymore
+    m_bruteForceToken.Cancel();
+    m_cancellation.Cancel();
 }
 
 // ------------------------------------------------------------------------------------------------
 void WalletWindow::Update(GLFWwindow* glfwWindow, double deltaTime)
 {
-    // Quick timer from deltaTime without using chrono and other stuffs
-    static double timer = 0.0;
-    timer += deltaTime;
+    // Results of finished work, e.g. tick data and retried transfers
+    m_executor.DrainCompletions();
 
-    // - - - - - - - - - - - - - - - - - - - -
-    // Check actual tick data for transactions
-    static std::future<tl::expected<BroadcastFutureTickData, ConnectionError>> tickDataFuture;
-    static bool bWaitingForTickData{false};
+    // - - - - - - - - - - - - - - - - - - - - -
+    // Current tick from the background tracker
+    static unsigned int latestTick{0};
+    static std::string trackedNode;
 
-    if (bWaitingForTickData)
+    if (trackedNode != m_ipAddress + ":" + m_port && IsValidIp(m_ipAddress))
     {
-        if (tickDataFuture.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
-        {
-            auto result = tickDataFuture.get();
-            if (result.has_value())
-            {
-                auto tickData = result.value().tickData;
-                std::cout << "Processing tick " << tickData.tick << std::endl;
-
-                auto it = m_confirmingTransactions.begin();
-                while (it != m_confirmingTransactions.end())
-                {
-                    if (it->tick == tickData.tick)
-                    {
-                        if (ContainsTransaction(tickData, it->hash))
-                        {
-                            it->status = Receipt::Success;
-                        }
-                        else
-                        {
-                            it->status = Receipt::Failed;
-                        }
-
-                        std::cout << "Confirmed (" << StatusToString(it->status)
-                                  << ") transaction hash " << it->hash << " in tick "
-                                  << tickData.tick << std::endl;
-
-                        m_history.push_back(*it);
-                        it = m_confirmingTransactions.erase(it);
-                    }
-                    else
-                    {
-                        ++it;
-                    }
-                }
-            }
-            else
-            {
-                std::cout << "Failed to query tick data: " << result.error().message << std::endl;
-            }
-
-            bWaitingForTickData = false;
-        }
+        trackedNode = m_ipAddress + ":" + m_port;
+        AddNode(m_ipAddress, m_port);
     }
 
-    // - - - - - - - - - - - - - -
-    // Request current tick number
-    static std::future<tl::expected<unsigned int, ConnectionError>> tickFuture;
-    static bool bWaitingForTick{false};
-    static unsigned int latestTick{0};
-
-    if (bWaitingForTick)
+    // Only confirm ticks the node has reached, not predicted ones
+    auto tickInfo = m_tickTracker.GetTickInfo();
+    if (tickInfo.has_value() && tickInfo->tick != latestTick)
     {
-        if (tickFuture.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
-        {
-            auto result = tickFuture.get();
-            if (result.has_value())
-            {
-                latestTick = result.value();
-                std::cout << "Received latest tick: " << latestTick << std::endl;
-            }
-            else
-            {
-                std::cout << "Failed to query latest tick: " << result.error().message << std::endl;
-            }
-
-            bWaitingForTick = false;
-        }
+        latestTick = tickInfo->tick;
+        m_tickOffsetEstimator.AddTickDuration(tickInfo->tickDuration);
     }
 
     // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
     // Check if ticks can be confirmed if currently not confirming
+    static bool bWaitingForTickData{false};
+
     if (!bWaitingForTickData && latestTick != 0)
     {
         unsigned int tickToConfirm = 0;
@@ -208,46 +169,124 @@ void WalletWindow::Update(GLFWwindow* glfwWindow, double deltaTime)
         if (bCanConfirmReceipt)
         {
             std::cout << "Requesting tick data of tick " << tickToConfirm << std::endl;
-            tickDataFuture = std::async(
-                std::launch::async,
-                [=]() -> tl::expected<BroadcastFutureTickData, ConnectionError> {
-                    auto connection = CreateConnection(m_ipAddress, atoi(m_port.c_str()));
-                    if (!connection.has_value())
-                    {
-                        return tl::make_unexpected(connection.error());
-                    }
-
-                    return GetTickData(connection.value(), tickToConfirm);
-                });
+            GetTickDataAsync(
+                m_hedger,
+                m_nodeRegistry.SelectNodes(),
+                tickToConfirm,
+                [this](tl::expected<BroadcastFutureTickData, ConnectionError> result) {
+                    // Completed on the engine thread, the receipts belong to the GUI thread
+                    m_executor.PostCompletion(
+                        [this, result = std::move(result)]() {
+                            if (result.has_value())
+                            {
+                                ConfirmTickData(result->tickData);
+                            }
+                            else
+                            {
+                                std::cout << "Failed to query tick data: "
+                                          << result.error().message << std::endl;
+                            }
+                            bWaitingForTickData = false;
+                        },
+                        m_cancellation);
+                },
+                AsyncEngine::defaultTimeout,
+                m_cancellation);
             bWaitingForTickData = true;
         }
     }
+}
 
-    // - - - - - - - - - - - - - - - - - - - - - - - -
-    // Check transaction confirmations once per second
-    if (timer > 1.0)
+// ------------------------------------------------------------------------------------------------
+void WalletWindow::ConfirmTickData(const TickData& tickData)
+{
+    std::cout << "Processing tick " << tickData.tick << std::endl;
+
+    auto it = m_confirmingTransactions.begin();
+    while (it != m_confirmingTransactions.end())
     {
-        // Query latest tick for transactions that need to be confirmed
-        if (!bWaitingForTick && !m_confirmingTransactions.empty())
+        if (it->tick == tickData.tick)
         {
-            tickFuture = std::async(
-                std::launch::async,
-                [&]() -> tl::expected<unsigned int, ConnectionError> {
-                    auto connection = CreateConnection(m_ipAddress, atoi(m_port.c_str()));
-                    if (!connection.has_value())
-                    {
-                        return tl::make_unexpected(connection.error());
-                    }
+            if (ContainsTransaction(tickData, it->hash))
+            {
+                it->status = Receipt::Success;
+            }
+            else
+            {
+                it->status = Receipt::Failed;
+            }
 
-                    return GetTick(connection.value());
-                });
-            bWaitingForTick = true;
-        }
+            const auto offset = m_tickOffsets.find(it->hash);
+            if (offset != m_tickOffsets.end())
+            {
+                m_tickOffsetEstimator.AddOutcome(offset->second, it->status == Receipt::Success);
+                m_tickOffsets.erase(offset);
+            }
 
-        timer -= 1.0;
+            // Re-broadcast failed transfers at a new tick if enabled
+            auto retry = m_transferRetrier.Confirm(*it);
+            if (retry.has_value() && m_bRetryFailedTransactions)
+            {
+                RetryTransfer(retry.value());
+            }
+
+            std::cout << "Confirmed (" << StatusToString(it->status) << ") transaction hash "
+                      << it->hash << " in tick " << tickData.tick << std::endl;
+
+            m_history.push_back(*it);
+            it = m_confirmingTransactions.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
     }
 }
 
+// ------------------------------------------------------------------------------------------------
+void WalletWindow::RetryTransfer(const RetryRequest& request)
+{
+    const auto tickOffset = m_tickOffsetEstimator.GetTickOffset();
+    m_executor.Post(
+        TaskPriority::Background,
+        [this, request, tickOffset](
+            const CancellationToken& token) -> tl::expected<Receipt, TransactionError> {
+            const auto deadline = Deadline::After(requestTimeout, token);
+            auto connection = CreateConnection(m_nodeRegistry, deadline);
+            if (!connection.has_value())
+            {
+                return tl::make_unexpected(TransactionError{connection.error().message});
+            }
+
+            // Ask a node if the tracker hasn't sampled one yet
+            auto tick = m_tickTracker.GetTick();
+            if (!tick.has_value())
+            {
+                tick = GetTick(m_coalescer, m_nodeRegistry, deadline);
+            }
+            if (!tick.has_value())
+            {
+                return tl::make_unexpected(TransactionError{tick.error().message});
+            }
+
+            return m_transferRetrier.Retry(connection.value(), request, tick.value() + tickOffset);
+        },
+        [this, tickOffset](tl::expected<Receipt, TransactionError> result) {
+            if (result.has_value())
+            {
+                std::cout << "Retried transfer " << m_transferRetrier.GetKey(result->hash)
+                          << " as " << result->hash << " in tick " << result->tick << std::endl;
+                m_confirmingTransactions.push_back(result.value());
+                m_tickOffsets[result->hash] = tickOffset;
+            }
+            else
+            {
+                std::cout << "Failed to retry transfer: " << result.error().message << std::endl;
+            }
+        },
+        m_cancellation);
+}
+
 // ------------------------------------------------------------------------------------------------
 void WalletWindow::Render()
 {
@@ -282,34 +321,32 @@ void WalletWindow::Render()
 
 // ------------------------------------------------------------------------------------------------
 /**
- * Thread to brute force a specific prefix
- * @param stopBruteForce Atomic boolean to cancel the brute force operation
+ * Brute force a specific prefix on one worker
+ * @param token Token to cancel the brute force operation
+ * @param bFound Shared by the workers, set by the first one that finds a wallet
  * @param prefix The prefix to look for
- * @param outResult The variable to write the result too
- * @param resultMutex Mutex to safely write the result
+ * @return The wallet, else nothing if cancelled or found by another worker
  */
-void BruteForceWalletThread(
-    std::atomic<bool>& stopBruteForce,
-    std::string prefix,
-    Wallet& outResult,
-    std::mutex& resultMutex)
+std::optional<Wallet> BruteForceWallet(
+    const CancellationToken& token,
+    std::atomic<bool>& bFound,
+    const std::string& prefix)
 {
     Wallet prefixed_wallet = {};
     while (!GenerateWalletWithPrefix(prefixed_wallet, prefix))
     {
-        if (stopBruteForce)
+        if (token.IsCancelled() || bFound)
         {
-            return;
+            return std::nullopt;
         }
     }
 
-    // make other threads stop
-    stopBruteForce = true;
-
+    // make other workers stop
+    if (bFound.exchange(true))
     {
-        std::lock_guard<std::mutex> guard(resultMutex);
-        outResult = prefixed_wallet;
+        return std::nullopt;
     }
+    return prefixed_wallet;
 }
 
 // ------------------------------------------------------------------------------------------------
@@ -353,12 +390,7 @@ void WalletWindow::WalletGenerationTab()
     {
         if (ImGui::Button("Cancel"))
         {
-            m_stopBruteForce = true;
-            m_bWaitingForBruteForce = false;
-        }
-        else if (m_bruteForceFuture.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
-        {
-            wallet = m_bruteForceFuture.get();
+            m_bruteForceToken.Cancel();
             m_bWaitingForBruteForce = false;
         }
     }
@@ -381,45 +413,26 @@ void WalletWindow::WalletGenerationTab()
             else if (bRequirePrefix)
             {
                 m_bWaitingForBruteForce = true;
+                m_bruteForceToken = CancellationToken();
 
-                // note: probably something smarter is possible, too busy and dumb to think about it
-                // now
-                m_bruteForceFuture = std::async(std::launch::async, [&]() -> Wallet {
-                    auto maxThreads = std::thread::hardware_concurrency();
-                    if (maxThreads > 1)
-                    {
-                        // leave 1 for main program/os
-                        maxThreads--;
-                    }
-
-                    Wallet result;
-                    std::mutex resultMutex;
-
-                    // start threads for bruteforce
-                    std::vector<std::thread> threads;
-                    for (unsigned int thread_id = 0; thread_id < maxThreads; ++thread_id)
-                    {
-                        auto thread = std::thread(
-                            BruteForceWalletThread,
-                            std::ref(m_stopBruteForce),
-                            prefix,
-                            std::ref(result),
-                            std::ref(resultMutex));
-                        threads.push_back(std::move(thread));
-                    }
-
-                    // join threads
-                    for (auto& thread : threads)
-                    {
-                        thread.join();
-                    }
-
-                    // enforce reset stop brute force
-                    m_stopBruteForce = false;
-
-                    // return found result
-                    return result;
-                });
+                // A job per worker, the executor keeps a worker free for other work
+                auto bFound = std::make_shared<std::atomic<bool>>(false);
+                for (unsigned int i = 0; i < m_executor.GetThreadCount(); ++i)
+                {
+                    m_executor.Post(
+                        TaskPriority::Bulk,
+                        [bFound, prefix = std::string(prefix)](const CancellationToken& token) {
+                            return BruteForceWallet(token, *bFound, prefix);
+                        },
+                        [this](std::optional<Wallet> result) {
+                            if (result.has_value())
+                            {
+                                wallet = result.value();
+                                m_bWaitingForBruteForce = false;
+                            }
+                        },
+                        m_bruteForceToken);
+                }
             }
             else
             {
@@ -510,26 +523,14 @@ void WalletWindow::AccountBalanceTab()
 
     // async balance request
     static bool bWaitingForBalance = false;
-    static std::future<tl::expected<unsigned long long, ConnectionError>> balanceFuture;
     static std::string warningLabel{"Warning"};
     static std::string warningText{};
+    static bool bShowWarning = false;
 
-    if (bWaitingForBalance)
+    if (bShowWarning)
     {
-        if (balanceFuture.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
-        {
-            auto result = balanceFuture.get();
-            if (result.has_value())
-            {
-                accountBalance = result.value();
-            }
-            else
-            {
-                warningText = result.error().message;
-                ImGui::OpenPopup(warningLabel.c_str());
-            }
-            bWaitingForBalance = false;
-        }
+        ImGui::OpenPopup(warningLabel.c_str());
+        bShowWarning = false;
     }
 
     // Pop up for warnings
@@ -538,19 +539,31 @@ void WalletWindow::AccountBalanceTab()
     if (ImGui::Button("Get balance") && !bWaitingForBalance)
     {
         bWaitingForBalance = true;
-        balanceFuture = std::async(
-            std::launch::async,
-            [&]() -> tl::expected<unsigned long long, ConnectionError> {
-                // Create connection
-                auto result = CreateConnection(ipAddress, atoi(port));
+        AddNode(ipAddress, port);
+        m_executor.Post(
+            TaskPriority::Interactive,
+            [this, identity = std::string(identity)](
+                const CancellationToken& token)
+                -> tl::expected<unsigned long long, ConnectionError> {
+                return GetBalance(
+                    m_coalescer,
+                    m_nodeRegistry,
+                    identity,
+                    Deadline::After(requestTimeout, token));
+            },
+            [](tl::expected<unsigned long long, ConnectionError> result) {
                 if (result.has_value())
                 {
-                    auto connection = result.value();
-                    return GetBalance(connection, identity);
+                    accountBalance = result.value();
                 }
-
-                return tl::make_unexpected(result.error());
-            });
+                else
+                {
+                    warningText = result.error().message;
+                    bShowWarning = true;
+                }
+                bWaitingForBalance = false;
+            },
+            m_cancellation);
     }
 }
 
@@ -583,11 +596,34 @@ void WalletWindow::TransactionTab()
         ImGuiInputTextFlags_CharsDecimal);
 
     // tick offset
-    static int offset = 10;
-    ImGui::SliderInt("Tick offset", &offset, 3, 100, "%d", ImGuiSliderFlags_AlwaysClamp);
+    static bool bAutomaticOffset = true;
+    static int offset = TickOffsetEstimator::defaultOffset;
+    ImGui::Checkbox("Automatic tick offset", &bAutomaticOffset);
 
     ImGui::SameLine();
-    HelpMarker("Number of ticks in the future at which the transaction must be executed");
+    HelpMarker("Pick the smallest tick offset that is likely to be included, based on recent tick "
+               "durations, latency and transaction outcomes");
+
+    if (!bAutomaticOffset)
+    {
+        ImGui::SliderInt(
+            "Tick offset",
+            &offset,
+            TickOffsetEstimator::minimumOffset,
+            TickOffsetEstimator::maximumOffset,
+            "%d",
+            ImGuiSliderFlags_AlwaysClamp);
+
+        ImGui::SameLine();
+        HelpMarker("Number of ticks in the future at which the transaction must be executed");
+    }
+
+    // retry
+    ImGui::Checkbox("Retry failed transactions", &m_bRetryFailedTransactions);
+
+    ImGui::SameLine();
+    HelpMarker("Sign and broadcast transactions that were not included again at a new tick, at "
+               "most two times");
 
     // ip-address
     static auto textColor = IM_COL32(255, 0, 0, 255);
@@ -625,65 +661,23 @@ void WalletWindow::TransactionTab()
     static std::string warningLabel{"Warning"};
     static std::string warningText;
 
-    // - - - - - - - - - - -
-    // Async balance request
-    static std::future<tl::expected<bool, TransactionError>> verifyTransactionFuture;
-    static bool bWaitingForTransactionVerification = false;
+    static bool bShowWarning = false;
 
-    // Get verification result from separate thread - possibly move to Update() later
-    if (bWaitingForTransactionVerification)
+    if (bShowWarning)
     {
-        if (verifyTransactionFuture.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
-        {
-            auto result = verifyTransactionFuture.get();
-            if (result.has_value())
-            {
-                ImGui::OpenPopup("Confirm transaction");
-            }
-            else
-            {
-                warningText = result.error().message;
-                ImGui::OpenPopup(warningLabel.c_str());
-            }
-            bWaitingForTransactionVerification = false;
-        }
+        ImGui::OpenPopup(warningLabel.c_str());
+        bShowWarning = false;
     }
 
-    // - - - - - - - - - - - -
-    // Async broadcast request
-    static std::future<tl::expected<Receipt, TransactionError>> broadcastTransactionFuture;
-    static bool bWaitingForTransactionBroadcast = false;
+    // - - - - - - - - - - - - - - - - - -
+    // Async transaction verification request
+    static bool bWaitingForTransactionVerification = false;
+    static bool bShowConfirmation = false;
 
-    if (bWaitingForTransactionBroadcast)
+    if (bShowConfirmation)
     {
-        if (broadcastTransactionFuture.wait_for(std::chrono::seconds(0)) ==
-            std::future_status::ready)
-        {
-            auto result = broadcastTransactionFuture.get();
-            if (result.has_value())
-            {
-                std::cout << "Successfully broadcasted transaction" << std::endl;
-
-                // todo: temporarily print receipt for testing
-                auto receipt = result.value();
-                std::cout << "[Receipt]" << std::endl;
-                std::cout << "\tSender: " << receipt.sender << std::endl;
-                std::cout << "\tRecipient: " << receipt.recipient << std::endl;
-                std::cout << "\tHash: " << receipt.hash << std::endl;
-                std::cout << "\tAmount: " << receipt.amount << std::endl;
-                std::cout << "\tTick: " << receipt.tick << std::endl;
-                std::cout << "\tStatus: " << StatusToString(receipt.status) << std::endl;
-
-                m_confirmingTransactions.push_back(receipt);
-            }
-            else
-            {
-                // Some error occurred, show it in a popup
-                warningText = result.error().message;
-                ImGui::OpenPopup(warningLabel.c_str());
-            }
-            bWaitingForTransactionBroadcast = false;
-        }
+        ImGui::OpenPopup("Confirm transaction");
+        bShowConfirmation = false;
     }
 
     // Send button
@@ -701,10 +695,29 @@ void WalletWindow::TransactionTab()
         // Start new transaction
         if (ImGui::Button("Send"))
         {
-            verifyTransactionFuture =
-                std::async(std::launch::async, [&]() -> tl::expected<bool, TransactionError> {
-                    return VerifyTransactionInput(seed, recipientIdentity, ipAddress, port, amount);
-                });
+            m_executor.Post(
+                TaskPriority::Interactive,
+                [this,
+                 seed = std::string(seed),
+                 recipient = std::string(recipientIdentity),
+                 ipAddress = std::string(ipAddress),
+                 port = std::string(port),
+                 amount = amount](const CancellationToken&) {
+                    return VerifyTransactionInput(seed, recipient, ipAddress, port, amount);
+                },
+                [](tl::expected<bool, TransactionError> result) {
+                    if (result.has_value())
+                    {
+                        bShowConfirmation = true;
+                    }
+                    else
+                    {
+                        warningText = result.error().message;
+                        bShowWarning = true;
+                    }
+                    bWaitingForTransactionVerification = false;
+                },
+                m_cancellation);
             bWaitingForTransactionVerification = true;
         }
     }
@@ -728,27 +741,83 @@ void WalletWindow::TransactionTab()
 
         if (ImGui::Button("Send", ImVec2(120, 0)))
         {
-            broadcastTransactionFuture =
-                std::async(std::launch::async, [&]() -> tl::expected<Receipt, TransactionError> {
-                    auto connection = CreateConnection(ipAddress, atoi(port));
+            const auto tickOffset =
+                bAutomaticOffset ? m_tickOffsetEstimator.GetTickOffset() : (unsigned int)offset;
+            m_executor.Post(
+                TaskPriority::Interactive,
+                [this,
+                 signingKey = m_signingKey,
+                 tickOffset,
+                 recipient = std::string(recipientIdentity),
+                 amount = amount](
+                    const CancellationToken& token) -> tl::expected<Receipt, TransactionError> {
+                    const auto deadline = Deadline::After(requestTimeout, token);
+                    auto connection = CreateConnection(m_nodeRegistry, deadline);
                     if (!connection.has_value())
                     {
                         return tl::make_unexpected(TransactionError{connection.error().message});
                     }
 
-                    auto wallet = GenerateWallet(seed);
-                    if (!wallet.has_value())
+                    // Time from reading the tick until the transaction is sent, the tracker
+                    // saves the round trip of querying it
+                    const auto start = std::chrono::steady_clock::now();
+                    auto tick = m_tickTracker.GetTick();
+                    if (!tick.has_value())
+                    {
+                        // Shared with the other transfers that wait for the first sample
+                        tick = GetTick(m_coalescer, m_nodeRegistry, deadline);
+                    }
+                    if (!tick.has_value())
                     {
-                        return tl::make_unexpected(TransactionError{wallet.error().message});
+                        return tl::make_unexpected(TransactionError{tick.error().message});
                     }
-                    return BroadcastTransaction(
+
+                    auto receipt = BroadcastTransactionAtTick(
                         connection.value(),
-                        wallet.value(),
-                        recipientIdentity,
+                        *signingKey,
+                        recipient,
                         amount,
-                        offset);
-                });
-            bWaitingForTransactionBroadcast = true;
+                        tick.value() + tickOffset);
+                    if (receipt.has_value())
+                    {
+                        m_tickOffsetEstimator.AddLatency(
+                            std::chrono::duration<double, std::milli>(
+                                std::chrono::steady_clock::now() - start)
+                                .count());
+                    }
+
+                    return receipt;
+                },
+                [this, signingKey = m_signingKey, tickOffset](
+                    tl::expected<Receipt, TransactionError> result) {
+                    if (result.has_value())
+                    {
+                        std::cout << "Successfully broadcasted transaction" << std::endl;
+
+                        // todo: temporarily print receipt for testing
+                        auto receipt = result.value();
+                        std::cout << "[Receipt]" << std::endl;
+                        std::cout << "\tSender: " << receipt.sender << std::endl;
+                        std::cout << "\tRecipient: " << receipt.recipient << std::endl;
+                        std::cout << "\tHash: " << receipt.hash << std::endl;
+                        std::cout << "\tAmount: " << receipt.amount << std::endl;
+                        std::cout << "\tTick: " << receipt.tick << std::endl;
+                        std::cout << "\tStatus: " << StatusToString(receipt.status) << std::endl;
+
+                        m_confirmingTransactions.push_back(receipt);
+                        m_tickOffsets[receipt.hash] = tickOffset;
+
+                        // The first attempt's hash identifies the transfer across retries
+                        m_transferRetrier.Track(receipt.hash, signingKey, receipt);
+                    }
+                    else
+                    {
+                        // Some error occurred, show it in a popup
+                        warningText = result.error().message;
+                        bShowWarning = true;
+                    }
+                },
+                m_cancellation);
 
             ImGui::CloseCurrentPopup();
         }
@@ -848,6 +917,15 @@ void WalletWindow::CreateReceiptTableRows(const std::vector<Receipt>& receipts)
     }
 }
 
+// ------------------------------------------------------------------------------------------------
+void WalletWindow::AddNode(const std::string& ipAddress, const std::string& port)
+{
+    if (IsValidIp(ipAddress))
+    {
+        m_nodeRegistry.AddNode({ipAddress, (unsigned short)atoi(port.c_str())});
+    }
+}
+
 // ------------------------------------------------------------------------------------------------
 bool WalletWindow::Begin(ImGuiWindowFlags flags) { return Window::Begin(flags); }
 
@@ -862,15 +940,7 @@ tl::expected<bool, TransactionError> WalletWindow::VerifyTransactionInput(
     const std::string& port,
     unsigned long long amount)
 {
-    ConnectionPtr connection;
-    {
-        auto result = CreateConnection(ipAddress, atoi(port.c_str()));
-        if (!result.has_value())
-        {
-            return tl::make_unexpected(TransactionError{result.error().message});
-        }
-        connection = result.value();
-    }
+    AddNode(ipAddress, port);
 
     if (seed.size() != 55)
     {
@@ -882,14 +952,15 @@ tl::expected<bool, TransactionError> WalletWindow::VerifyTransactionInput(
         return tl::make_unexpected(TransactionError{"Recipient is incomplete"});
     }
 
-    Wallet wallet;
+    if (!m_signingKey || m_signingKeySeed != seed)
     {
-        auto result = GenerateWallet(seed);
+        auto result = CreateSigningKey(seed);
         if (!result.has_value())
         {
             return tl::make_unexpected(TransactionError{result.error().message});
         }
-        wallet = result.value();
+        m_signingKey = result.value();
+        m_signingKeySeed = seed;
     }
 
     // kinda slow to do it here, but at least it's proper :]
@@ -897,7 +968,11 @@ tl::expected<bool, TransactionError> WalletWindow::VerifyTransactionInput(
     // or put this function in a future and open some popup with loading icon idk.
     unsigned long long balance = 0;
     {
-        auto result = GetBalance(connection, wallet.identity);
+        auto result = GetBalance(
+            m_coalescer,
+            m_nodeRegistry,
+            m_signingKey->GetIdentity(),
+            Deadline::After(requestTimeout));
         if (!result.has_value())
         {
             return tl::make_unexpected(TransactionError{result.error().message});
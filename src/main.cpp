@@ -1,5 +1,7 @@
+#include <cstdlib>
 #include <iostream>
 
+#include "crypto/fixed_base_table.hpp"
 #include "gui/qwallet.hpp"
 #include "network/connection.hpp"
 
@@ -39,6 +41,24 @@ int main()
         return 1;
     }
 
+    // Opt-in larger fixed-base table for key generation, e.g. QWALLET_FIXED_BASE_WINDOW=12 and
+    // optionally QWALLET_FIXED_BASE_CACHE=<path> to reuse the table between runs
+    if (const char* windowWidth = std::getenv("QWALLET_FIXED_BASE_WINDOW"))
+    {
+        const char* cachePath = std::getenv("QWALLET_FIXED_BASE_CACHE");
+        auto table = cachePath ? LoadOrCreateFixedBaseTable(cachePath, std::atoi(windowWidth))
+                               : CreateFixedBaseTable(std::atoi(windowWidth));
+        if (table)
+        {
+            SelectFixedBaseTable(*table);
+        }
+        else
+        {
+            std::cerr << "Failed to create the fixed-base table: " << table.error().message
+                      << std::endl;
+        }
+    }
+
     // Create and initialize node
     QWallet qwallet{"QWallet"};
     if (!qwallet.Initialize(window))
@@ -0,0 +1,383 @@
+#include "network/async_engine.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "network/async_backend.hpp"
+
+// ------------------------------------------------------------------------------------------------
+AsyncBackend::AsyncBackend(AsyncEngine& engine)
+    : m_engine(engine)
+{}
+
+// ------------------------------------------------------------------------------------------------
+std::unique_ptr<AsyncOperation> AsyncBackend::CreateOperation() const
+{
+    return std::make_unique<AsyncOperation>();
+}
+
+// ------------------------------------------------------------------------------------------------
+void AsyncBackend::Stop(AsyncOperation&) {}
+
+// ------------------------------------------------------------------------------------------------
+void AsyncBackend::Release(std::unique_ptr<AsyncOperation>) {}
+
+// ------------------------------------------------------------------------------------------------
+void AsyncBackend::Drain() {}
+
+// ------------------------------------------------------------------------------------------------
+AsyncOperation* AsyncBackend::FindOperation(unsigned long long id) const
+{
+    const auto it = m_engine.m_operations.find(id);
+    return it != m_engine.m_operations.end() ? it->second.get() : nullptr;
+}
+
+// ------------------------------------------------------------------------------------------------
+void AsyncBackend::Complete(
+    AsyncOperation& operation,
+    tl::expected<const char*, ConnectionError> result)
+{
+    m_engine.Complete(operation.id, std::move(result));
+}
+
+// ------------------------------------------------------------------------------------------------
+void AsyncBackend::Fail(AsyncOperation& operation, std::string message)
+{
+    Complete(operation, tl::make_unexpected(ConnectionError{std::move(message)}));
+}
+
+// ------------------------------------------------------------------------------------------------
+bool AsyncBackend::ParseResponse(AsyncOperation& operation)
+{
+    const auto search =
+        FindFrame(operation.received.data(), operation.receivedSize, operation.responseType);
+    if (search.status == FrameSearch::Found)
+    {
+        Complete(operation, operation.received.data() + search.offset);
+        return true;
+    }
+    if (search.status == FrameSearch::Invalid)
+    {
+        Fail(
+            operation,
+            "Response contained a frame with invalid size: " + std::to_string(search.size));
+        return true;
+    }
+
+    // Frames of other types are skipped, keep only a partial frame
+    if (search.offset > 0)
+    {
+        char* data = operation.received.data();
+        memmove(data, data + search.offset, operation.receivedSize - search.offset);
+        operation.receivedSize -= search.offset;
+    }
+    if (operation.received.size() < search.size)
+    {
+        operation.received.resize(search.size);
+    }
+    return false;
+}
+
+// ------------------------------------------------------------------------------------------------
+AsyncEngine::AsyncEngine(AsyncEngineBackend preferredBackend)
+{
+    // The backend lives on the engine thread, the kernel interrupts blocking calls of every thread
+    // that set up an io_uring instance once the instance is torn down
+    std::promise<void> started;
+    m_thread = std::thread([this, preferredBackend, &started]() {
+        m_backendType = preferredBackend;
+        if (m_backendType == AsyncEngineBackend::IoUring)
+        {
+            m_backend = CreateIoUringBackend(*this);
+            if (!m_backend)
+            {
+                m_backendType = AsyncEngineBackend::Epoll;
+            }
+        }
+        if (m_backendType == AsyncEngineBackend::Epoll)
+        {
+            m_backend = CreateEpollBackend(*this);
+            if (!m_backend)
+            {
+                m_backendType = AsyncEngineBackend::Threads;
+            }
+        }
+        if (m_backendType == AsyncEngineBackend::Threads)
+        {
+            m_backend = CreateThreadBackend(*this);
+        }
+        started.set_value();
+
+        Run();
+    });
+    started.get_future().wait();
+}
+
+// ------------------------------------------------------------------------------------------------
+AsyncEngine::~AsyncEngine()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_bStop = true;
+        m_backend->Wake();
+    }
+    m_thread.join();
+}
+
+// ------------------------------------------------------------------------------------------------
+void AsyncEngine::Request(
+    const NodeAddress& node,
+    std::vector<char> request,
+    unsigned char responseType,
+    bool bExpectResponse,
+    std::chrono::milliseconds timeout,
+    RequestCallback callback,
+    CancellationToken token)
+{
+    auto operation = m_backend->CreateOperation();
+    operation->node = node;
+    operation->request = std::move(request);
+    operation->bExpectResponse = bExpectResponse;
+    operation->responseType = responseType;
+    operation->deadline = Clock::now() + timeout;
+    operation->token = std::move(token);
+    operation->callback = std::move(callback);
+    Submit(std::move(operation));
+}
+
+// ------------------------------------------------------------------------------------------------
+void AsyncEngine::Connect(
+    const NodeAddress& node,
+    std::chrono::milliseconds timeout,
+    AsyncCallback<ConnectionPtr> callback,
+    CancellationToken token)
+{
+    auto operation = m_backend->CreateOperation();
+    operation->node = node;
+    operation->bExpectResponse = false;
+    operation->bConnectOnly = true;
+    operation->deadline = Clock::now() + timeout;
+    operation->token = std::move(token);
+
+    // The request is only released after its callback returns
+    operation->callback = [current = operation.get(), callback = std::move(callback)](
+                              tl::expected<const char*, ConnectionError> result) {
+        if (!result.has_value())
+        {
+            callback(tl::make_unexpected(result.error()));
+            return;
+        }
+        callback(std::move(current->connection));
+    };
+    Submit(std::move(operation));
+}
+
+// ------------------------------------------------------------------------------------------------
+void AsyncEngine::RunAfter(
+    std::chrono::milliseconds delay,
+    std::function<void()> callback,
+    CancellationToken token)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_timers.emplace(Clock::now() + delay, Timer{std::move(callback), std::move(token)});
+    }
+    m_backend->Wake();
+}
+
+// ------------------------------------------------------------------------------------------------
+size_t AsyncEngine::GetPendingCount() const { return m_pendingCount; }
+
+// ------------------------------------------------------------------------------------------------
+AsyncEngineBackend AsyncEngine::GetBackend() const { return m_backendType; }
+
+// ------------------------------------------------------------------------------------------------
+void AsyncEngine::Run()
+{
+    while (true)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_bStop)
+            {
+                break;
+            }
+        }
+        StartSubmitted();
+
+        // Sleep until an event, the nearest deadline or the nearest timer, waking up now and then
+        // to notice cancelled requests
+        auto wakeUp = Clock::time_point::max();
+        if (!m_deadlines.empty())
+        {
+            wakeUp = std::min(m_deadlines.begin()->first, Clock::now() + cancellationInterval);
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_timers.empty())
+            {
+                wakeUp = std::min(wakeUp, m_timers.begin()->first);
+            }
+        }
+        auto timeout = std::chrono::milliseconds(-1);
+        if (wakeUp != Clock::time_point::max())
+        {
+            timeout = std::max(
+                std::chrono::ceil<std::chrono::milliseconds>(wakeUp - Clock::now()),
+                std::chrono::milliseconds(0));
+        }
+        m_backend->Poll(timeout);
+
+        FailExpired();
+        RunTimers();
+    }
+
+    // Fail everything that is left, including requests made by the callbacks
+    while (true)
+    {
+        StartSubmitted();
+        if (m_operations.empty())
+        {
+            break;
+        }
+        Complete(
+            m_operations.begin()->first,
+            tl::make_unexpected(ConnectionError{"Network engine stopped"}));
+    }
+    m_backend->Drain();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_backend.reset();
+}
+
+// ------------------------------------------------------------------------------------------------
+void AsyncEngine::Submit(std::unique_ptr<AsyncOperation> operation)
+{
+    ++m_pendingCount;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_submitted.push_back(std::move(operation));
+    }
+    m_backend->Wake();
+}
+
+// ------------------------------------------------------------------------------------------------
+void AsyncEngine::StartSubmitted()
+{
+    std::vector<std::unique_ptr<AsyncOperation>> submitted;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        submitted.swap(m_submitted);
+    }
+
+    for (auto& operation : submitted)
+    {
+        const auto id = m_nextId++;
+        operation->id = id;
+        m_deadlines.emplace(operation->deadline, id);
+        auto& current = *(m_operations[id] = std::move(operation));
+        m_backend->Start(current);
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+void AsyncEngine::FailExpired()
+{
+    const auto now = Clock::now();
+    while (!m_deadlines.empty() && m_deadlines.begin()->first <= now)
+    {
+        const auto id = m_deadlines.begin()->second;
+        const auto& node = m_operations.at(id)->node;
+        Complete(id, tl::make_unexpected(ConnectionError{"Request timed out: " + node.ipAddress}));
+    }
+
+    // A pass over every request, so only once per interval however often events arrive
+    if (now - m_lastCancellationCheck < cancellationInterval)
+    {
+        return;
+    }
+    m_lastCancellationCheck = now;
+
+    std::vector<unsigned long long> cancelled;
+    for (const auto& [id, operation] : m_operations)
+    {
+        if (operation->token.IsCancelled())
+        {
+            cancelled.push_back(id);
+        }
+    }
+    for (const auto id : cancelled)
+    {
+        // A callback may have completed it meanwhile
+        const auto it = m_operations.find(id);
+        if (it != m_operations.end())
+        {
+            const auto& node = it->second->node;
+            Complete(
+                id,
+                tl::make_unexpected(ConnectionError{"Request cancelled: " + node.ipAddress}));
+        }
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+void AsyncEngine::RunTimers()
+{
+    const auto now = Clock::now();
+    std::vector<Timer> due;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        while (!m_timers.empty() && m_timers.begin()->first <= now)
+        {
+            due.push_back(std::move(m_timers.begin()->second));
+            m_timers.erase(m_timers.begin());
+        }
+    }
+
+    // Unlocked, the functions may start requests or timers
+    for (auto& timer : due)
+    {
+        if (!timer.token.IsCancelled())
+        {
+            timer.callback();
+        }
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+void AsyncEngine::Complete(
+    unsigned long long id,
+    tl::expected<const char*, ConnectionError> result)
+{
+    const auto it = m_operations.find(id);
+    auto operation = std::move(it->second);
+    m_operations.erase(it);
+
+    auto range = m_deadlines.equal_range(operation->deadline);
+    for (auto deadline = range.first; deadline != range.second; ++deadline)
+    {
+        if (deadline->second == id)
+        {
+            m_deadlines.erase(deadline);
+            break;
+        }
+    }
+
+    m_backend->Stop(*operation);
+    --m_pendingCount;
+    operation->callback(std::move(result));
+    m_backend->Release(std::move(operation));
+}
+
+// ------------------------------------------------------------------------------------------------
+Task<tl::expected<ConnectionPtr, ConnectionError>> CreateConnectionTask(
+    AsyncEngine& engine,
+    NodeAddress node,
+    std::chrono::milliseconds timeout,
+    CancellationToken token)
+{
+    co_return co_await CallbackAwaitable<tl::expected<ConnectionPtr, ConnectionError>>(
+        [&engine, &node, timeout, &token](AsyncCallback<ConnectionPtr> callback) {
+            engine.Connect(node, timeout, std::move(callback), token);
+        });
+}
@@ -0,0 +1,50 @@
+#include "network/broadcast.hpp"
+
+#include <thread>
+
+// ------------------------------------------------------------------------------------------------
+std::vector<NodeBroadcastResult> BroadcastToNodes(
+    const std::vector<NodeAddress>& nodes,
+    const char* data,
+    size_t size,
+    std::chrono::milliseconds timeout)
+{
+    std::vector<NodeBroadcastResult> results(nodes.size());
+    std::vector<std::thread> threads;
+    threads.reserve(nodes.size());
+
+    for (size_t i = 0; i < nodes.size(); ++i)
+    {
+        threads.emplace_back([&, i]() {
+            const auto start = std::chrono::steady_clock::now();
+            auto& result = results[i];
+            result.node = nodes[i];
+            result.bAccepted = false;
+
+            auto connection = CreateConnection(nodes[i].ipAddress, nodes[i].port, timeout);
+            if (!connection.has_value())
+            {
+                result.error = connection.error().message;
+            }
+            else if (!connection.value()->SetTimeout(timeout) ||
+                     !connection.value()->Send((char*)data, (int)size))
+            {
+                result.error = "Failed to send data to: " + nodes[i].ipAddress;
+            }
+            else
+            {
+                result.bAccepted = true;
+            }
+
+            result.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start);
+        });
+    }
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    return results;
+}
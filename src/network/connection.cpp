@@ -1,5 +1,7 @@
 #include "network/connection.hpp"
 
+#include <algorithm>
+
 #ifdef _MSC_VER
 
 #pragma comment(lib, "Ws2_32.lib")
@@ -11,13 +13,36 @@
 #else
 
 #include <arpa/inet.h>
+#include <cerrno>
 #include <cstring>
+#include <fcntl.h>
 #include <netinet/in.h>
+#include <poll.h>
 #include <sys/time.h>
 #include <unistd.h>
 
 #endif
 
+// ------------------------------------------------------------------------------------------------
+Deadline Deadline::After(std::chrono::milliseconds timeout, CancellationToken token)
+{
+    return Deadline{Clock::now() + timeout, std::move(token)};
+}
+
+// ------------------------------------------------------------------------------------------------
+tl::expected<void, ConnectionError> Deadline::Check() const
+{
+    if (token.IsCancelled())
+    {
+        return tl::make_unexpected(ConnectionError{"Request was cancelled"});
+    }
+    if (time != Clock::time_point::max() && Clock::now() >= time)
+    {
+        return tl::make_unexpected(ConnectionError{"Request deadline expired"});
+    }
+    return {};
+}
+
 // ------------------------------------------------------------------------------------------------
 Connection::Connection(long socket) noexcept
     : m_socket(socket)
@@ -27,7 +52,15 @@ Connection::Connection(long socket) noexcept
 Connection::Connection(Connection&& other) noexcept
     : Connection(other.m_socket)
 {
+    m_timeout = other.m_timeout;
+    m_deadline = std::move(other.m_deadline);
+    m_receiveBuffer = std::move(other.m_receiveBuffer);
+    m_receivedSize = other.m_receivedSize;
+    m_consumedSize = other.m_consumedSize;
+    m_alignedPayload = std::move(other.m_alignedPayload);
     other.m_socket = -1;
+    other.m_receivedSize = 0;
+    other.m_consumedSize = 0;
 }
 
 // ------------------------------------------------------------------------------------------------
@@ -36,7 +69,15 @@ Connection& Connection::operator=(Connection&& other) noexcept
     if (this != &other)
     {
         m_socket = other.m_socket;
+        m_timeout = other.m_timeout;
+        m_deadline = std::move(other.m_deadline);
+        m_receiveBuffer = std::move(other.m_receiveBuffer);
+        m_receivedSize = other.m_receivedSize;
+        m_consumedSize = other.m_consumedSize;
+        m_alignedPayload = std::move(other.m_alignedPayload);
         other.m_socket = -1;
+        other.m_receivedSize = 0;
+        other.m_consumedSize = 0;
     }
     return *this;
 }
@@ -52,6 +93,12 @@ bool Connection::Send(char* buffer, int bufferLength) const
 
     while (totalSent < bufferLength)
     {
+        auto ready = Wait(true, Deadline::Clock::now() + m_timeout);
+        if (!ready.has_value() || !ready.value())
+        {
+            return false;
+        }
+
         int result = send(m_socket, buffer + totalSent, bytesLeft, 0);
         if (result == -1)
         {
@@ -64,25 +111,209 @@ bool Connection::Send(char* buffer, int bufferLength) const
     return true;
 }
 
+// ------------------------------------------------------------------------------------------------
+bool Connection::SetTimeout(std::chrono::milliseconds timeout) const
+{
+    m_timeout = timeout;
+
+#ifdef _MSC_VER
+    DWORD tv = (DWORD)timeout.count();
+#else
+    timeval tv;
+    tv.tv_sec = (long)(timeout.count() / 1000);
+    tv.tv_usec = (long)(timeout.count() % 1000) * 1000;
+#endif
+
+    return setsockopt(m_socket, SOL_SOCKET, SO_RCVTIMEO, (const char*)&tv, sizeof(tv)) == 0 &&
+           setsockopt(m_socket, SOL_SOCKET, SO_SNDTIMEO, (const char*)&tv, sizeof(tv)) == 0;
+}
+
+// ------------------------------------------------------------------------------------------------
+void Connection::SetDeadline(Deadline deadline) const { m_deadline = std::move(deadline); }
+
+// ------------------------------------------------------------------------------------------------
+const Deadline& Connection::GetDeadline() const { return m_deadline; }
+
 // ------------------------------------------------------------------------------------------------
 std::vector<char> Connection::Receive() const
 {
-    std::vector<char> buffer;
-    buffer.resize(0);
+    // Data left behind by `ReceiveFrame` comes first
+    std::vector<char> buffer(
+        (const char*)m_receiveBuffer.data() + m_consumedSize,
+        (const char*)m_receiveBuffer.data() + m_receivedSize);
+    m_receivedSize = 0;
+    m_consumedSize = 0;
 
     char temporary[1024];
-    int bytes_received = recv(m_socket, temporary, sizeof(temporary), 0);
-
-    while (bytes_received > 0)
+    while (true)
     {
-        buffer.resize(buffer.size() + bytes_received);
-        memcpy(buffer.data() + buffer.size() - bytes_received, temporary, bytes_received);
-        bytes_received = recv(m_socket, temporary, sizeof(temporary), 0);
+        auto ready = Wait(false, Deadline::Clock::now() + m_timeout);
+        if (!ready.has_value() || !ready.value())
+        {
+            break;
+        }
+
+        const int bytes_received = recv(m_socket, temporary, sizeof(temporary), 0);
+        if (bytes_received <= 0)
+        {
+            break;
+        }
+        buffer.insert(buffer.end(), temporary, temporary + bytes_received);
     }
 
     return buffer;
 }
 
+// ------------------------------------------------------------------------------------------------
+tl::expected<const char*, ConnectionError> Connection::ReceiveFrame(unsigned char headerType) const
+{
+    // Move data after the previously returned frame to the start, so frames start aligned
+    if (m_consumedSize > 0)
+    {
+        char* data = (char*)m_receiveBuffer.data();
+        memmove(data, data + m_consumedSize, m_receivedSize - m_consumedSize);
+        m_receivedSize -= m_consumedSize;
+        m_consumedSize = 0;
+    }
+
+    while (true)
+    {
+        const auto search =
+            FindFrame((const char*)m_receiveBuffer.data(), m_receivedSize, headerType);
+        if (search.status == FrameSearch::Found)
+        {
+            m_consumedSize = search.offset + search.size;
+            return (const char*)m_receiveBuffer.data() + search.offset;
+        }
+        if (search.status == FrameSearch::Invalid)
+        {
+            // Can't skip past it, drop everything
+            m_receivedSize = 0;
+            return tl::make_unexpected(ConnectionError{
+                "Response contained a frame with invalid size: " + std::to_string(search.size)});
+        }
+
+        // Frames of other types are skipped, keep only a partial frame
+        if (search.offset > 0)
+        {
+            char* data = (char*)m_receiveBuffer.data();
+            memmove(data, data + search.offset, m_receivedSize - search.offset);
+            m_receivedSize -= search.offset;
+        }
+
+        // Grow once to fit the next frame, with room to read ahead
+        const size_t capacity = m_receiveBuffer.size() * sizeof(ReceiveBlock);
+        const size_t wantedSize = std::max(search.size, m_receivedSize + 1024);
+        if (wantedSize > capacity)
+        {
+            const size_t size = std::max(wantedSize, 2 * capacity);
+            m_receiveBuffer.resize((size + sizeof(ReceiveBlock) - 1) / sizeof(ReceiveBlock));
+        }
+
+        auto ready = Wait(false, Deadline::Clock::now() + m_timeout);
+        if (!ready.has_value())
+        {
+            return tl::make_unexpected(ready.error());
+        }
+
+        const int bytesReceived =
+            ready.value() ? recv(
+                                m_socket,
+                                (char*)m_receiveBuffer.data() + m_receivedSize,
+                                (int)(m_receiveBuffer.size() * sizeof(ReceiveBlock) -
+                                      m_receivedSize),
+                                0)
+                          : 0;
+        if (bytesReceived <= 0)
+        {
+            if (m_receivedSize == 0)
+            {
+                return tl::make_unexpected(
+                    ConnectionError{"Connection failed to get a response"});
+            }
+            return tl::make_unexpected(ConnectionError{
+                "Response did not contain header type: " + std::to_string((int)headerType)});
+        }
+        m_receivedSize += bytesReceived;
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+const char* Connection::AlignPayload(const char* payload, size_t size) const
+{
+    m_alignedPayload.resize((size + sizeof(ReceiveBlock) - 1) / sizeof(ReceiveBlock));
+    memcpy(m_alignedPayload.data(), payload, size);
+    return (const char*)m_alignedPayload.data();
+}
+
+// ------------------------------------------------------------------------------------------------
+tl::expected<bool, ConnectionError> Connection::Wait(
+    bool bWrite,
+    Deadline::Clock::time_point until) const
+{
+    until = std::min(until, m_deadline.time);
+    while (true)
+    {
+        auto stop = m_deadline.Check();
+        if (!stop.has_value())
+        {
+            return tl::make_unexpected(stop.error());
+        }
+
+        const auto now = Deadline::Clock::now();
+        if (now >= until)
+        {
+            return false;
+        }
+
+        // Wake up now and then to notice cancellation
+        const auto wait = std::min(
+            std::chrono::ceil<std::chrono::milliseconds>(until - now),
+            cancellationInterval);
+#ifdef _MSC_VER
+        WSAPOLLFD descriptor{(SOCKET)m_socket, (SHORT)(bWrite ? POLLWRNORM : POLLRDNORM), 0};
+        const int result = WSAPoll(&descriptor, 1, (int)wait.count());
+#else
+        pollfd descriptor{(int)m_socket, (short)(bWrite ? POLLOUT : POLLIN), 0};
+        const int result = poll(&descriptor, 1, (int)wait.count());
+#endif
+
+        // Errors are reported by the send or receive that follows
+        if (result != 0)
+        {
+            return true;
+        }
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+FrameSearch FindFrame(const char* data, size_t size, unsigned char headerType)
+{
+    size_t offset = 0;
+    while (size - offset >= sizeof(RequestResponseHeader))
+    {
+        RequestResponseHeader header;
+        memcpy(&header, data + offset, sizeof(header));
+
+        const size_t frameSize = header.size();
+        if (frameSize < sizeof(RequestResponseHeader))
+        {
+            return FrameSearch{FrameSearch::Invalid, offset, frameSize};
+        }
+        if (size - offset < frameSize)
+        {
+            return FrameSearch{FrameSearch::Incomplete, offset, frameSize};
+        }
+        if (header.type() == headerType)
+        {
+            return FrameSearch{FrameSearch::Found, offset, frameSize};
+        }
+        offset += frameSize;
+    }
+
+    return FrameSearch{FrameSearch::Incomplete, offset, sizeof(RequestResponseHeader)};
+}
+
 // ------------------------------------------------------------------------------------------------
 bool InitializeConnection()
 {
@@ -109,18 +340,35 @@ tl::expected<ConnectionPtr, ConnectionError> CreateConnection(
     const std::string& ipAddress,
     unsigned short port)
 {
-    int clientSocket = socket(AF_INET, SOCK_STREAM, 0);
+    return CreateConnection(ipAddress, port, defaultConnectTimeout);
+}
 
-#ifdef _MSC_VER
-    size_t tv = 1000;
-#else
-    timeval tv;
-    tv.tv_sec = 1;
-    tv.tv_usec = 0;
-#endif
+// ------------------------------------------------------------------------------------------------
+tl::expected<ConnectionPtr, ConnectionError> CreateConnection(
+    const std::string& ipAddress,
+    unsigned short port,
+    std::chrono::milliseconds timeout)
+{
+    auto connection = CreateConnection(ipAddress, port, Deadline::After(timeout));
+    if (connection.has_value())
+    {
+        // Only connecting is limited
+        connection.value()->SetDeadline({});
+    }
+    return connection;
+}
 
-    setsockopt(clientSocket, SOL_SOCKET, SO_RCVTIMEO, (const char*)&tv, sizeof(tv));
-    setsockopt(clientSocket, SOL_SOCKET, SO_SNDTIMEO, (const char*)&tv, sizeof(tv));
+// ------------------------------------------------------------------------------------------------
+tl::expected<ConnectionPtr, ConnectionError> CreateConnection(
+    const std::string& ipAddress,
+    unsigned short port,
+    const Deadline& deadline)
+{
+    auto stop = deadline.Check();
+    if (!stop.has_value())
+    {
+        return tl::make_unexpected(stop.error());
+    }
 
     sockaddr_in serverAddress;
     memset((char*)&serverAddress, 0, sizeof(serverAddress));
@@ -132,12 +380,76 @@ tl::expected<ConnectionPtr, ConnectionError> CreateConnection(
         return tl::make_unexpected(ConnectionError{"Invalid ip-address: " + ipAddress});
     }
 
-    if (connect(clientSocket, (const sockaddr*)&serverAddress, sizeof(serverAddress)) != 0)
+    // The socket is closed by the connection, also when connecting fails
+    Connection connection{(long)socket(AF_INET, SOCK_STREAM, 0)};
+    connection.SetTimeout(std::chrono::seconds(1));
+    connection.SetDeadline(deadline);
+
+    // Connect without blocking, then wait until the socket is writable or the deadline stops it
+#ifdef _MSC_VER
+    u_long bNonBlocking = 1;
+    ioctlsocket(connection.m_socket, FIONBIO, &bNonBlocking);
+#else
+    const int flags = fcntl(connection.m_socket, F_GETFL, 0);
+    fcntl(connection.m_socket, F_SETFL, flags | O_NONBLOCK);
+#endif
+
+    if (connect(connection.m_socket, (const sockaddr*)&serverAddress, sizeof(serverAddress)) != 0)
     {
-        return tl::make_unexpected(ConnectionError{"Failed to connect with: " + ipAddress});
+#ifdef _MSC_VER
+        const bool bPending = WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+        const bool bPending = errno == EINPROGRESS;
+#endif
+        if (!bPending)
+        {
+            return tl::make_unexpected(ConnectionError{"Failed to connect with: " + ipAddress});
+        }
+
+        auto ready = connection.Wait(true, deadline.time);
+        if (!ready.has_value() && deadline.token.IsCancelled())
+        {
+            return tl::make_unexpected(ready.error());
+        }
+        if (!ready.has_value() || !ready.value())
+        {
+            return tl::make_unexpected(
+                ConnectionError{"Timed out connecting with: " + ipAddress});
+        }
+
+        int error = 0;
+        socklen_t errorLength = sizeof(error);
+        getsockopt(connection.m_socket, SOL_SOCKET, SO_ERROR, (char*)&error, &errorLength);
+        if (error != 0)
+        {
+            return tl::make_unexpected(ConnectionError{"Failed to connect with: " + ipAddress});
+        }
     }
 
-    Connection connection{clientSocket};
+#ifdef _MSC_VER
+    bNonBlocking = 0;
+    ioctlsocket(connection.m_socket, FIONBIO, &bNonBlocking);
+#else
+    fcntl(connection.m_socket, F_SETFL, flags);
+#endif
+
+    return std::make_shared<Connection>(std::move(connection));
+}
+
+// ------------------------------------------------------------------------------------------------
+ConnectionPtr CreateConnection(long socket)
+{
+    Connection connection{socket};
+    connection.SetTimeout(std::chrono::seconds(1));
+
+#ifdef _MSC_VER
+    u_long bNonBlocking = 0;
+    ioctlsocket(connection.m_socket, FIONBIO, &bNonBlocking);
+#else
+    const int flags = fcntl(connection.m_socket, F_GETFL, 0);
+    fcntl(connection.m_socket, F_SETFL, flags & ~O_NONBLOCK);
+#endif
+
     return std::make_shared<Connection>(std::move(connection));
 }
 
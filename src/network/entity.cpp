@@ -3,14 +3,21 @@
 #include "core/four_q.h"
 
 // ------------------------------------------------------------------------------------------------
-tl::expected<RespondedEntity, ConnectionError> GetEntity(
-    const ConnectionPtr& connection,
-    const std::string& identity)
+namespace
+{
+
+/**
+ * Create the packet of an entity request
+ * @param identity The identity of the entity to query
+ * @return The packet or an error
+ */
+tl::expected<std::vector<char>, ConnectionError> CreateEntityRequest(const std::string& identity)
 {
     // Check identity length
     if (identity.size() != 60)
     {
-        return tl::make_unexpected(ConnectionError{"Invalid identity with invalid length: " + identity});
+        return tl::make_unexpected(
+            ConnectionError{"Invalid identity with invalid length: " + identity});
     }
 
     // Construct packet
@@ -29,12 +36,46 @@ tl::expected<RespondedEntity, ConnectionError> GetEntity(
     unsigned char public_key[32];
     if (!getPublicKeyFromIdentity((const unsigned char*)identity.data(), public_key))
     {
-        return tl::make_unexpected(ConnectionError{"Failed to compute public key from identity: " + identity});
+        return tl::make_unexpected(
+            ConnectionError{"Failed to compute public key from identity: " + identity});
     }
     memcpy(&packet.request.publicKey, public_key, 32);
 
+    return std::vector<char>((const char*)&packet, (const char*)&packet + sizeof(packet));
+}
+
+/**
+ * Get the balance of a queried entity
+ * @param response The entity or the error of the query
+ * @return The balance or an error
+ */
+tl::expected<unsigned long long, ConnectionError> ToBalance(
+    const tl::expected<RespondedEntity, ConnectionError>& response)
+{
+    if (response.has_value())
+    {
+        auto entity = response.value();
+        // todo: do i really have to check that incoming is > than outgoing?
+        return entity.entity.incomingAmount - entity.entity.outgoingAmount;
+    }
+    return tl::make_unexpected(ConnectionError{"Get balance failed: " + response.error().message});
+}
+
+} // namespace
+
+// ------------------------------------------------------------------------------------------------
+tl::expected<RespondedEntity, ConnectionError> GetEntity(
+    const ConnectionPtr& connection,
+    const std::string& identity)
+{
+    auto request = CreateEntityRequest(identity);
+    if (!request.has_value())
+    {
+        return tl::make_unexpected(request.error());
+    }
+
     // Send request
-    if (!connection->Send((char*)&packet, sizeof(packet)))
+    if (!connection->Send(request->data(), (int)request->size()))
     {
         return tl::make_unexpected(ConnectionError{"Failed to send identity request"});
     }
@@ -48,12 +89,148 @@ tl::expected<unsigned long long, ConnectionError> GetBalance(
     const ConnectionPtr& connection,
     const std::string& identity)
 {
-    auto response = GetEntity(connection, identity);
-    if (response.has_value())
+    return ToBalance(GetEntity(connection, identity));
+}
+
+// ------------------------------------------------------------------------------------------------
+tl::expected<RespondedEntity, ConnectionError> GetEntity(
+    RequestCoalescer& coalescer,
+    NodeRegistry& registry,
+    const std::string& identity,
+    const Deadline& deadline)
+{
+    auto request = CreateEntityRequest(identity);
+    if (!request.has_value())
     {
-        auto entity = response.value();
-        // todo: do i really have to check that incoming is > than outgoing?
-        return entity.entity.incomingAmount - entity.entity.outgoingAmount;
+        return tl::make_unexpected(request.error());
     }
-    return tl::make_unexpected(ConnectionError{"Get balance failed: " + response.error().message});
+
+    const RequestKey key{
+        REQUEST_ENTITY,
+        std::string(request->begin() + sizeof(RequestResponseHeader), request->end())};
+    return coalescer.Run<RespondedEntity>(
+        key,
+        [&]() -> tl::expected<RespondedEntity, ConnectionError> {
+            auto connection = CreateConnection(registry, deadline);
+            if (!connection.has_value())
+            {
+                return tl::make_unexpected(connection.error());
+            }
+            return GetEntity(connection.value(), identity);
+        });
+}
+
+// ------------------------------------------------------------------------------------------------
+tl::expected<unsigned long long, ConnectionError> GetBalance(
+    RequestCoalescer& coalescer,
+    NodeRegistry& registry,
+    const std::string& identity,
+    const Deadline& deadline)
+{
+    return ToBalance(GetEntity(coalescer, registry, identity, deadline));
+}
+
+// ------------------------------------------------------------------------------------------------
+void GetEntityAsync(
+    AsyncEngine& engine,
+    const NodeAddress& node,
+    const std::string& identity,
+    AsyncCallback<RespondedEntity> callback,
+    std::chrono::milliseconds timeout,
+    CancellationToken token)
+{
+    auto request = CreateEntityRequest(identity);
+    if (!request.has_value())
+    {
+        callback(tl::make_unexpected(request.error()));
+        return;
+    }
+
+    engine.RequestAs<RespondedEntity>(
+        node,
+        std::move(request.value()),
+        RESPOND_ENTITY,
+        timeout,
+        std::move(callback),
+        std::move(token));
+}
+
+// ------------------------------------------------------------------------------------------------
+void GetEntityAsync(
+    RequestHedger& hedger,
+    const std::vector<NodeAddress>& nodes,
+    const std::string& identity,
+    AsyncCallback<RespondedEntity> callback,
+    std::chrono::milliseconds timeout,
+    CancellationToken token)
+{
+    auto request = CreateEntityRequest(identity);
+    if (!request.has_value())
+    {
+        callback(tl::make_unexpected(request.error()));
+        return;
+    }
+
+    hedger.RequestAs<RespondedEntity>(
+        nodes,
+        std::move(request.value()),
+        RESPOND_ENTITY,
+        timeout,
+        std::move(callback),
+        std::move(token));
+}
+
+// ------------------------------------------------------------------------------------------------
+void GetBalanceAsync(
+    AsyncEngine& engine,
+    const std::vector<NodeAddress>& nodes,
+    const std::string& identity,
+    size_t requiredCount,
+    AsyncCallback<unsigned long long> callback,
+    std::chrono::milliseconds timeout,
+    CancellationToken token)
+{
+    auto request = CreateEntityRequest(identity);
+    if (!request.has_value())
+    {
+        callback(tl::make_unexpected(request.error()));
+        return;
+    }
+
+    // Nodes at different ticks may report the same entity, only the balance must match
+    const auto balance = [](const RespondedEntity& entity) {
+        return entity.entity.incomingAmount - entity.entity.outgoingAmount;
+    };
+    RequestAgreedAs<RespondedEntity>(
+        engine,
+        nodes,
+        request.value(),
+        RESPOND_ENTITY,
+        requiredCount,
+        balance,
+        timeout,
+        [balance, callback = std::move(callback)](
+            tl::expected<RespondedEntity, ConnectionError> entity) {
+            if (!entity.has_value())
+            {
+                callback(tl::make_unexpected(entity.error()));
+                return;
+            }
+            callback((unsigned long long)balance(entity.value()));
+        },
+        std::move(token));
+}
+
+// ------------------------------------------------------------------------------------------------
+Task<tl::expected<RespondedEntity, ConnectionError>> GetEntityTask(
+    AsyncEngine& engine,
+    NodeAddress node,
+    std::string identity,
+    std::chrono::milliseconds timeout,
+    CancellationToken token)
+{
+    co_return co_await CallbackAwaitable<tl::expected<RespondedEntity, ConnectionError>>(
+        [&](AsyncCallback<RespondedEntity> callback) {
+            GetEntityAsync(engine, node, identity, std::move(callback), timeout, token);
+        });
 }
@@ -0,0 +1,279 @@
+#include "network/async_backend.hpp"
+
+#ifdef __linux__
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <utility>
+
+// ------------------------------------------------------------------------------------------------
+namespace
+{
+
+/// Minimum free space of a receive
+constexpr size_t minimumReceiveSize = 4096;
+
+/**
+ * Request watched by epoll
+ */
+struct EpollOperation : AsyncOperation
+{
+    /// The non-blocking socket
+    int socket = -1;
+
+    /// Is the socket connected
+    bool bConnected = false;
+
+    /// Number of bytes sent
+    size_t sentSize = 0;
+};
+
+/**
+ * Non-blocking sockets watched by one epoll instance, the events carry the request ids
+ */
+class EpollBackend : public AsyncBackend
+{
+public:
+    /**
+     * Constructor
+     * @param engine The engine that owns the backend
+     * @param epoll The epoll instance
+     * @param wakeEvent The event to wake up `Poll`, registered with id 0
+     */
+    EpollBackend(AsyncEngine& engine, int epoll, int wakeEvent)
+        : AsyncBackend(engine)
+        , m_epoll(epoll)
+        , m_wakeEvent(wakeEvent)
+        , m_events(256)
+    {}
+
+    ~EpollBackend() override
+    {
+        close(m_wakeEvent);
+        close(m_epoll);
+    }
+
+    std::unique_ptr<AsyncOperation> CreateOperation() const override
+    {
+        return std::make_unique<EpollOperation>();
+    }
+
+    void Start(AsyncOperation& operation) override
+    {
+        auto& current = static_cast<EpollOperation&>(operation);
+
+        sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_port = htons(current.node.port);
+        if (inet_pton(AF_INET, current.node.ipAddress.c_str(), &address.sin_addr) <= 0)
+        {
+            Fail(current, "Invalid ip-address: " + current.node.ipAddress);
+            return;
+        }
+
+        current.socket = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (connect(current.socket, (const sockaddr*)&address, sizeof(address)) != 0 &&
+            errno != EINPROGRESS)
+        {
+            Fail(current, "Failed to connect with: " + current.node.ipAddress);
+            return;
+        }
+
+        // Writable once connected
+        epoll_event event{};
+        event.events = EPOLLOUT;
+        event.data.u64 = current.id;
+        epoll_ctl(m_epoll, EPOLL_CTL_ADD, current.socket, &event);
+    }
+
+    void Poll(std::chrono::milliseconds timeout) override
+    {
+        const int count = epoll_wait(
+            m_epoll,
+            m_events.data(),
+            (int)m_events.size(),
+            (int)std::max<long long>(timeout.count(), -1));
+        for (int i = 0; i < count; ++i)
+        {
+            const auto id = m_events[i].data.u64;
+            if (id == 0)
+            {
+                unsigned long long value;
+                while (read(m_wakeEvent, &value, sizeof(value)) > 0)
+                {}
+                continue;
+            }
+
+            // Completed by an earlier event of this batch
+            auto* operation = FindOperation(id);
+            if (operation)
+            {
+                Advance(static_cast<EpollOperation&>(*operation));
+            }
+        }
+    }
+
+    void Wake() override
+    {
+        const unsigned long long value = 1;
+        (void)!write(m_wakeEvent, &value, sizeof(value));
+    }
+
+    void Stop(AsyncOperation& operation) override
+    {
+        auto& current = static_cast<EpollOperation&>(operation);
+        if (current.socket >= 0)
+        {
+            epoll_ctl(m_epoll, EPOLL_CTL_DEL, current.socket, nullptr);
+            close(current.socket);
+            current.socket = -1;
+        }
+    }
+
+private:
+    /**
+     * Continue a request after its socket became ready
+     * @param operation The request
+     */
+    void Advance(EpollOperation& operation)
+    {
+        if (!operation.bConnected)
+        {
+            int error = 0;
+            socklen_t errorLength = sizeof(error);
+            getsockopt(operation.socket, SOL_SOCKET, SO_ERROR, &error, &errorLength);
+            if (error != 0)
+            {
+                Fail(operation, "Failed to connect with: " + operation.node.ipAddress);
+                return;
+            }
+            operation.bConnected = true;
+        }
+
+        if (operation.bConnectOnly)
+        {
+            epoll_ctl(m_epoll, EPOLL_CTL_DEL, operation.socket, nullptr);
+            operation.connection = CreateConnection((long)std::exchange(operation.socket, -1));
+            Complete(operation, nullptr);
+            return;
+        }
+
+        // Send as much as the socket takes
+        while (operation.sentSize < operation.request.size())
+        {
+            const auto sent = send(
+                operation.socket,
+                operation.request.data() + operation.sentSize,
+                operation.request.size() - operation.sentSize,
+                MSG_NOSIGNAL);
+            if (sent < 0)
+            {
+                if (errno == EAGAIN || errno == EWOULDBLOCK)
+                {
+                    return;
+                }
+                Fail(operation, "Failed to send request to: " + operation.node.ipAddress);
+                return;
+            }
+
+            operation.sentSize += sent;
+            if (operation.sentSize == operation.request.size())
+            {
+                if (!operation.bExpectResponse)
+                {
+                    Complete(operation, nullptr);
+                    return;
+                }
+
+                // Readable once the response arrives
+                epoll_event event{};
+                event.events = EPOLLIN;
+                event.data.u64 = operation.id;
+                epoll_ctl(m_epoll, EPOLL_CTL_MOD, operation.socket, &event);
+                return;
+            }
+        }
+
+        // Receive until the response is complete or the socket runs dry
+        while (!ParseResponse(operation))
+        {
+            const size_t wantedSize = operation.receivedSize + minimumReceiveSize;
+            if (operation.received.size() < wantedSize)
+            {
+                operation.received.resize(std::max(wantedSize, 2 * operation.received.size()));
+            }
+
+            const auto received = recv(
+                operation.socket,
+                operation.received.data() + operation.receivedSize,
+                operation.received.size() - operation.receivedSize,
+                0);
+            if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            {
+                return;
+            }
+            if (received <= 0)
+            {
+                Fail(
+                    operation,
+                    "Response did not contain header type: " +
+                        std::to_string((int)operation.responseType));
+                return;
+            }
+            operation.receivedSize += received;
+        }
+    }
+
+private:
+    /// The epoll instance
+    int m_epoll;
+
+    /// Event to wake up `Poll`
+    int m_wakeEvent;
+
+    /// Events of a wait
+    std::vector<epoll_event> m_events;
+};
+
+} // namespace
+
+// ------------------------------------------------------------------------------------------------
+std::unique_ptr<AsyncBackend> CreateEpollBackend(AsyncEngine& engine)
+{
+    const int epoll = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll < 0)
+    {
+        return nullptr;
+    }
+
+    const int wakeEvent = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u64 = 0;
+    if (wakeEvent < 0 || epoll_ctl(epoll, EPOLL_CTL_ADD, wakeEvent, &event) != 0)
+    {
+        if (wakeEvent >= 0)
+        {
+            close(wakeEvent);
+        }
+        close(epoll);
+        return nullptr;
+    }
+
+    return std::make_unique<EpollBackend>(engine, epoll, wakeEvent);
+}
+
+#else
+
+// ------------------------------------------------------------------------------------------------
+std::unique_ptr<AsyncBackend> CreateEpollBackend(AsyncEngine&) { return nullptr; }
+
+#endif
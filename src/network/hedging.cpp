@@ -0,0 +1,211 @@
+#include "network/hedging.hpp"
+
+// ------------------------------------------------------------------------------------------------
+namespace
+{
+
+/// Clock of the hedged requests
+typedef std::chrono::steady_clock Clock;
+
+/**
+ * Hedged request in flight
+ *
+ * Owned by the engine thread once the first node was asked, all callbacks and timers run there.
+ */
+struct HedgedRequest
+{
+    /// Runs the requests
+    AsyncEngine& engine;
+
+    /// The nodes to ask, best first
+    std::vector<NodeAddress> nodes;
+
+    /// The packets to send
+    std::vector<char> request;
+
+    /// The header type of the response
+    unsigned char responseType;
+
+    /// Time after which the next node is asked, unless the registry knows the node
+    std::chrono::milliseconds delay;
+
+    /// When to ask another node
+    HedgingPolicy policy;
+
+    /// Registry of the nodes, if any
+    NodeRegistry* registry;
+
+    /// Time at which the request fails
+    Clock::time_point deadline;
+
+    /// Receives the first response
+    RequestCallback callback;
+
+    /// Cancelled once done, which cancels the requests that lost
+    CancellationToken token;
+
+    /// Receives the latency of the response that won
+    std::shared_ptr<LatencyTracker> latencies;
+
+    /// Number of nodes that may be asked
+    size_t attemptCount;
+
+    /// Number of nodes asked
+    size_t startedCount = 0;
+
+    /// Number of nodes that failed
+    size_t failedCount = 0;
+
+    /// The callback was called
+    bool bDone = false;
+};
+
+/**
+ * Ask the next node
+ * @param hedged The request
+ */
+void StartAttempt(const std::shared_ptr<HedgedRequest>& hedged)
+{
+    // Counted before anything is handed to the engine thread, which owns the state from then on
+    const auto node = hedged->nodes[hedged->startedCount++];
+    if (hedged->startedCount < hedged->attemptCount)
+    {
+        auto delay = hedged->delay;
+        if (hedged->registry)
+        {
+            auto latency = hedged->registry->GetLatency(node, hedged->policy.quantile);
+            if (latency.has_value())
+            {
+                delay = std::max(latency.value(), hedged->policy.minimumDelay);
+            }
+        }
+
+        // Only if no other node was asked meanwhile, e.g. because this one failed
+        hedged->engine.RunAfter(
+            delay,
+            [hedged, next = hedged->startedCount]() {
+                if (!hedged->bDone && hedged->startedCount == next)
+                {
+                    StartAttempt(hedged);
+                }
+            },
+            hedged->token);
+    }
+
+    const auto start = Clock::now();
+    auto timeout = std::max(
+        std::chrono::ceil<std::chrono::milliseconds>(hedged->deadline - start),
+        std::chrono::milliseconds(0));
+    if (hedged->registry)
+    {
+        timeout = std::min(timeout, hedged->registry->GetTimeout(node));
+    }
+
+    hedged->engine.Request(
+        node,
+        hedged->request,
+        hedged->responseType,
+        true,
+        timeout,
+        [hedged, node, start](tl::expected<const char*, ConnectionError> frame) {
+            if (hedged->bDone)
+            {
+                return;
+            }
+
+            if (frame.has_value())
+            {
+                const auto latency =
+                    std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start);
+                hedged->latencies->AddLatency(latency);
+                if (hedged->registry)
+                {
+                    hedged->registry->ReportSuccess(node, latency);
+                }
+                hedged->bDone = true;
+                hedged->token.Cancel();
+                hedged->callback(frame);
+                return;
+            }
+
+            // Replace the failed node right away
+            ++hedged->failedCount;
+            if (hedged->registry && !hedged->token.IsCancelled())
+            {
+                hedged->registry->ReportFailure(node);
+            }
+            if (hedged->startedCount < hedged->attemptCount && !hedged->token.IsCancelled())
+            {
+                StartAttempt(hedged);
+                return;
+            }
+            if (hedged->failedCount == hedged->startedCount)
+            {
+                hedged->bDone = true;
+                hedged->callback(tl::make_unexpected(frame.error()));
+            }
+        },
+        hedged->token);
+}
+
+} // namespace
+
+// ------------------------------------------------------------------------------------------------
+RequestHedger::RequestHedger(AsyncEngine& engine, HedgingPolicy policy)
+    : m_engine(engine)
+    , m_policy(std::move(policy))
+    , m_latencies(std::make_shared<LatencyTracker>())
+{}
+
+// ------------------------------------------------------------------------------------------------
+RequestHedger::RequestHedger(AsyncEngine& engine, NodeRegistry& registry, HedgingPolicy policy)
+    : RequestHedger(engine, std::move(policy))
+{
+    m_registry = &registry;
+}
+
+// ------------------------------------------------------------------------------------------------
+void RequestHedger::Request(
+    const std::vector<NodeAddress>& nodes,
+    std::vector<char> request,
+    unsigned char responseType,
+    std::chrono::milliseconds timeout,
+    RequestCallback callback,
+    CancellationToken token)
+{
+    if (nodes.empty())
+    {
+        callback(tl::make_unexpected(ConnectionError{"No nodes to send the request to"}));
+        return;
+    }
+
+    auto hedged = std::make_shared<HedgedRequest>(HedgedRequest{
+        m_engine,
+        nodes,
+        std::move(request),
+        responseType,
+        GetDelay(),
+        m_policy,
+        m_registry,
+        Clock::now() + timeout,
+        std::move(callback),
+        token.CreateLinked(),
+        m_latencies,
+        std::min(std::max(m_policy.maximumAttempts, (size_t)1), nodes.size())});
+    StartAttempt(hedged);
+}
+
+// ------------------------------------------------------------------------------------------------
+std::chrono::milliseconds RequestHedger::GetDelay() const
+{
+    if (m_latencies->GetSampleCount() < m_policy.minimumSampleCount)
+    {
+        return m_policy.defaultDelay;
+    }
+    return std::max(
+        m_latencies->GetQuantile(m_policy.quantile).value_or(m_policy.defaultDelay),
+        m_policy.minimumDelay);
+}
+
+// ------------------------------------------------------------------------------------------------
+const LatencyTracker& RequestHedger::GetLatencies() const { return *m_latencies; }
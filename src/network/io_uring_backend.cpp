@@ -0,0 +1,691 @@
+#include "network/async_backend.hpp"
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#endif
+
+// Multishot receives were the last of the required features to be added
+#ifdef IORING_RECV_MULTISHOT
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <utility>
+
+// ------------------------------------------------------------------------------------------------
+namespace
+{
+
+/// Entries of the submission queue, the completion queue has twice as many
+constexpr unsigned int submissionQueueSize = 1024;
+
+/// Number of registered receive buffers, a power of two
+constexpr unsigned int bufferCount = 256;
+
+/// Size of a registered receive buffer
+constexpr unsigned int bufferSize = 4096;
+
+/// Id of the group of the registered receive buffers
+constexpr unsigned short bufferGroup = 0;
+
+/// User data of the read of the wake event, request ids start at one
+constexpr unsigned long long wakeUserData = 0;
+
+/**
+ * Kind of submission, stored in the low bits of the user data next to the request id
+ */
+enum Submission : unsigned long long
+{
+    ConnectSubmission = 0,
+    SendSubmission = 1,
+    ReceiveSubmission = 2,
+    CancelSubmission = 3
+};
+
+/**
+ * Request driven by io_uring
+ */
+struct IoUringOperation : AsyncOperation
+{
+    /// The socket
+    int socket = -1;
+
+    /// Address of the node, read by the connect submission
+    sockaddr_in address;
+
+    /// Number of bytes sent
+    size_t sentSize = 0;
+
+    /// Submissions that will still post a completion, the request can't be freed before
+    unsigned int pendingCount = 0;
+};
+
+/**
+ * Batched submissions, multishot receives into a ring of registered buffers, and one
+ * `io_uring_enter` per loop iteration to both submit and wait. Talks to the kernel through the
+ * raw system calls, so there is no dependency on liburing.
+ */
+class IoUringBackend : public AsyncBackend
+{
+public:
+    /**
+     * Constructor
+     * @param engine The engine that owns the backend
+     */
+    explicit IoUringBackend(AsyncEngine& engine)
+        : AsyncBackend(engine)
+    {}
+
+    ~IoUringBackend() override
+    {
+        for (auto& [id, operation] : m_released)
+        {
+            close(static_cast<IoUringOperation&>(*operation).socket);
+        }
+
+        if (m_ring >= 0)
+        {
+            close(m_ring);
+        }
+        if (m_wakeEvent >= 0)
+        {
+            close(m_wakeEvent);
+        }
+        if (m_bufferRing)
+        {
+            munmap(m_bufferRing, bufferCount * sizeof(io_uring_buf));
+        }
+        if (m_submissions)
+        {
+            munmap(m_submissions, m_submissionsSize);
+        }
+        if (m_rings)
+        {
+            munmap(m_rings, m_ringsSize);
+        }
+    }
+
+    /**
+     * Set up the rings and the receive buffers
+     * @return `true` upon success, `false` if the host lacks a required feature
+     */
+    bool Initialize()
+    {
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        m_ring = (int)syscall(__NR_io_uring_setup, submissionQueueSize, &params);
+        if (m_ring < 0)
+        {
+            return false;
+        }
+
+        const unsigned int requiredFeatures =
+            IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG;
+        if ((params.features & requiredFeatures) != requiredFeatures)
+        {
+            return false;
+        }
+
+        // Submission and completion queue share one mapping
+        m_ringsSize = std::max(
+            params.sq_off.array + params.sq_entries * sizeof(unsigned int),
+            params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+        void* rings = mmap(
+            nullptr,
+            m_ringsSize,
+            PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE,
+            m_ring,
+            IORING_OFF_SQ_RING);
+        if (rings == MAP_FAILED)
+        {
+            return false;
+        }
+        m_rings = (char*)rings;
+
+        m_submissionsSize = params.sq_entries * sizeof(io_uring_sqe);
+        void* submissions = mmap(
+            nullptr,
+            m_submissionsSize,
+            PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE,
+            m_ring,
+            IORING_OFF_SQES);
+        if (submissions == MAP_FAILED)
+        {
+            return false;
+        }
+        m_submissions = (io_uring_sqe*)submissions;
+
+        m_submissionHead = (unsigned int*)(m_rings + params.sq_off.head);
+        m_submissionTail = (unsigned int*)(m_rings + params.sq_off.tail);
+        m_submissionMask = *(unsigned int*)(m_rings + params.sq_off.ring_mask);
+        m_submissionEntries = params.sq_entries;
+        m_localSubmissionTail = *m_submissionTail;
+        auto* indices = (unsigned int*)(m_rings + params.sq_off.array);
+        for (unsigned int i = 0; i < params.sq_entries; ++i)
+        {
+            indices[i] = i;
+        }
+
+        m_completionHead = (unsigned int*)(m_rings + params.cq_off.head);
+        m_completionTail = (unsigned int*)(m_rings + params.cq_off.tail);
+        m_completionMask = *(unsigned int*)(m_rings + params.cq_off.ring_mask);
+        m_completions = (io_uring_cqe*)(m_rings + params.cq_off.cqes);
+
+        // Register the receive buffers, the kernel picks one for each received chunk
+        void* bufferRing = mmap(
+            nullptr,
+            bufferCount * sizeof(io_uring_buf),
+            PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS,
+            -1,
+            0);
+        if (bufferRing == MAP_FAILED)
+        {
+            return false;
+        }
+        m_bufferRing = (io_uring_buf_ring*)bufferRing;
+
+        io_uring_buf_reg registration;
+        memset(&registration, 0, sizeof(registration));
+        registration.ring_addr = (unsigned long long)m_bufferRing;
+        registration.ring_entries = bufferCount;
+        registration.bgid = bufferGroup;
+        if (syscall(__NR_io_uring_register, m_ring, IORING_REGISTER_PBUF_RING, &registration, 1) !=
+            0)
+        {
+            return false;
+        }
+
+        m_buffers.resize(bufferCount * bufferSize);
+        for (unsigned short i = 0; i < bufferCount; ++i)
+        {
+            RecycleBuffer(i);
+        }
+
+        m_wakeEvent = eventfd(0, EFD_CLOEXEC);
+        if (m_wakeEvent < 0)
+        {
+            return false;
+        }
+        SubmitWakeRead();
+
+        return true;
+    }
+
+    std::unique_ptr<AsyncOperation> CreateOperation() const override
+    {
+        return std::make_unique<IoUringOperation>();
+    }
+
+    void Start(AsyncOperation& operation) override
+    {
+        auto& current = static_cast<IoUringOperation&>(operation);
+
+        memset(&current.address, 0, sizeof(current.address));
+        current.address.sin_family = AF_INET;
+        current.address.sin_port = htons(current.node.port);
+        if (inet_pton(AF_INET, current.node.ipAddress.c_str(), &current.address.sin_addr) <= 0)
+        {
+            Fail(current, "Invalid ip-address: " + current.node.ipAddress);
+            return;
+        }
+
+        current.socket = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (current.socket < 0)
+        {
+            Fail(current, "Failed to connect with: " + current.node.ipAddress);
+            return;
+        }
+
+        // The send only starts once connected
+        auto* connect = GetSubmission();
+        connect->opcode = IORING_OP_CONNECT;
+        connect->fd = current.socket;
+        connect->addr = (unsigned long long)&current.address;
+        connect->off = sizeof(current.address);
+        connect->user_data = (current.id << 2) | ConnectSubmission;
+        ++current.pendingCount;
+
+        if (!current.bConnectOnly)
+        {
+            connect->flags = IOSQE_IO_LINK;
+            SubmitSend(current);
+        }
+    }
+
+    void Poll(std::chrono::milliseconds timeout) override
+    {
+        __kernel_timespec time;
+        io_uring_getevents_arg argument;
+        memset(&argument, 0, sizeof(argument));
+        if (timeout.count() >= 0)
+        {
+            time.tv_sec = timeout.count() / 1000;
+            time.tv_nsec = (timeout.count() % 1000) * 1000000;
+            argument.ts = (unsigned long long)&time;
+        }
+
+        Enter(1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &argument, sizeof(argument));
+
+        // Handlers may post more completions, e.g. a failed submission
+        while (true)
+        {
+            const unsigned int head = *m_completionHead;
+            if (head == __atomic_load_n(m_completionTail, __ATOMIC_ACQUIRE))
+            {
+                break;
+            }
+
+            const io_uring_cqe completion = m_completions[head & m_completionMask];
+            __atomic_store_n(m_completionHead, head + 1, __ATOMIC_RELEASE);
+            HandleCompletion(completion);
+        }
+    }
+
+    void Wake() override
+    {
+        const unsigned long long value = 1;
+        (void)!write(m_wakeEvent, &value, sizeof(value));
+    }
+
+    void Stop(AsyncOperation& operation) override
+    {
+        auto& current = static_cast<IoUringOperation&>(operation);
+        if (current.pendingCount == 0)
+        {
+            return;
+        }
+
+        auto* cancel = GetSubmission();
+        cancel->opcode = IORING_OP_ASYNC_CANCEL;
+        cancel->fd = current.socket;
+        cancel->cancel_flags = IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_ALL;
+        cancel->user_data = (current.id << 2) | CancelSubmission;
+        ++current.pendingCount;
+    }
+
+    void Release(std::unique_ptr<AsyncOperation> operation) override
+    {
+        auto& current = static_cast<IoUringOperation&>(*operation);
+        if (current.pendingCount > 0)
+        {
+            m_released.emplace(current.id, std::move(operation));
+            return;
+        }
+        if (current.socket >= 0)
+        {
+            close(current.socket);
+        }
+    }
+
+    void Drain() override
+    {
+        // Submissions of released requests still use their buffers, let them be canceled first.
+        // This runs on the engine thread, completions notify the thread that submitted.
+        for (int i = 0; i < 10 && !m_released.empty(); ++i)
+        {
+            Poll(std::chrono::milliseconds(100));
+        }
+    }
+
+private:
+    /**
+     * Get a free submission queue entry, submitting the queue if it is full
+     * @return The zeroed entry
+     */
+    io_uring_sqe* GetSubmission()
+    {
+        while (m_localSubmissionTail - __atomic_load_n(m_submissionHead, __ATOMIC_ACQUIRE) >=
+               m_submissionEntries)
+        {
+            Enter(0, 0, nullptr, 0);
+        }
+
+        auto* submission = &m_submissions[m_localSubmissionTail & m_submissionMask];
+        memset(submission, 0, sizeof(*submission));
+        ++m_localSubmissionTail;
+        ++m_unsubmittedCount;
+        return submission;
+    }
+
+    /**
+     * Submit the queued entries and optionally wait for completions
+     * @param minimumCompletions The number of completions to wait for
+     * @param flags The flags of `io_uring_enter`
+     * @param argument The extended argument
+     * @param argumentSize The size of the extended argument
+     */
+    void Enter(
+        unsigned int minimumCompletions,
+        unsigned int flags,
+        const void* argument,
+        size_t argumentSize)
+    {
+        __atomic_store_n(m_submissionTail, m_localSubmissionTail, __ATOMIC_RELEASE);
+        const long submitted = syscall(
+            __NR_io_uring_enter,
+            m_ring,
+            m_unsubmittedCount,
+            minimumCompletions,
+            flags,
+            argument,
+            argumentSize);
+        if (submitted > 0)
+        {
+            m_unsubmittedCount -= std::min((unsigned int)submitted, m_unsubmittedCount);
+        }
+    }
+
+    /**
+     * Queue a send of the remaining request
+     * @param operation The request
+     */
+    void SubmitSend(IoUringOperation& operation)
+    {
+        auto* send = GetSubmission();
+        send->opcode = IORING_OP_SEND;
+        send->fd = operation.socket;
+        send->addr = (unsigned long long)(operation.request.data() + operation.sentSize);
+        send->len = (unsigned int)(operation.request.size() - operation.sentSize);
+        send->msg_flags = MSG_NOSIGNAL;
+        send->user_data = (operation.id << 2) | SendSubmission;
+        ++operation.pendingCount;
+    }
+
+    /**
+     * Queue a receive into the registered buffers
+     * @param operation The request
+     */
+    void SubmitReceive(IoUringOperation& operation)
+    {
+        auto* receive = GetSubmission();
+        receive->opcode = IORING_OP_RECV;
+        receive->fd = operation.socket;
+        receive->flags = IOSQE_BUFFER_SELECT;
+        receive->buf_group = bufferGroup;
+        if (m_bMultishot)
+        {
+            receive->ioprio = IORING_RECV_MULTISHOT;
+        }
+        else
+        {
+            receive->len = bufferSize;
+        }
+        receive->user_data = (operation.id << 2) | ReceiveSubmission;
+        ++operation.pendingCount;
+    }
+
+    /**
+     * Queue a read of the wake event
+     */
+    void SubmitWakeRead()
+    {
+        auto* read = GetSubmission();
+        read->opcode = IORING_OP_READ;
+        read->fd = m_wakeEvent;
+        read->addr = (unsigned long long)&m_wakeValue;
+        read->len = sizeof(m_wakeValue);
+        read->user_data = wakeUserData;
+    }
+
+    /**
+     * Give a receive buffer back to the kernel
+     * @param bufferId The id of the buffer
+     */
+    void RecycleBuffer(unsigned short bufferId)
+    {
+        // Not `bufs`, its flexible array macro adds an empty struct in C++ which offsets it
+        auto& buffer = ((io_uring_buf*)m_bufferRing)[m_bufferTail & (bufferCount - 1)];
+        buffer.addr = (unsigned long long)(m_buffers.data() + bufferId * bufferSize);
+        buffer.len = bufferSize;
+        buffer.bid = bufferId;
+        ++m_bufferTail;
+        __atomic_store_n(&m_bufferRing->tail, m_bufferTail, __ATOMIC_RELEASE);
+    }
+
+    /**
+     * Continue the request of a completion
+     * @param completion The completion
+     */
+    void HandleCompletion(const io_uring_cqe& completion)
+    {
+        if (completion.user_data == wakeUserData)
+        {
+            SubmitWakeRead();
+            return;
+        }
+
+        const auto id = completion.user_data >> 2;
+        const bool bMore = completion.flags & IORING_CQE_F_MORE;
+        const bool bBuffer = completion.flags & IORING_CQE_F_BUFFER;
+        const auto bufferId = (unsigned short)(completion.flags >> IORING_CQE_BUFFER_SHIFT);
+
+        auto* operation = FindOperation(id);
+        if (operation)
+        {
+            auto& current = static_cast<IoUringOperation&>(*operation);
+            if (!bMore)
+            {
+                --current.pendingCount;
+            }
+            Advance(
+                current,
+                (Submission)(completion.user_data & 3),
+                completion.res,
+                bMore,
+                bBuffer ? m_buffers.data() + bufferId * bufferSize : nullptr);
+        }
+        else
+        {
+            // Completed already, free it once the kernel is done with it
+            const auto it = m_released.find(id);
+            if (it != m_released.end() && !bMore)
+            {
+                auto& current = static_cast<IoUringOperation&>(*it->second);
+                if (--current.pendingCount == 0)
+                {
+                    close(current.socket);
+                    m_released.erase(it);
+                }
+            }
+        }
+
+        if (bBuffer)
+        {
+            RecycleBuffer(bufferId);
+        }
+    }
+
+    /**
+     * Continue a request after one of its submissions completed
+     * @param operation The request
+     * @param submission The kind of submission
+     * @param result The result of the submission
+     * @param bMore Will the submission post more completions
+     * @param buffer The received data, if any
+     */
+    void Advance(
+        IoUringOperation& operation,
+        Submission submission,
+        int result,
+        bool bMore,
+        const char* buffer)
+    {
+        switch (submission)
+        {
+        case ConnectSubmission:
+            if (result < 0)
+            {
+                Fail(operation, "Failed to connect with: " + operation.node.ipAddress);
+            }
+            else if (operation.bConnectOnly)
+            {
+                operation.connection = CreateConnection((long)std::exchange(operation.socket, -1));
+                Complete(operation, nullptr);
+            }
+            else if (operation.bExpectResponse)
+            {
+                SubmitReceive(operation);
+            }
+            break;
+
+        case SendSubmission:
+            if (result < 0)
+            {
+                Fail(operation, "Failed to send request to: " + operation.node.ipAddress);
+                break;
+            }
+            operation.sentSize += result;
+            if (operation.sentSize < operation.request.size())
+            {
+                SubmitSend(operation);
+            }
+            else if (!operation.bExpectResponse)
+            {
+                Complete(operation, nullptr);
+            }
+            break;
+
+        case ReceiveSubmission:
+            if (result == -EINVAL && m_bMultishot)
+            {
+                // Kernel without multishot receives
+                m_bMultishot = false;
+                SubmitReceive(operation);
+            }
+            else if (result == -ENOBUFS)
+            {
+                // Out of buffers ends a multishot receive, they are recycled as completions drain
+                SubmitReceive(operation);
+            }
+            else if (result < 0)
+            {
+                Fail(operation, "Failed to receive from: " + operation.node.ipAddress);
+            }
+            else if (result == 0 || !buffer)
+            {
+                Fail(
+                    operation,
+                    "Response did not contain header type: " +
+                        std::to_string((int)operation.responseType));
+            }
+            else
+            {
+                const size_t wantedSize = operation.receivedSize + result;
+                if (operation.received.size() < wantedSize)
+                {
+                    operation.received.resize(
+                        std::max(wantedSize, 2 * operation.received.size()));
+                }
+                memcpy(operation.received.data() + operation.receivedSize, buffer, result);
+                operation.receivedSize += result;
+
+                if (!ParseResponse(operation) && !bMore)
+                {
+                    SubmitReceive(operation);
+                }
+            }
+            break;
+
+        case CancelSubmission:
+            break;
+        }
+    }
+
+private:
+    /// The io_uring instance
+    int m_ring = -1;
+
+    /// Mapping of the submission and completion queue
+    char* m_rings = nullptr;
+
+    /// Size of `m_rings`
+    size_t m_ringsSize = 0;
+
+    /// Submission queue entries
+    io_uring_sqe* m_submissions = nullptr;
+
+    /// Size of `m_submissions`
+    size_t m_submissionsSize = 0;
+
+    /// Head of the submission queue, written by the kernel
+    unsigned int* m_submissionHead = nullptr;
+
+    /// Tail of the submission queue
+    unsigned int* m_submissionTail = nullptr;
+
+    /// Tail including the entries that haven't been published yet
+    unsigned int m_localSubmissionTail = 0;
+
+    /// Mask of the submission queue indices
+    unsigned int m_submissionMask = 0;
+
+    /// Number of submission queue entries
+    unsigned int m_submissionEntries = 0;
+
+    /// Number of entries that haven't been consumed by the kernel yet
+    unsigned int m_unsubmittedCount = 0;
+
+    /// Head of the completion queue
+    unsigned int* m_completionHead = nullptr;
+
+    /// Tail of the completion queue, written by the kernel
+    unsigned int* m_completionTail = nullptr;
+
+    /// Mask of the completion queue indices
+    unsigned int m_completionMask = 0;
+
+    /// Completion queue entries
+    io_uring_cqe* m_completions = nullptr;
+
+    /// Ring of free receive buffers, shared with the kernel
+    io_uring_buf_ring* m_bufferRing = nullptr;
+
+    /// Tail of `m_bufferRing`
+    unsigned short m_bufferTail = 0;
+
+    /// Memory of the receive buffers
+    std::vector<char> m_buffers;
+
+    /// Are multishot receives supported
+    bool m_bMultishot = true;
+
+    /// Event to wake up `Poll`
+    int m_wakeEvent = -1;
+
+    /// Target of the reads of `m_wakeEvent`
+    unsigned long long m_wakeValue = 0;
+
+    /// Completed requests with submissions in flight, by id
+    std::unordered_map<unsigned long long, std::unique_ptr<AsyncOperation>> m_released;
+};
+
+} // namespace
+
+// ------------------------------------------------------------------------------------------------
+std::unique_ptr<AsyncBackend> CreateIoUringBackend(AsyncEngine& engine)
+{
+    auto backend = std::make_unique<IoUringBackend>(engine);
+    if (!backend->Initialize())
+    {
+        return nullptr;
+    }
+    return backend;
+}
+
+#else
+
+// ------------------------------------------------------------------------------------------------
+std::unique_ptr<AsyncBackend> CreateIoUringBackend(AsyncEngine&) { return nullptr; }
+
+#endif
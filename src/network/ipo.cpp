@@ -0,0 +1,129 @@
+#include "network/ipo.hpp"
+
+#include <algorithm>
+#include <thread>
+
+// ------------------------------------------------------------------------------------------------
+tl::expected<RespondContractIPO, ConnectionError> GetContractIPO(
+    const ConnectionPtr& connection,
+    unsigned int contractIndex)
+{
+    // Construct request packet
+    struct
+    {
+        RequestResponseHeader header;
+        RequestContractIPO payload;
+    } packet;
+
+    // Init header
+    packet.header.setSize<sizeof(packet)>();
+    packet.header.randomizeDejavu();
+    packet.header.setType(RequestContractIPO::type);
+
+    // Init request
+    packet.payload.contractIndex = contractIndex;
+
+    // Send request
+    if (!connection->Send((char*)&packet, sizeof(packet)))
+    {
+        return tl::make_unexpected(ConnectionError{"Failed to send contract IPO request"});
+    }
+
+    // Receive response
+    return connection->ReceiveAs<RespondContractIPO>(RespondContractIPO::type);
+}
+
+// ------------------------------------------------------------------------------------------------
+long long GetMinimumWinningPrice(const RespondContractIPO& ipo)
+{
+    return *std::min_element(ipo.prices, ipo.prices + NUMBER_OF_COMPUTORS);
+}
+
+// ------------------------------------------------------------------------------------------------
+unsigned int GetWinningShareCount(const RespondContractIPO& ipo, const unsigned char* publicKey)
+{
+    unsigned int count = 0;
+    for (const auto& bidder : ipo.publicKeys)
+    {
+        count += memcmp(bidder.m256i_u8, publicKey, 32) == 0 ? 1 : 0;
+    }
+    return count;
+}
+
+// ------------------------------------------------------------------------------------------------
+tl::expected<Receipt, TransactionError> AddIPOBid(
+    TransactionBuilder& builder,
+    unsigned int contractIndex,
+    long long price,
+    unsigned short quantity,
+    unsigned int tick)
+{
+    if (price <= 0 || quantity == 0 || quantity > NUMBER_OF_COMPUTORS ||
+        price > (long long)(MAX_AMOUNT / quantity))
+    {
+        return tl::make_unexpected(TransactionError{
+            "Invalid IPO bid of " + std::to_string(quantity) + " shares at " +
+            std::to_string(price)});
+    }
+
+    // The contract reserves price times quantity itself, the transaction transfers nothing
+    ContractIPOBid bid;
+    memset(&bid, 0, sizeof(bid));
+    bid.price = price;
+    bid.quantity = quantity;
+    return builder.Add(GetContractIdentity(contractIndex), 0, tick, 0, bid);
+}
+
+// ------------------------------------------------------------------------------------------------
+tl::expected<Receipt, TransactionError> SubmitIPOBidAtTick(
+    const std::vector<NodeAddress>& nodes,
+    const SigningKeyPtr& signingKey,
+    const TickTracker& tickTracker,
+    unsigned int contractIndex,
+    long long price,
+    unsigned short quantity,
+    unsigned int tick,
+    unsigned int leadTicks,
+    std::chrono::milliseconds timeout)
+{
+    // Sign ahead of time, only the broadcast waits for the tick
+    TransactionBuilder builder(signingKey);
+    auto receipt = AddIPOBid(builder, contractIndex, price, quantity, tick);
+    if (!receipt.has_value())
+    {
+        return receipt;
+    }
+
+    const unsigned int broadcastTick = tick > leadTicks ? tick - leadTicks : 0;
+    while (true)
+    {
+        auto currentTick = tickTracker.GetTick();
+        if (!currentTick.has_value())
+        {
+            return tl::make_unexpected(TransactionError{currentTick.error().message});
+        }
+        if (currentTick.value() >= tick)
+        {
+            return tl::make_unexpected(TransactionError{
+                "Missed tick " + std::to_string(tick) + ", the current tick is " +
+                std::to_string(currentTick.value())});
+        }
+        if (currentTick.value() >= broadcastTick)
+        {
+            break;
+        }
+
+        // Wake up a few times per tick to catch the boundary
+        const double tickDuration = tickTracker.GetTickDuration();
+        std::this_thread::sleep_for(std::chrono::milliseconds(
+            tickDuration > 0.0 ? std::max((long long)(tickDuration / 10), 10LL) : 100LL));
+    }
+
+    auto result = builder.Broadcast(nodes, timeout);
+    if (!result.has_value())
+    {
+        return tl::make_unexpected(result.error());
+    }
+
+    return receipt;
+}
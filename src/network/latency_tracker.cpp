@@ -0,0 +1,48 @@
+#include "network/latency_tracker.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// ------------------------------------------------------------------------------------------------
+LatencyTracker::LatencyTracker(size_t maximumSamples)
+    : m_maximumSamples(std::max(maximumSamples, (size_t)1))
+{}
+
+// ------------------------------------------------------------------------------------------------
+void LatencyTracker::AddLatency(std::chrono::milliseconds latency)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_latencies.size() == m_maximumSamples)
+    {
+        m_latencies.pop_front();
+    }
+    m_latencies.push_back(latency);
+}
+
+// ------------------------------------------------------------------------------------------------
+std::optional<std::chrono::milliseconds> LatencyTracker::GetQuantile(double probability) const
+{
+    std::vector<std::chrono::milliseconds> sorted;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_latencies.empty())
+        {
+            return std::nullopt;
+        }
+        sorted.assign(m_latencies.begin(), m_latencies.end());
+    }
+
+    // Nearest rank, tolerating rounding errors of the product
+    const double rank = std::ceil(probability * (double)sorted.size() - 1e-9);
+    const auto index = std::min(sorted.size() - 1, (size_t)std::max(rank - 1.0, 0.0));
+    std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+    return sorted[index];
+}
+
+// ------------------------------------------------------------------------------------------------
+size_t LatencyTracker::GetSampleCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_latencies.size();
+}
@@ -0,0 +1,255 @@
+#include "network/node_registry.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// ------------------------------------------------------------------------------------------------
+namespace
+{
+/**
+ * Get the key of a node
+ * @param node The node
+ * @return The ip-address and port
+ */
+std::string GetKey(const NodeAddress& node)
+{
+    return node.ipAddress + ":" + std::to_string(node.port);
+}
+} // namespace
+
+// ------------------------------------------------------------------------------------------------
+void NodeRegistry::AddNode(const NodeAddress& node)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    GetEntry(node);
+}
+
+// ------------------------------------------------------------------------------------------------
+void NodeRegistry::AddNode(const NodeAddress& node, std::chrono::milliseconds roundTripTime)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_entries.find(GetKey(node)) == m_entries.end())
+    {
+        // Only ranks the node until it is called, it isn't a latency observed in this run
+        GetEntry(node).health.roundTripTime = std::max((double)roundTripTime.count(), 0.0);
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+void NodeRegistry::RemoveNode(const NodeAddress& node)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.erase(GetKey(node));
+}
+
+// ------------------------------------------------------------------------------------------------
+void NodeRegistry::ReportSuccess(const NodeAddress& node, std::chrono::milliseconds roundTripTime)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto& entry = GetEntry(node);
+    auto& health = entry.health;
+
+    const double milliseconds = (double)roundTripTime.count();
+    health.roundTripTime = health.roundTripTime > 0.0
+                               ? (1.0 - roundTripTimeWeight) * health.roundTripTime +
+                                     roundTripTimeWeight * milliseconds
+                               : std::max(milliseconds, 1.0);
+    health.errorRate *= 1.0 - errorRateWeight;
+    health.consecutiveFailures = 0;
+    health.lastSeen = Clock::now();
+    health.retryTime.reset();
+    entry.latencies.AddLatency(roundTripTime);
+    entry.backoff = minimumBackoff;
+}
+
+// ------------------------------------------------------------------------------------------------
+void NodeRegistry::ReportFailure(const NodeAddress& node)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto& entry = GetEntry(node);
+    auto& health = entry.health;
+
+    health.errorRate = (1.0 - errorRateWeight) * health.errorRate + errorRateWeight;
+    ++health.consecutiveFailures;
+
+    // Trips again if a call made once the backoff passed fails, failures of calls that were
+    // already in flight when it tripped don't count
+    const auto now = Clock::now();
+    if (health.consecutiveFailures >= failureThreshold &&
+        (!health.retryTime.has_value() || health.retryTime.value() <= now))
+    {
+        health.retryTime = now + entry.backoff;
+        entry.backoff = std::min(entry.backoff * 2, maximumBackoff);
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+void NodeRegistry::ReportTick(const NodeAddress& node, unsigned int tick)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto& health = GetEntry(node).health;
+    health.lastTick = std::max(health.lastTick, tick);
+    m_highestTick = std::max(m_highestTick, tick);
+}
+
+// ------------------------------------------------------------------------------------------------
+std::vector<NodeAddress> NodeRegistry::SelectNodes(size_t count) const
+{
+    std::vector<std::pair<double, NodeAddress>> closed;
+    std::vector<std::pair<Clock::time_point, NodeAddress>> retried;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const auto now = Clock::now();
+        for (const auto& [key, entry] : m_entries)
+        {
+            const auto health = GetHealth(entry);
+            if (health.retryTime.has_value())
+            {
+                if (health.retryTime.value() <= now)
+                {
+                    retried.emplace_back(health.retryTime.value(), health.node);
+                }
+                continue;
+            }
+
+            // The expected time of a call, stretched by its retries and by stale ticks
+            const double roundTripTime =
+                health.roundTripTime > 0.0 ? health.roundTripTime : unknownRoundTripTime;
+            const double score = roundTripTime * (1.0 + 4.0 * health.errorRate) +
+                                 tickLagPenalty * health.tickLag;
+            closed.emplace_back(score, health.node);
+        }
+    }
+
+    const auto byFirst = [](const auto& a, const auto& b) { return a.first < b.first; };
+    std::stable_sort(closed.begin(), closed.end(), byFirst);
+    std::stable_sort(retried.begin(), retried.end(), byFirst);
+
+    std::vector<NodeAddress> nodes;
+    for (const auto& [score, node] : closed)
+    {
+        nodes.push_back(node);
+    }
+    for (const auto& [time, node] : retried)
+    {
+        nodes.push_back(node);
+    }
+    if (nodes.size() > count)
+    {
+        nodes.resize(count);
+    }
+    return nodes;
+}
+
+// ------------------------------------------------------------------------------------------------
+std::chrono::milliseconds NodeRegistry::GetTimeout(const NodeAddress& node) const
+{
+    auto latency = GetLatency(node, timeoutQuantile);
+    if (!latency.has_value())
+    {
+        return defaultTimeout;
+    }
+    return std::clamp(
+        std::chrono::milliseconds((long long)std::ceil(timeoutFactor * latency->count())),
+        minimumTimeout,
+        defaultTimeout);
+}
+
+// ------------------------------------------------------------------------------------------------
+std::optional<std::chrono::milliseconds> NodeRegistry::GetLatency(
+    const NodeAddress& node,
+    double probability) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const auto it = m_entries.find(GetKey(node));
+    if (it == m_entries.end() || it->second.latencies.GetSampleCount() < minimumLatencyCount)
+    {
+        return std::nullopt;
+    }
+    return it->second.latencies.GetQuantile(probability);
+}
+
+// ------------------------------------------------------------------------------------------------
+std::vector<NodeHealth> NodeRegistry::GetHealth() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<NodeHealth> health;
+    health.reserve(m_entries.size());
+    for (const auto& [key, entry] : m_entries)
+    {
+        health.push_back(GetHealth(entry));
+    }
+    return health;
+}
+
+// ------------------------------------------------------------------------------------------------
+NodeRegistry::Entry& NodeRegistry::GetEntry(const NodeAddress& node)
+{
+    auto [it, bAdded] = m_entries.try_emplace(GetKey(node));
+    if (bAdded)
+    {
+        it->second.health.node = node;
+    }
+    return it->second;
+}
+
+// ------------------------------------------------------------------------------------------------
+NodeHealth NodeRegistry::GetHealth(const Entry& entry) const
+{
+    auto health = entry.health;
+    health.tickLag = health.lastTick > 0 ? m_highestTick - health.lastTick : 0;
+    return health;
+}
+
+// ------------------------------------------------------------------------------------------------
+tl::expected<ConnectionPtr, ConnectionError> CreateConnection(
+    NodeRegistry& registry,
+    const NodeAddress& node,
+    const Deadline& deadline)
+{
+    const auto start = NodeRegistry::Clock::now();
+    Deadline connectDeadline = deadline;
+    connectDeadline.time = std::min(deadline.time, start + registry.GetTimeout(node));
+
+    auto connection = CreateConnection(node.ipAddress, node.port, connectDeadline);
+    if (!connection.has_value())
+    {
+        // Not the fault of the node if the call itself ran out of time or was cancelled
+        if (deadline.Check().has_value())
+        {
+            registry.ReportFailure(node);
+        }
+        return connection;
+    }
+
+    // A connection is accepted after one round trip
+    registry.ReportSuccess(
+        node,
+        std::chrono::ceil<std::chrono::milliseconds>(NodeRegistry::Clock::now() - start));
+    connection.value()->SetDeadline(deadline);
+    return connection;
+}
+
+// ------------------------------------------------------------------------------------------------
+tl::expected<ConnectionPtr, ConnectionError> CreateConnection(
+    NodeRegistry& registry,
+    const Deadline& deadline)
+{
+    tl::expected<ConnectionPtr, ConnectionError> connection =
+        tl::make_unexpected(ConnectionError{"No node available"});
+    for (const auto& node : registry.SelectNodes())
+    {
+        auto stop = deadline.Check();
+        if (!stop.has_value())
+        {
+            return tl::make_unexpected(stop.error());
+        }
+
+        connection = CreateConnection(registry, node, deadline);
+        if (connection.has_value())
+        {
+            break;
+        }
+    }
+    return connection;
+}
@@ -0,0 +1,284 @@
+#include "network/peer_crawler.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <map>
+#include <sstream>
+
+#include "network/tick.hpp"
+
+// ------------------------------------------------------------------------------------------------
+namespace
+{
+/**
+ * Get the key of a node
+ * @param node The node
+ * @return The ip-address and port
+ */
+std::string GetKey(const NodeAddress& node)
+{
+    return node.ipAddress + ":" + std::to_string(node.port);
+}
+} // namespace
+
+// ------------------------------------------------------------------------------------------------
+PeerCrawler::PeerCrawler(
+    NodeRegistry& registry,
+    std::string tablePath,
+    std::chrono::milliseconds interval)
+    : m_registry(registry)
+    , m_tablePath(std::move(tablePath))
+    , m_interval(interval)
+{}
+
+// ------------------------------------------------------------------------------------------------
+PeerCrawler::~PeerCrawler()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_bStop = true;
+    }
+    m_token.Cancel();
+    m_condition.notify_all();
+
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+void PeerCrawler::Start()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_thread.joinable())
+    {
+        m_thread = std::thread(&PeerCrawler::Run, this);
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+size_t PeerCrawler::Crawl(const CancellationToken& token)
+{
+    std::set<std::string> known;
+    for (const auto& health : m_registry.GetHealth())
+    {
+        known.insert(GetKey(health.node));
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_discoveredMutex);
+        known.insert(m_dropped.begin(), m_dropped.end());
+    }
+
+    // Probe the selected nodes, then the peers they shared, until no new peers turn up
+    size_t addedCount = 0;
+    auto nodes = m_registry.SelectNodes();
+    while (!nodes.empty() && !token.IsCancelled())
+    {
+        // Probe all nodes at once, a slow node doesn't delay the others
+        std::vector<std::future<tl::expected<std::vector<NodeAddress>, ConnectionError>>> probes;
+        probes.reserve(nodes.size());
+        for (const auto& node : nodes)
+        {
+            probes.push_back(std::async(std::launch::async, [this, node, &token]() {
+                return Probe(node, Deadline::After(probeTimeout, token));
+            }));
+        }
+
+        std::vector<NodeAddress> peers;
+        for (auto& probe : probes)
+        {
+            auto shared = probe.get();
+            if (!shared.has_value())
+            {
+                continue;
+            }
+
+            for (const auto& peer : shared.value())
+            {
+                if (known.size() >= maximumNodeCount || !known.insert(GetKey(peer)).second)
+                {
+                    continue;
+                }
+
+                m_registry.AddNode(peer);
+                {
+                    std::lock_guard<std::mutex> lock(m_discoveredMutex);
+                    m_discovered.insert(GetKey(peer));
+                }
+                peers.push_back(peer);
+                ++addedCount;
+            }
+        }
+        nodes = std::move(peers);
+    }
+
+    DropDeadPeers();
+    if (!m_tablePath.empty() && !token.IsCancelled())
+    {
+        // The table is only a head start for the next run, a failed write costs nothing else
+        SavePeerTable(m_registry, m_tablePath);
+    }
+    return addedCount;
+}
+
+// ------------------------------------------------------------------------------------------------
+tl::expected<std::vector<NodeAddress>, ConnectionError> PeerCrawler::Probe(
+    const NodeAddress& node,
+    const Deadline& deadline)
+{
+    auto connection = CreateConnection(m_registry, node, deadline);
+    if (!connection.has_value())
+    {
+        return tl::make_unexpected(connection.error());
+    }
+
+    // Sent right after accepting, a node that shares no peers is still probed for its tick
+    std::vector<NodeAddress> peers;
+    auto shared = connection.value()->ReceiveView<ExchangePublicPeers>(ExchangePublicPeers::type);
+    if (shared.has_value())
+    {
+        peers = GetPeerNodes(*shared.value(), node.port);
+    }
+
+    auto info = GetCurrentTickInfo(connection.value());
+    if (!info.has_value())
+    {
+        // Not the fault of the node if the probe itself ran out of time or was cancelled
+        if (deadline.Check().has_value())
+        {
+            m_registry.ReportFailure(node);
+        }
+        return tl::make_unexpected(info.error());
+    }
+    m_registry.ReportTick(node, info->tick);
+    return peers;
+}
+
+// ------------------------------------------------------------------------------------------------
+void PeerCrawler::Run()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_bStop)
+    {
+        const auto next = Clock::now() + m_interval;
+        lock.unlock();
+
+        Crawl(m_token);
+
+        lock.lock();
+        m_condition.wait_until(lock, next, [this] { return m_bStop; });
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+void PeerCrawler::DropDeadPeers()
+{
+    std::lock_guard<std::mutex> lock(m_discoveredMutex);
+    for (const auto& health : m_registry.GetHealth())
+    {
+        const auto key = GetKey(health.node);
+        if (!health.lastSeen.has_value() && health.retryTime.has_value() &&
+            m_discovered.erase(key) > 0)
+        {
+            m_registry.RemoveNode(health.node);
+            m_dropped.insert(key);
+        }
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+std::vector<NodeAddress> GetPeerNodes(const ExchangePublicPeers& peers, unsigned short port)
+{
+    std::vector<NodeAddress> nodes;
+    for (const auto& peer : peers.peers)
+    {
+        if (peer.u32 == 0)
+        {
+            continue;
+        }
+        nodes.push_back(
+            {std::to_string(peer.u8[0]) + "." + std::to_string(peer.u8[1]) + "." +
+                 std::to_string(peer.u8[2]) + "." + std::to_string(peer.u8[3]),
+             port});
+    }
+    return nodes;
+}
+
+// ------------------------------------------------------------------------------------------------
+tl::expected<size_t, ConnectionError> SavePeerTable(
+    const NodeRegistry& registry,
+    const std::string& path,
+    size_t count)
+{
+    std::map<std::string, double> roundTripTimes;
+    for (const auto& health : registry.GetHealth())
+    {
+        roundTripTimes[GetKey(health.node)] = health.roundTripTime;
+    }
+
+    // Replaced at once, so that an interrupted write never leaves half a table
+    const std::string temporaryPath = path + ".tmp";
+    const auto nodes = registry.SelectNodes(count);
+    {
+        std::ofstream file(temporaryPath, std::ios::trunc);
+        if (!file)
+        {
+            return tl::make_unexpected(
+                ConnectionError{"Failed to open " + temporaryPath + " for writing"});
+        }
+
+        for (const auto& node : nodes)
+        {
+            file << node.ipAddress << " " << node.port << " "
+                 << (long long)roundTripTimes[GetKey(node)] << "\n";
+        }
+        if (!file)
+        {
+            return tl::make_unexpected(ConnectionError{"Failed to write " + temporaryPath});
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, path, error);
+    if (error)
+    {
+        return tl::make_unexpected(ConnectionError{"Failed to replace " + path});
+    }
+    return nodes.size();
+}
+
+// ------------------------------------------------------------------------------------------------
+tl::expected<size_t, ConnectionError> LoadPeerTable(
+    NodeRegistry& registry,
+    const std::string& path)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        return tl::make_unexpected(ConnectionError{"Failed to open " + path});
+    }
+
+    size_t count = 0;
+    std::string line;
+    while (std::getline(file, line))
+    {
+        std::istringstream stream(line);
+        std::string ipAddress;
+        unsigned int port = 0;
+        long long roundTripTime = 0;
+        if (!(stream >> ipAddress >> port >> roundTripTime) || !IsValidIp(ipAddress) ||
+            port == 0 || port > 65535)
+        {
+            continue;
+        }
+
+        registry.AddNode(
+            {ipAddress, (unsigned short)port},
+            std::chrono::milliseconds(std::max(roundTripTime, 0LL)));
+        ++count;
+    }
+    return count;
+}
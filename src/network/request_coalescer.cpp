@@ -0,0 +1,8 @@
+#include "network/request_coalescer.hpp"
+
+// ------------------------------------------------------------------------------------------------
+size_t RequestCoalescer::GetInFlightCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_flights.size();
+}
@@ -0,0 +1,131 @@
+#include "network/send_to_many.hpp"
+
+#include "core/four_q.h"
+#include "network/tick.hpp"
+
+// ------------------------------------------------------------------------------------------------
+std::string GetQutilIdentity() { return GetContractIdentity(qutilContractIndex); }
+
+// ------------------------------------------------------------------------------------------------
+size_t GetSendToManyCallCount(size_t transferCount)
+{
+    return (transferCount + sendToManyMaxRecipients - 1) / sendToManyMaxRecipients;
+}
+
+// ------------------------------------------------------------------------------------------------
+long long GetSendToManyCost(const std::vector<Transfer>& transfers)
+{
+    long long cost = (long long)GetSendToManyCallCount(transfers.size()) * sendToManyFee;
+    for (const auto& transfer : transfers)
+    {
+        cost += transfer.amount;
+    }
+    return cost;
+}
+
+// ------------------------------------------------------------------------------------------------
+tl::expected<std::vector<Receipt>, TransactionError> AddSendToMany(
+    TransactionBuilder& builder,
+    const std::vector<Transfer>& transfers,
+    unsigned int tick)
+{
+    if (transfers.empty())
+    {
+        return tl::make_unexpected(TransactionError{"No transfers to pay out"});
+    }
+
+    // Validate every transfer before adding anything
+    std::vector<SendToManyInput> inputs(GetSendToManyCallCount(transfers.size()));
+    std::vector<long long> amounts(inputs.size(), sendToManyFee);
+    for (size_t i = 0; i < transfers.size(); ++i)
+    {
+        const auto& transfer = transfers[i];
+        auto& input = inputs[i / sendToManyMaxRecipients];
+        const auto slot = i % sendToManyMaxRecipients;
+        if (slot == 0)
+        {
+            memset(&input, 0, sizeof(input));
+        }
+
+        if (!getPublicKeyFromIdentity(
+                (const unsigned char*)transfer.recipient.data(),
+                input.publicKeys[slot]))
+        {
+            return tl::make_unexpected(TransactionError{
+                "Failed to compute public key from identity: " + transfer.recipient});
+        }
+        if (transfer.amount <= 0 || transfer.amount > MAX_AMOUNT)
+        {
+            return tl::make_unexpected(
+                TransactionError{"Invalid transfer amount: " + std::to_string(transfer.amount)});
+        }
+        input.amounts[slot] = transfer.amount;
+
+        auto& amount = amounts[i / sendToManyMaxRecipients];
+        amount += transfer.amount;
+        if (amount > MAX_AMOUNT)
+        {
+            return tl::make_unexpected(
+                TransactionError{"Total amount of a call exceeds " + std::to_string(MAX_AMOUNT)});
+        }
+    }
+
+    const auto contract = GetQutilIdentity();
+    std::vector<Receipt> receipts;
+    receipts.reserve(inputs.size());
+    for (size_t i = 0; i < inputs.size(); ++i)
+    {
+        auto receipt = builder.Add(
+            contract,
+            amounts[i],
+            tick + (unsigned int)i,
+            sendToManyInputType,
+            inputs[i]);
+        if (!receipt.has_value())
+        {
+            return tl::make_unexpected(receipt.error());
+        }
+        receipts.push_back(std::move(receipt.value()));
+    }
+
+    return receipts;
+}
+
+// ------------------------------------------------------------------------------------------------
+tl::expected<std::vector<Receipt>, TransactionError> BroadcastSendToMany(
+    const ConnectionPtr& connection,
+    const SigningKeyPtr& signingKey,
+    const std::vector<Transfer>& transfers,
+    unsigned int tickOffset)
+{
+    // Get current tick
+    unsigned int tick = 0;
+    {
+        auto response = GetTick(connection);
+        if (response.has_value())
+        {
+            tick = response.value();
+        }
+        else
+        {
+            return tl::make_unexpected(TransactionError{response.error().message});
+        }
+    }
+
+    // Create transactions
+    TransactionBuilder builder(signingKey);
+    auto receipts = AddSendToMany(builder, transfers, tick + tickOffset);
+    if (!receipts.has_value())
+    {
+        return tl::make_unexpected(receipts.error());
+    }
+
+    // Broadcast transactions
+    auto result = builder.Broadcast(connection);
+    if (!result.has_value())
+    {
+        return tl::make_unexpected(result.error());
+    }
+
+    return receipts;
+}
@@ -0,0 +1,214 @@
+#include "network/async_backend.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+// ------------------------------------------------------------------------------------------------
+namespace
+{
+
+/**
+ * Result of a request thread
+ */
+struct ThreadResult
+{
+    /// Id of the request
+    unsigned long long id = 0;
+
+    /// Response frame, empty if no response was expected
+    tl::expected<std::vector<char>, ConnectionError> frame;
+
+    /// The connection of a request that only connects
+    ConnectionPtr connection;
+};
+
+/**
+ * Results handed from the request threads to the engine thread, shared so that the request
+ * threads may outlive the backend
+ */
+struct ThreadResults
+{
+    /// Results of the finished requests
+    std::vector<ThreadResult> results;
+
+    /// Has `Poll` been woken up
+    bool bWoken = false;
+
+    /// Guard for the results
+    std::mutex mutex;
+
+    /// Signals new results
+    std::condition_variable condition;
+};
+
+/**
+ * Run a request on a blocking connection
+ * @param node The node
+ * @param request The packets to send
+ * @param responseType The header type of the response
+ * @param bExpectResponse Should a response be received
+ * @param bConnectOnly Should the connection be kept instead of sending the request
+ * @param deadline The deadline and cancellation token of the request
+ * @param kept Receives the connection if `bConnectOnly` is true
+ * @return A copy of the response frame, or the error that occurred
+ */
+tl::expected<std::vector<char>, ConnectionError> RunRequest(
+    const NodeAddress& node,
+    std::vector<char>& request,
+    unsigned char responseType,
+    bool bExpectResponse,
+    bool bConnectOnly,
+    const Deadline& deadline,
+    ConnectionPtr& kept)
+{
+    auto connection = CreateConnection(node.ipAddress, node.port, deadline);
+    if (!connection.has_value())
+    {
+        return tl::make_unexpected(connection.error());
+    }
+    if (bConnectOnly)
+    {
+        // The deadline was for connecting only
+        connection.value()->SetDeadline({});
+        kept = std::move(connection.value());
+        return std::vector<char>();
+    }
+
+    // Rounded up, so that the deadline rather than the timeout ends the receive
+    connection.value()->SetTimeout(
+        std::chrono::ceil<std::chrono::milliseconds>(deadline.time - Deadline::Clock::now()));
+    if (!connection.value()->Send(request.data(), (int)request.size()))
+    {
+        return tl::make_unexpected(ConnectionError{"Failed to send request to: " + node.ipAddress});
+    }
+    if (!bExpectResponse)
+    {
+        return std::vector<char>();
+    }
+
+    auto frame = connection.value()->ReceiveFrame(responseType);
+    if (!frame.has_value())
+    {
+        return tl::make_unexpected(frame.error());
+    }
+
+    RequestResponseHeader header;
+    memcpy(&header, frame.value(), sizeof(header));
+    return std::vector<char>(frame.value(), frame.value() + header.size());
+}
+
+/**
+ * Runs every request on its own thread with a blocking `Connection`
+ */
+class ThreadBackend : public AsyncBackend
+{
+public:
+    /**
+     * Constructor
+     * @param engine The engine that owns the backend
+     */
+    explicit ThreadBackend(AsyncEngine& engine)
+        : AsyncBackend(engine)
+        , m_results(std::make_shared<ThreadResults>())
+    {}
+
+    void Start(AsyncOperation& operation) override
+    {
+        // The thread stops at the deadline of the engine, or once the request is cancelled
+        std::thread(
+            [results = m_results,
+             id = operation.id,
+             node = operation.node,
+             request = operation.request,
+             responseType = operation.responseType,
+             bExpectResponse = operation.bExpectResponse,
+             bConnectOnly = operation.bConnectOnly,
+             deadline = Deadline{operation.deadline, operation.token}]() mutable {
+                ThreadResult result;
+                result.id = id;
+                result.frame = RunRequest(
+                    node,
+                    request,
+                    responseType,
+                    bExpectResponse,
+                    bConnectOnly,
+                    deadline,
+                    result.connection);
+
+                std::lock_guard<std::mutex> lock(results->mutex);
+                results->results.push_back(std::move(result));
+                results->condition.notify_one();
+            })
+            .detach();
+    }
+
+    void Poll(std::chrono::milliseconds timeout) override
+    {
+        std::vector<ThreadResult> results;
+        {
+            std::unique_lock<std::mutex> lock(m_results->mutex);
+            const auto bReady = [this]() {
+                return !m_results->results.empty() || m_results->bWoken;
+            };
+            if (timeout.count() < 0)
+            {
+                m_results->condition.wait(lock, bReady);
+            }
+            else
+            {
+                m_results->condition.wait_for(lock, timeout, bReady);
+            }
+            m_results->bWoken = false;
+            results.swap(m_results->results);
+        }
+
+        for (auto& result : results)
+        {
+            // Timed out meanwhile
+            auto* operation = FindOperation(result.id);
+            if (!operation)
+            {
+                continue;
+            }
+
+            // Stopped by the deadline or the token, which the engine reports itself
+            const bool bStopped = operation->deadline <= std::chrono::steady_clock::now() ||
+                                  operation->token.IsCancelled();
+            if (!result.frame.has_value() && bStopped)
+            {
+                continue;
+            }
+            if (!result.frame.has_value())
+            {
+                Complete(*operation, tl::make_unexpected(result.frame.error()));
+                continue;
+            }
+            operation->connection = std::move(result.connection);
+            operation->received = std::move(result.frame.value());
+            operation->receivedSize = operation->received.size();
+            Complete(*operation, operation->bExpectResponse ? operation->received.data() : nullptr);
+        }
+    }
+
+    void Wake() override
+    {
+        std::lock_guard<std::mutex> lock(m_results->mutex);
+        m_results->bWoken = true;
+        m_results->condition.notify_one();
+    }
+
+private:
+    /// Results of the request threads
+    std::shared_ptr<ThreadResults> m_results;
+};
+
+} // namespace
+
+// ------------------------------------------------------------------------------------------------
+std::unique_ptr<AsyncBackend> CreateThreadBackend(AsyncEngine& engine)
+{
+    return std::make_unique<ThreadBackend>(engine);
+}
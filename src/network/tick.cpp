@@ -5,9 +5,15 @@
 #include "core/four_q.h"
 
 // ------------------------------------------------------------------------------------------------
-tl::expected<CurrentTickInfo, ConnectionError> GetCurrentTickInfo(const ConnectionPtr& connection)
+namespace
+{
+
+/**
+ * Create the packet of a current tick info request
+ * @return The packet
+ */
+std::vector<char> CreateCurrentTickInfoRequest()
 {
-    // construct request packet
     struct
     {
         RequestResponseHeader header;
@@ -16,13 +22,112 @@ tl::expected<CurrentTickInfo, ConnectionError> GetCurrentTickInfo(const Connecti
     packet.header.randomizeDejavu();
     packet.header.setType(REQUEST_CURRENT_TICK_INFO);
 
+    return std::vector<char>((const char*)&packet, (const char*)&packet + sizeof(packet));
+}
+
+/**
+ * Create the packet of a tick data request
+ * @param tick The tick to request
+ * @return The packet
+ */
+std::vector<char> CreateTickDataRequest(unsigned int tick)
+{
+    // Construct request packet
+    struct
+    {
+        RequestResponseHeader header;
+        RequestTickData payload;
+    } packet;
+
+    // Init header
+    packet.header.setSize<sizeof(packet)>();
+    packet.header.randomizeDejavu();
+    packet.header.setType(packet.payload.type);
+
+    // Init request tick data
+    packet.payload.requestedTickData.tick = tick;
+
+    return std::vector<char>((const char*)&packet, (const char*)&packet + sizeof(packet));
+}
+
+} // namespace
+
+// ------------------------------------------------------------------------------------------------
+tl::expected<CurrentTickInfo, ConnectionError> GetCurrentTickInfo(const ConnectionPtr& connection)
+{
     // send request
-    connection->Send((char*)&packet, sizeof(packet));
+    auto request = CreateCurrentTickInfoRequest();
+    connection->Send(request.data(), (int)request.size());
 
     // receive response
     return connection->ReceiveAs<CurrentTickInfo>(RESPOND_CURRENT_TICK_INFO);
 }
 
+// ------------------------------------------------------------------------------------------------
+tl::expected<CurrentTickInfo, ConnectionError> GetCurrentTickInfo(
+    RequestCoalescer& coalescer,
+    NodeRegistry& registry,
+    const Deadline& deadline)
+{
+    return coalescer.Run<CurrentTickInfo>(
+        {REQUEST_CURRENT_TICK_INFO, {}},
+        [&]() -> tl::expected<CurrentTickInfo, ConnectionError> {
+            auto connection = CreateConnection(registry, deadline);
+            if (!connection.has_value())
+            {
+                return tl::make_unexpected(connection.error());
+            }
+            return GetCurrentTickInfo(connection.value());
+        });
+}
+
+// ------------------------------------------------------------------------------------------------
+void GetCurrentTickInfoAsync(
+    AsyncEngine& engine,
+    const NodeAddress& node,
+    AsyncCallback<CurrentTickInfo> callback,
+    std::chrono::milliseconds timeout,
+    CancellationToken token)
+{
+    engine.RequestAs<CurrentTickInfo>(
+        node,
+        CreateCurrentTickInfoRequest(),
+        RESPOND_CURRENT_TICK_INFO,
+        timeout,
+        std::move(callback),
+        std::move(token));
+}
+
+// ------------------------------------------------------------------------------------------------
+void GetCurrentTickInfoAsync(
+    RequestHedger& hedger,
+    const std::vector<NodeAddress>& nodes,
+    AsyncCallback<CurrentTickInfo> callback,
+    std::chrono::milliseconds timeout,
+    CancellationToken token)
+{
+    hedger.RequestAs<CurrentTickInfo>(
+        nodes,
+        CreateCurrentTickInfoRequest(),
+        RESPOND_CURRENT_TICK_INFO,
+        timeout,
+        std::move(callback),
+        std::move(token));
+}
+
+// ------------------------------------------------------------------------------------------------
+Task<tl::expected<CurrentTickInfo, ConnectionError>> GetCurrentTickInfoTask(
+    AsyncEngine& engine,
+    NodeAddress node,
+    std::chrono::milliseconds timeout,
+    CancellationToken token)
+{
+    co_return co_await CallbackAwaitable<tl::expected<CurrentTickInfo, ConnectionError>>(
+        [&](AsyncCallback<CurrentTickInfo> callback) {
+            GetCurrentTickInfoAsync(engine, node, std::move(callback), timeout, token);
+        });
+}
+
 // ------------------------------------------------------------------------------------------------
 tl::expected<unsigned short, ConnectionError> GetTickDuration(const ConnectionPtr& connection)
 {
@@ -56,6 +161,20 @@ tl::expected<unsigned int, ConnectionError> GetTick(const ConnectionPtr& connect
     return tl::make_unexpected(info.error());
 }
 
+// ------------------------------------------------------------------------------------------------
+tl::expected<unsigned int, ConnectionError> GetTick(
+    RequestCoalescer& coalescer,
+    NodeRegistry& registry,
+    const Deadline& deadline)
+{
+    auto info = GetCurrentTickInfo(coalescer, registry, deadline);
+    if (info)
+    {
+        return info->tick;
+    }
+    return tl::make_unexpected(info.error());
+}
+
 // ------------------------------------------------------------------------------------------------
 tl::expected<unsigned short, ConnectionError> GetNumberOfAlignedVotes(
     const ConnectionPtr& connection)
@@ -96,26 +215,75 @@ tl::expected<BroadcastFutureTickData, ConnectionError> GetTickData(
     const ConnectionPtr& connection,
     unsigned int tick)
 {
-    // Construct request packet
-    struct
+    auto view = GetTickDataView(connection, tick);
+    if (view)
     {
-        RequestResponseHeader header;
-        RequestTickData payload;
-    } packet;
-
-    // Init header
-    packet.header.setSize<sizeof(packet)>();
-    packet.header.randomizeDejavu();
-    packet.header.setType(packet.payload.type);
-
-    // Init request tick data
-    packet.payload.requestedTickData.tick = tick;
+        return *view.value();
+    }
+    return tl::make_unexpected(view.error());
+}
 
+// ------------------------------------------------------------------------------------------------
+tl::expected<const BroadcastFutureTickData*, ConnectionError> GetTickDataView(
+    const ConnectionPtr& connection,
+    unsigned int tick)
+{
     // Send request
-    connection->Send((char*)&packet, sizeof(packet));
+    auto request = CreateTickDataRequest(tick);
+    connection->Send(request.data(), (int)request.size());
 
     // Receive response
-    return connection->ReceiveAs<BroadcastFutureTickData>(BroadcastFutureTickData::type);
+    return connection->ReceiveView<BroadcastFutureTickData>(BroadcastFutureTickData::type);
+}
+
+// ------------------------------------------------------------------------------------------------
+void GetTickDataAsync(
+    AsyncEngine& engine,
+    const NodeAddress& node,
+    unsigned int tick,
+    AsyncCallback<BroadcastFutureTickData> callback,
+    std::chrono::milliseconds timeout,
+    CancellationToken token)
+{
+    engine.RequestAs<BroadcastFutureTickData>(
+        node,
+        CreateTickDataRequest(tick),
+        BroadcastFutureTickData::type,
+        timeout,
+        std::move(callback),
+        std::move(token));
+}
+
+// ------------------------------------------------------------------------------------------------
+void GetTickDataAsync(
+    RequestHedger& hedger,
+    const std::vector<NodeAddress>& nodes,
+    unsigned int tick,
+    AsyncCallback<BroadcastFutureTickData> callback,
+    std::chrono::milliseconds timeout,
+    CancellationToken token)
+{
+    hedger.RequestAs<BroadcastFutureTickData>(
+        nodes,
+        CreateTickDataRequest(tick),
+        BroadcastFutureTickData::type,
+        timeout,
+        std::move(callback),
+        std::move(token));
+}
+
+// ------------------------------------------------------------------------------------------------
+Task<tl::expected<BroadcastFutureTickData, ConnectionError>> GetTickDataTask(
+    AsyncEngine& engine,
+    NodeAddress node,
+    unsigned int tick,
+    std::chrono::milliseconds timeout,
+    CancellationToken token)
+{
+    co_return co_await CallbackAwaitable<tl::expected<BroadcastFutureTickData, ConnectionError>>(
+        [&](AsyncCallback<BroadcastFutureTickData> callback) {
+            GetTickDataAsync(engine, node, tick, std::move(callback), timeout, token);
+        });
 }
 
 // ------------------------------------------------------------------------------------------------
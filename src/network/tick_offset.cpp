@@ -0,0 +1,127 @@
+#include "network/tick_offset.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+// ------------------------------------------------------------------------------------------------
+/**
+ * Get a quantile of samples
+ * @param samples The samples, not empty
+ * @param probability The probability in [0, 1]
+ * @return The smallest sample that is not exceeded with the given probability
+ */
+double Quantile(const std::deque<double>& samples, double probability)
+{
+    std::vector<double> sorted(samples.begin(), samples.end());
+    const auto index = std::min(
+        sorted.size() - 1,
+        (size_t)std::ceil(probability * (double)sorted.size() - 1.0 + 1e-9));
+    std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+    return sorted[index];
+}
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Add a sample, removing the oldest if the window is full
+ * @param samples The samples
+ * @param sample The sample to add
+ * @param maximumSamples The size of the window
+ */
+template <typename T>
+void AddSample(std::deque<T>& samples, T sample, size_t maximumSamples)
+{
+    if (samples.size() == maximumSamples)
+    {
+        samples.pop_front();
+    }
+    samples.push_back(sample);
+}
+} // namespace
+
+// ------------------------------------------------------------------------------------------------
+TickOffsetEstimator::TickOffsetEstimator(double targetInclusion)
+    : m_targetInclusion(std::min(std::max(targetInclusion, 0.5), 0.999))
+{}
+
+// ------------------------------------------------------------------------------------------------
+void TickOffsetEstimator::AddTickDuration(unsigned int milliseconds)
+{
+    if (milliseconds == 0)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    AddSample(m_tickDurations, (double)milliseconds, maximumSamples);
+}
+
+// ------------------------------------------------------------------------------------------------
+void TickOffsetEstimator::AddLatency(double milliseconds)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    AddSample(m_latencies, std::max(milliseconds, 0.0), maximumSamples);
+}
+
+// ------------------------------------------------------------------------------------------------
+void TickOffsetEstimator::AddOutcome(unsigned int offset, bool bIncluded)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    AddSample(m_outcomes, std::make_pair(offset, bIncluded), maximumOutcomes);
+}
+
+// ------------------------------------------------------------------------------------------------
+unsigned int TickOffsetEstimator::GetTickOffset() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    unsigned int offset = defaultOffset;
+    if (!m_tickDurations.empty())
+    {
+        // The current tick may be about to end when it is read, so the latency has to fit in the
+        // ticks after it
+        const double tickDuration = Quantile(m_tickDurations, 1.0 - m_targetInclusion);
+        const double latency = m_latencies.empty() ? 0.0 : Quantile(m_latencies, m_targetInclusion);
+        const double ticks = std::ceil(latency / tickDuration);
+        offset = (unsigned int)std::min(ticks + minimumOffset, (double)maximumOffset);
+    }
+
+    // Correct the model with what actually happened
+    double rate = 0.0;
+    while (offset < maximumOffset && GetInclusionRate(offset, rate) && rate < m_targetInclusion)
+    {
+        ++offset;
+    }
+    while (offset > minimumOffset && GetInclusionRate(offset - 1, rate) &&
+           rate >= m_targetInclusion)
+    {
+        --offset;
+    }
+
+    return offset;
+}
+
+// ------------------------------------------------------------------------------------------------
+bool TickOffsetEstimator::GetInclusionRate(unsigned int offset, double& rate) const
+{
+    size_t count = 0;
+    size_t included = 0;
+    for (const auto& outcome : m_outcomes)
+    {
+        if (outcome.first == offset)
+        {
+            ++count;
+            included += outcome.second ? 1 : 0;
+        }
+    }
+
+    if (count < minimumOutcomes)
+    {
+        return false;
+    }
+
+    rate = (double)included / (double)count;
+    return true;
+}
@@ -0,0 +1,112 @@
+#include "network/tick_slot_allocator.hpp"
+
+#include <algorithm>
+
+// ------------------------------------------------------------------------------------------------
+TickSlotAllocator::TickSlotAllocator(std::vector<SigningKeyPtr> sources)
+{
+    m_sources.reserve(sources.size());
+    for (auto& source : sources)
+    {
+        m_sources.push_back(Source{std::move(source), 0, 0});
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+bool TickSlotAllocator::SetBalance(const std::string& identity, long long balance)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto* source = FindSource(identity);
+    if (!source)
+    {
+        return false;
+    }
+
+    source->balance = balance;
+    return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+long long TickSlotAllocator::GetBalance(const std::string& identity) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto& source : m_sources)
+    {
+        if (source.key->GetIdentity() == identity)
+        {
+            return source.balance;
+        }
+    }
+    return 0;
+}
+
+// ------------------------------------------------------------------------------------------------
+tl::expected<TickSlot, TickSlotError> TickSlotAllocator::Allocate(
+    long long amount,
+    unsigned int minimumTick)
+{
+    if (amount < 0)
+    {
+        return tl::make_unexpected(TickSlotError{"Invalid amount: " + std::to_string(amount)});
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // Earliest tick first, on a tie prefer the largest balance to drain the pool evenly
+    Source* best = nullptr;
+    unsigned int bestTick = 0;
+    for (auto& source : m_sources)
+    {
+        if (source.balance < amount)
+        {
+            continue;
+        }
+
+        const auto tick = std::max(source.nextTick, minimumTick);
+        if (!best || tick < bestTick || (tick == bestTick && source.balance > best->balance))
+        {
+            best = &source;
+            bestTick = tick;
+        }
+    }
+
+    if (!best)
+    {
+        return tl::make_unexpected(
+            TickSlotError{"No source wallet can afford " + std::to_string(amount)});
+    }
+
+    best->balance -= amount;
+    best->nextTick = bestTick + 1;
+    return TickSlot{best->key, bestTick};
+}
+
+// ------------------------------------------------------------------------------------------------
+void TickSlotAllocator::Release(const TickSlot& slot, long long amount)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto& source : m_sources)
+    {
+        if (source.key == slot.source)
+        {
+            source.balance += amount;
+            return;
+        }
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+size_t TickSlotAllocator::GetSourceCount() const { return m_sources.size(); }
+
+// ------------------------------------------------------------------------------------------------
+TickSlotAllocator::Source* TickSlotAllocator::FindSource(const std::string& identity)
+{
+    for (auto& source : m_sources)
+    {
+        if (source.key->GetIdentity() == identity)
+        {
+            return &source;
+        }
+    }
+    return nullptr;
+}
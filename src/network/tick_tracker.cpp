@@ -0,0 +1,173 @@
+#include "network/tick_tracker.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <future>
+
+#include "network/tick.hpp"
+
+// ------------------------------------------------------------------------------------------------
+TickTracker::TickTracker(std::chrono::milliseconds interval)
+    : m_interval(interval)
+{}
+
+// ------------------------------------------------------------------------------------------------
+TickTracker::~TickTracker()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_bStop = true;
+    }
+    m_condition.notify_all();
+
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+void TickTracker::SetNodes(std::vector<NodeAddress> nodes)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_nodes = std::move(nodes);
+
+    if (!m_thread.joinable())
+    {
+        m_thread = std::thread(&TickTracker::Run, this);
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+void TickTracker::SetRegistry(NodeRegistry& registry)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_registry = &registry;
+
+    if (!m_thread.joinable())
+    {
+        m_thread = std::thread(&TickTracker::Run, this);
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+void TickTracker::AddSample(const CurrentTickInfo& info, Clock::time_point time)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (info.tickDuration > 0)
+    {
+        m_tickDuration = m_tickDuration > 0.0 ? (1.0 - tickDurationWeight) * m_tickDuration +
+                                                    tickDurationWeight * info.tickDuration
+                                              : info.tickDuration;
+    }
+
+    if (!m_bHasSample || info.tick > m_info.tick)
+    {
+        // The tick started after the previous tick was last seen, and before now
+        m_tickStart = m_bHasSample && m_lastSeen < time ? m_lastSeen + (time - m_lastSeen) / 2
+                                                        : time;
+        m_lastSeen = time;
+        m_info = info;
+        m_bHasSample = true;
+    }
+    else if (info.tick == m_info.tick)
+    {
+        m_lastSeen = std::max(m_lastSeen, time);
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+tl::expected<unsigned int, ConnectionError> TickTracker::GetTick() const
+{
+    return PredictTick(Clock::now());
+}
+
+// ------------------------------------------------------------------------------------------------
+tl::expected<unsigned int, ConnectionError> TickTracker::PredictTick(Clock::time_point time) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_bHasSample)
+    {
+        return tl::make_unexpected(ConnectionError{"No tick has been sampled yet"});
+    }
+
+    if (m_tickDuration <= 0.0 || time <= m_tickStart)
+    {
+        return m_info.tick;
+    }
+
+    const double elapsed =
+        std::chrono::duration<double, std::milli>(time - m_tickStart).count();
+    const double ticks = std::floor(elapsed / m_tickDuration);
+    return m_info.tick + (unsigned int)std::min(ticks, (double)maximumPredictedTicks);
+}
+
+// ------------------------------------------------------------------------------------------------
+tl::expected<CurrentTickInfo, ConnectionError> TickTracker::GetTickInfo() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_bHasSample)
+    {
+        return tl::make_unexpected(ConnectionError{"No tick has been sampled yet"});
+    }
+    return m_info;
+}
+
+// ------------------------------------------------------------------------------------------------
+double TickTracker::GetTickDuration() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_tickDuration;
+}
+
+// ------------------------------------------------------------------------------------------------
+void TickTracker::Run()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_bStop)
+    {
+        auto* registry = m_registry;
+        const auto nodes = registry ? registry->SelectNodes() : m_nodes;
+        const auto next = Clock::now() + m_interval;
+        lock.unlock();
+
+        // Query all nodes at once, a slow node doesn't delay the others
+        std::vector<std::future<void>> samples;
+        samples.reserve(nodes.size());
+        for (const auto& node : nodes)
+        {
+            samples.push_back(std::async(std::launch::async, [this, registry, node]() {
+                auto connection = registry ? CreateConnection(*registry, node)
+                                           : CreateConnection(node.ipAddress, node.port);
+                if (!connection.has_value())
+                {
+                    return;
+                }
+
+                // The node answers with the tick at the time the request arrives
+                const auto time = Clock::now();
+                auto info = GetCurrentTickInfo(connection.value());
+                if (info.has_value())
+                {
+                    AddSample(info.value(), time);
+                }
+                if (registry && info.has_value())
+                {
+                    registry->ReportTick(node, info->tick);
+                }
+                else if (registry)
+                {
+                    registry->ReportFailure(node);
+                }
+            }));
+        }
+        for (auto& sample : samples)
+        {
+            sample.wait();
+        }
+
+        lock.lock();
+        m_condition.wait_until(lock, next, [this] { return m_bStop; });
+    }
+}
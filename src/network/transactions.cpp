@@ -1,8 +1,167 @@
 #include "network/transactions.hpp"
 
+#include <algorithm>
+#include <thread>
+
 #include "core/four_q.h"
 #include "network/tick.hpp"
-#include "network_messages/transactions.h"
+
+// ------------------------------------------------------------------------------------------------
+namespace
+{
+
+/// Transfers per thread below which another thread doesn't pay off
+constexpr size_t minimumTransfersPerThread = 64;
+
+/// Transfers whose digests are signed together, a multiple of four for the 4-way signing
+constexpr size_t signingGroupSize = 64;
+
+/**
+ * Absorb a transaction and its input, and compute the digest to sign
+ * @param transaction The transaction followed by its input
+ * @param size The size of the transaction and its input in bytes
+ * @param state The hash state, kept to hash the signed transaction without absorbing it again
+ * @param digest The 32-byte digest
+ */
+void HashTransaction(
+    const unsigned char* transaction,
+    unsigned int size,
+    KangarooTwelve_F& state,
+    unsigned char* digest)
+{
+    setMem(&state, sizeof(state), 0);
+    KangarooTwelve_F_Absorb(&state, transaction, size);
+
+    KangarooTwelve_F final = state;
+    KangarooTwelve_F_Final(&final, digest, 32);
+}
+
+/**
+ * Complete the hash of a transaction started by `HashTransaction` with its signature
+ * @param state The hash state of the transaction and its input
+ * @param signature The signature of the transaction
+ * @return The transaction hash as shown to users
+ */
+std::string HashSignedTransaction(KangarooTwelve_F& state, const unsigned char* signature)
+{
+    unsigned char digest[32];
+    KangarooTwelve_F_Absorb(&state, signature, SIGNATURE_SIZE);
+    KangarooTwelve_F_Final(&state, digest, 32);
+
+    char hash[61] = "";
+    getIdentity(digest, hash, true);
+    return hash;
+}
+
+/**
+ * Sign a range of transfers into preallocated packets and receipts
+ * @param signingKey The signing key of the sender
+ * @param transfers All transfers
+ * @param tick The tick at which the transactions should be executed
+ * @param begin The first transfer of the range
+ * @param end One past the last transfer of the range
+ * @param packets The packets of all transfers
+ * @param receipts The receipts of all transfers
+ * @return An empty string upon success, else the error message
+ */
+std::string SignTransactionRange(
+    const SigningKey& signingKey,
+    const std::vector<Transfer>& transfers,
+    unsigned int tick,
+    size_t begin,
+    size_t end,
+    TransactionPacket* packets,
+    Receipt* receipts)
+{
+    KangarooTwelve_F states[signingGroupSize];
+    unsigned char digests[signingGroupSize][32];
+    unsigned char signatures[signingGroupSize][SIGNATURE_SIZE];
+
+    for (size_t group = begin; group < end; group += signingGroupSize)
+    {
+        const size_t count = std::min(signingGroupSize, end - group);
+
+        for (size_t i = 0; i < count; i++)
+        {
+            const Transfer& transfer = transfers[group + i];
+            TransactionPacket& packet = packets[group + i];
+
+            unsigned char recipientPublicKey[32];
+            if (!getPublicKeyFromIdentity(
+                    (const unsigned char*)transfer.recipient.data(),
+                    recipientPublicKey))
+            {
+                return "Failed to compute public key from identity: " + transfer.recipient;
+            }
+
+            packet.header.setSize<sizeof(TransactionPacket)>();
+            packet.header.setDejavu(0);
+            packet.header.setType(BROADCAST_TRANSACTION);
+
+            memcpy((void*)&packet.transaction.sourcePublicKey, signingKey.GetPublicKey(), 32);
+            memcpy((void*)&packet.transaction.destinationPublicKey, recipientPublicKey, 32);
+            packet.transaction.amount = transfer.amount;
+            packet.transaction.tick = tick;
+            packet.transaction.inputType = 0;
+            packet.transaction.inputSize = 0;
+            HashTransaction(
+                (const unsigned char*)&packet.transaction,
+                sizeof(packet.transaction),
+                states[i],
+                digests[i]);
+        }
+
+        signingKey.Sign(digests[0], (unsigned int)count, signatures[0]);
+
+        for (size_t i = 0; i < count; i++)
+        {
+            const Transfer& transfer = transfers[group + i];
+            TransactionPacket& packet = packets[group + i];
+            memcpy(packet.signature, signatures[i], SIGNATURE_SIZE);
+
+            receipts[group + i] = Receipt{
+                signingKey.GetIdentity(),
+                transfer.recipient,
+                HashSignedTransaction(states[i], signatures[i]),
+                transfer.amount,
+                tick,
+                Receipt::Confirming};
+        }
+    }
+
+    return "";
+}
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Send packets to multiple nodes
+ * @param nodes The nodes to send to
+ * @param data The packets
+ * @param size The size of the packets in bytes
+ * @param timeout The maximum time to connect, and the maximum time to send, per node
+ * @return The outcome of each node if any node accepted the packets, else an error
+ */
+tl::expected<std::vector<NodeBroadcastResult>, TransactionError> BroadcastPackets(
+    const std::vector<NodeAddress>& nodes,
+    const char* data,
+    size_t size,
+    std::chrono::milliseconds timeout)
+{
+    auto results = BroadcastToNodes(nodes, data, size, timeout);
+    for (const auto& result : results)
+    {
+        if (result.bAccepted)
+        {
+            return results;
+        }
+    }
+
+    return tl::make_unexpected(TransactionError{
+        "No node accepted the transactions" +
+        (results.empty() ? std::string() : ": " + results.front().error)});
+}
+} // namespace
+// ------------------------------------------------------------------------------------------------
 
 // ------------------------------------------------------------------------------------------------
 std::string StatusToString(Receipt::Status status)
@@ -19,29 +178,26 @@ std::string StatusToString(Receipt::Status status)
     return "failed";
 }
 
+// ------------------------------------------------------------------------------------------------
+std::string GetContractIdentity(unsigned int contractIndex)
+{
+    unsigned char publicKey[32] = {0};
+    *(unsigned long long*)publicKey = contractIndex;
+
+    char identity[61] = {0};
+    getIdentity(publicKey, identity, false);
+    return identity;
+}
+
 // ------------------------------------------------------------------------------------------------
 tl::expected<Receipt, TransactionError> BroadcastTransaction(
     const ConnectionPtr& connection,
-    const Wallet& wallet,
+    const SigningKey& signingKey,
     const std::string& recipient,
     long long amount,
     unsigned int tickOffset)
 {
-    // Compute public keys from identity
-    uint8_t subseed[32] = {0};
-    if (!getSubseed((const unsigned char*)wallet.seed.data(), subseed))
-    {
-        return tl::make_unexpected(
-            TransactionError{"Failed to compute subseed from seed: " + wallet.seed});
-    }
-
-    unsigned char senderPublicKey[32];
-    if (!getPublicKeyFromIdentity((const unsigned char*)wallet.identity.data(), senderPublicKey))
-    {
-        return tl::make_unexpected(
-            TransactionError{"Failed to compute public key from identity: " + wallet.identity});
-    }
-
+    // Validate recipient before querying the node
     unsigned char recipientPublicKey[32];
     if (!getPublicKeyFromIdentity((const unsigned char*)recipient.data(), recipientPublicKey))
     {
@@ -63,58 +219,349 @@ tl::expected<Receipt, TransactionError> BroadcastTransaction(
         }
     }
 
+    return BroadcastTransactionAtTick(connection, signingKey, recipient, amount, tick + tickOffset);
+}
+
+// ------------------------------------------------------------------------------------------------
+tl::expected<Receipt, TransactionError> BroadcastTransactionAtTick(
+    const ConnectionPtr& connection,
+    const SigningKey& signingKey,
+    const std::string& recipient,
+    long long amount,
+    unsigned int tick)
+{
     // Create transaction
-    struct
-    {
-        RequestResponseHeader header;
-        Transaction transaction;
-        unsigned char signature[64];
-    } packet;
-
-    // Init header
-    packet.header.setSize<sizeof(packet.header) + sizeof(packet.transaction) + 64>();
-    packet.header.setDejavu(0);
-    packet.header.setType(BROADCAST_TRANSACTION);
-
-    // Init transaction
-    memcpy((void*)&packet.transaction.sourcePublicKey, senderPublicKey, 32);
-    memcpy((void*)&packet.transaction.destinationPublicKey, recipientPublicKey, 32);
-    packet.transaction.amount = amount;
-    packet.transaction.tick = tick + tickOffset;
-    packet.transaction.inputType = 0;
-    packet.transaction.inputSize = 0;
-    unsigned char digest[32] = {0};
-    KangarooTwelve((unsigned char*)&packet.transaction, sizeof(packet.transaction), digest, 32);
-
-    // Init signature
-    unsigned char signature[64] = {0};
-    sign(subseed, senderPublicKey, digest, signature);
-    memcpy(packet.signature, signature, 64);
+    auto transactions = SignTransactions(signingKey, {{recipient, amount}}, tick, 1);
+    if (!transactions.has_value())
+    {
+        return tl::make_unexpected(transactions.error());
+    }
 
     // Broadcast transaction
-    if (!connection->Send((char*)&packet, packet.header.size()))
+    auto result = BroadcastTransactions(connection, transactions.value());
+    if (!result.has_value())
+    {
+        return tl::make_unexpected(result.error());
+    }
+
+    return transactions->receipts.front();
+}
+
+// ------------------------------------------------------------------------------------------------
+void BroadcastTransactionAsync(
+    AsyncEngine& engine,
+    const NodeAddress& node,
+    SigningKeyPtr signingKey,
+    const std::string& recipient,
+    long long amount,
+    unsigned int tickOffset,
+    std::function<void(tl::expected<Receipt, TransactionError>)> callback,
+    std::chrono::milliseconds timeout,
+    CancellationToken token)
+{
+    // Validate recipient before querying the node
+    unsigned char recipientPublicKey[32];
+    if (!getPublicKeyFromIdentity((const unsigned char*)recipient.data(), recipientPublicKey))
+    {
+        callback(tl::make_unexpected(
+            TransactionError{"Failed to compute public key from identity: " + recipient}));
+        return;
+    }
+
+    // Sign once the current tick is known, a single signature is cheap enough for the engine
+    GetCurrentTickInfoAsync(
+        engine,
+        node,
+        [&engine, node, signingKey, recipient, amount, tickOffset, callback, timeout, token](
+            tl::expected<CurrentTickInfo, ConnectionError> info) {
+            if (!info.has_value())
+            {
+                callback(tl::make_unexpected(TransactionError{info.error().message}));
+                return;
+            }
+
+            auto transactions =
+                SignTransactions(*signingKey, {{recipient, amount}}, info->tick + tickOffset, 1);
+            if (!transactions.has_value())
+            {
+                callback(tl::make_unexpected(transactions.error()));
+                return;
+            }
+
+            const auto* packets = (const char*)transactions->packets.data();
+            engine.Request(
+                node,
+                std::vector<char>(packets, packets + sizeof(TransactionPacket)),
+                0,
+                false,
+                timeout,
+                [receipt = transactions->receipts.front(),
+                 callback](tl::expected<const char*, ConnectionError> result) {
+                    if (!result.has_value())
+                    {
+                        callback(tl::make_unexpected(TransactionError{result.error().message}));
+                        return;
+                    }
+                    callback(receipt);
+                },
+                token);
+        },
+        timeout,
+        token);
+}
+
+// ------------------------------------------------------------------------------------------------
+Task<tl::expected<Receipt, TransactionError>> BroadcastTransactionTask(
+    AsyncEngine& engine,
+    NodeAddress node,
+    SigningKeyPtr signingKey,
+    std::string recipient,
+    long long amount,
+    unsigned int tickOffset,
+    std::chrono::milliseconds timeout,
+    CancellationToken token)
+{
+    // Validate recipient before querying the node
+    unsigned char recipientPublicKey[32];
+    if (!getPublicKeyFromIdentity((const unsigned char*)recipient.data(), recipientPublicKey))
+    {
+        co_return tl::make_unexpected(
+            TransactionError{"Failed to compute public key from identity: " + recipient});
+    }
+
+    auto info = co_await GetCurrentTickInfoTask(engine, node, timeout, token);
+    if (!info.has_value())
+    {
+        co_return tl::make_unexpected(TransactionError{info.error().message});
+    }
+
+    // Resumed on the engine thread, a single signature is cheap enough for it
+    auto transactions =
+        SignTransactions(*signingKey, {{recipient, amount}}, info->tick + tickOffset, 1);
+    if (!transactions.has_value())
+    {
+        co_return tl::make_unexpected(transactions.error());
+    }
+
+    const auto* packets = (const char*)transactions->packets.data();
+    auto sent = co_await CallbackAwaitable<tl::expected<const char*, ConnectionError>>(
+        [&](RequestCallback callback) {
+            engine.Request(
+                node,
+                std::vector<char>(packets, packets + sizeof(TransactionPacket)),
+                0,
+                false,
+                timeout,
+                std::move(callback),
+                token);
+        });
+    if (!sent.has_value())
+    {
+        co_return tl::make_unexpected(TransactionError{sent.error().message});
+    }
+    co_return transactions->receipts.front();
+}
+
+// ------------------------------------------------------------------------------------------------
+tl::expected<SignedTransactions, TransactionError> SignTransactions(
+    const SigningKey& signingKey,
+    const std::vector<Transfer>& transfers,
+    unsigned int tick,
+    unsigned int threadCount)
+{
+    SignedTransactions transactions;
+    transactions.packets.resize(transfers.size());
+    transactions.receipts.resize(transfers.size());
+
+    if (threadCount == 0)
+    {
+        threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    const size_t usefulThreadCount =
+        (transfers.size() + minimumTransfersPerThread - 1) / minimumTransfersPerThread;
+    threadCount =
+        (unsigned int)std::max<size_t>(std::min<size_t>(threadCount, usefulThreadCount), 1);
+
+    // Split in ranges of whole signing groups, the last thread signs on the calling thread
+    const size_t groupCount = (transfers.size() + signingGroupSize - 1) / signingGroupSize;
+    const size_t groupsPerThread = (groupCount + threadCount - 1) / threadCount;
+    std::vector<std::string> errors(threadCount);
+    std::vector<std::thread> threads;
+    for (unsigned int i = 0; i < threadCount; i++)
+    {
+        const size_t begin = std::min(i * groupsPerThread * signingGroupSize, transfers.size());
+        const size_t end = std::min((i + 1) * groupsPerThread * signingGroupSize, transfers.size());
+        auto sign = [&, i, begin, end]() {
+            errors[i] = SignTransactionRange(
+                signingKey,
+                transfers,
+                tick,
+                begin,
+                end,
+                transactions.packets.data(),
+                transactions.receipts.data());
+        };
+
+        if (i + 1 < threadCount)
+        {
+            threads.emplace_back(sign);
+        }
+        else
+        {
+            sign();
+        }
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    for (const auto& error : errors)
+    {
+        if (!error.empty())
+        {
+            return tl::make_unexpected(TransactionError{error});
+        }
+    }
+
+    return transactions;
+}
+
+// ------------------------------------------------------------------------------------------------
+tl::expected<bool, TransactionError> BroadcastTransactions(
+    const ConnectionPtr& connection,
+    const SignedTransactions& transactions)
+{
+    if (!connection->Send(
+            (char*)transactions.packets.data(),
+            (int)(transactions.packets.size() * sizeof(TransactionPacket))))
     {
         // todo: maybe interesting to log ip+port, but that is not stored in connection
         return tl::make_unexpected(TransactionError{"Failed to send transaction to the network"});
     }
 
-    // Recompute digest for transaction hash
-    KangarooTwelve(
-        (unsigned char*)&packet.transaction,
-        sizeof(packet.transaction) + 64,
-        digest,
-        32);
+    return true;
+}
 
-    // Compute transaction hash
-    char hash[61] = "";
-    getIdentity(digest, hash, true);
+// ------------------------------------------------------------------------------------------------
+tl::expected<std::vector<NodeBroadcastResult>, TransactionError> BroadcastTransactions(
+    const std::vector<NodeAddress>& nodes,
+    const SignedTransactions& transactions,
+    std::chrono::milliseconds timeout)
+{
+    return BroadcastPackets(
+        nodes,
+        (const char*)transactions.packets.data(),
+        transactions.packets.size() * sizeof(TransactionPacket),
+        timeout);
+}
 
-    // Return receipt
-    return Receipt{
-        wallet.identity,
+// ------------------------------------------------------------------------------------------------
+TransactionBuilder::TransactionBuilder(SigningKeyPtr signingKey)
+    : m_signingKey(std::move(signingKey))
+{}
+
+// ------------------------------------------------------------------------------------------------
+tl::expected<Receipt, TransactionError> TransactionBuilder::Add(
+    const std::string& recipient,
+    long long amount,
+    unsigned int tick,
+    unsigned short inputType,
+    const void* input,
+    unsigned short inputSize)
+{
+    if (inputSize > MAX_INPUT_SIZE || (inputSize && !input))
+    {
+        return tl::make_unexpected(
+            TransactionError{"Invalid transaction input size: " + std::to_string(inputSize)});
+    }
+
+    Transaction transaction;
+    if (!getPublicKeyFromIdentity(
+            (const unsigned char*)recipient.data(),
+            transaction.destinationPublicKey.m256i_u8))
+    {
+        return tl::make_unexpected(
+            TransactionError{"Failed to compute public key from identity: " + recipient});
+    }
+    memcpy(transaction.sourcePublicKey.m256i_u8, m_signingKey->GetPublicKey(), 32);
+    transaction.amount = amount;
+    transaction.tick = tick;
+    transaction.inputType = inputType;
+    transaction.inputSize = inputSize;
+    if (!transaction.checkValidity())
+    {
+        return tl::make_unexpected(
+            TransactionError{"Invalid transaction amount: " + std::to_string(amount)});
+    }
+
+    // Write the packet straight into the arena, packets are not aligned so only copy into it
+    RequestResponseHeader header;
+    const unsigned int packetSize = sizeof(header) + transaction.totalSize();
+    header.checkAndSetSize(packetSize);
+    header.setDejavu(0);
+    header.setType(BROADCAST_TRANSACTION);
+
+    const size_t offset = m_buffer.size();
+    m_buffer.resize(offset + packetSize);
+    auto* packet = (unsigned char*)m_buffer.data() + offset;
+    auto* signature = packet + packetSize - SIGNATURE_SIZE;
+    memcpy(packet, &header, sizeof(header));
+    memcpy(packet + sizeof(header), &transaction, sizeof(transaction));
+    if (inputSize)
+    {
+        memcpy(packet + sizeof(header) + sizeof(transaction), input, inputSize);
+    }
+
+    // One pass over the transaction and input for both the digest and the hash
+    KangarooTwelve_F state;
+    unsigned char digest[32];
+    HashTransaction(packet + sizeof(header), sizeof(transaction) + inputSize, state, digest);
+    m_signingKey->Sign(digest, signature);
+
+    m_receipts.push_back(Receipt{
+        m_signingKey->GetIdentity(),
         recipient,
-        hash,
+        HashSignedTransaction(state, signature),
         amount,
-        tick + tickOffset,
-        Receipt::Confirming};
+        tick,
+        Receipt::Confirming});
+
+    return m_receipts.back();
+}
+
+// ------------------------------------------------------------------------------------------------
+const char* TransactionBuilder::GetData() const { return m_buffer.data(); }
+
+// ------------------------------------------------------------------------------------------------
+size_t TransactionBuilder::GetSize() const { return m_buffer.size(); }
+
+// ------------------------------------------------------------------------------------------------
+const std::vector<Receipt>& TransactionBuilder::GetReceipts() const { return m_receipts; }
+
+// ------------------------------------------------------------------------------------------------
+void TransactionBuilder::Clear()
+{
+    m_buffer.clear();
+    m_receipts.clear();
+}
+
+// ------------------------------------------------------------------------------------------------
+tl::expected<bool, TransactionError> TransactionBuilder::Broadcast(
+    const ConnectionPtr& connection) const
+{
+    if (!connection->Send((char*)m_buffer.data(), (int)m_buffer.size()))
+    {
+        return tl::make_unexpected(TransactionError{"Failed to send transaction to the network"});
+    }
+
+    return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+tl::expected<std::vector<NodeBroadcastResult>, TransactionError> TransactionBuilder::Broadcast(
+    const std::vector<NodeAddress>& nodes,
+    std::chrono::milliseconds timeout) const
+{
+    return BroadcastPackets(nodes, m_buffer.data(), m_buffer.size(), timeout);
 }
@@ -0,0 +1,154 @@
+#include "network/transfer_retrier.hpp"
+
+#include <algorithm>
+
+// ------------------------------------------------------------------------------------------------
+TransferRetrier::TransferRetrier(size_t maximumAttempts)
+    : m_maximumAttempts(std::max(maximumAttempts, (size_t)1))
+{}
+
+// ------------------------------------------------------------------------------------------------
+tl::expected<bool, TransactionError> TransferRetrier::Track(
+    const std::string& key,
+    SigningKeyPtr signingKey,
+    const Receipt& receipt)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto& lineage = m_lineages[key];
+    for (const auto& attempt : lineage.attempts)
+    {
+        if (attempt.status != Receipt::Failed)
+        {
+            return tl::make_unexpected(TransactionError{
+                "Transfer " + key + " already has an attempt that did not fail: " + attempt.hash});
+        }
+    }
+    if (lineage.attempts.size() >= m_maximumAttempts)
+    {
+        return tl::make_unexpected(
+            TransactionError{"Transfer " + key + " has no attempts left"});
+    }
+
+    lineage.signingKey = std::move(signingKey);
+    lineage.attempts.push_back(receipt);
+    m_keys[receipt.hash] = key;
+    return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+bool TransferRetrier::CanBroadcast(const std::string& key) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    const auto it = m_lineages.find(key);
+    if (it == m_lineages.end())
+    {
+        return true;
+    }
+
+    const auto& attempts = it->second.attempts;
+    return attempts.size() < m_maximumAttempts &&
+           std::all_of(attempts.begin(), attempts.end(), [](const Receipt& attempt) {
+               return attempt.status == Receipt::Failed;
+           });
+}
+
+// ------------------------------------------------------------------------------------------------
+tl::expected<RetryRequest, TransactionError> TransferRetrier::Confirm(const Receipt& receipt)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    const auto key = m_keys.find(receipt.hash);
+    if (key == m_keys.end())
+    {
+        return tl::make_unexpected(TransactionError{"Unknown transaction: " + receipt.hash});
+    }
+
+    auto& lineage = m_lineages[key->second];
+    for (auto& attempt : lineage.attempts)
+    {
+        if (attempt.hash == receipt.hash)
+        {
+            attempt.status = receipt.status;
+        }
+    }
+
+    if (receipt.status != Receipt::Failed)
+    {
+        return tl::make_unexpected(TransactionError{"Transaction did not fail: " + receipt.hash});
+    }
+    if (lineage.attempts.back().hash != receipt.hash)
+    {
+        return tl::make_unexpected(
+            TransactionError{"Transaction was retried already: " + receipt.hash});
+    }
+    if (lineage.attempts.size() >= m_maximumAttempts)
+    {
+        return tl::make_unexpected(
+            TransactionError{"Transfer " + key->second + " has no attempts left"});
+    }
+
+    return RetryRequest{
+        key->second,
+        lineage.signingKey,
+        Transfer{receipt.recipient, receipt.amount},
+        lineage.attempts.size()};
+}
+
+// ------------------------------------------------------------------------------------------------
+tl::expected<Receipt, TransactionError> TransferRetrier::Retry(
+    const ConnectionPtr& connection,
+    const RetryRequest& request,
+    unsigned int tick)
+{
+    if (!CanBroadcast(request.key))
+    {
+        return tl::make_unexpected(
+            TransactionError{"Transfer " + request.key + " can't be retried"});
+    }
+
+    auto transactions = SignTransactions(*request.signingKey, {request.transfer}, tick, 1);
+    if (!transactions.has_value())
+    {
+        return tl::make_unexpected(transactions.error());
+    }
+
+    // Claim the attempt before broadcasting, so concurrent retries of a key can't both be sent
+    const auto& receipt = transactions->receipts.front();
+    auto tracked = Track(request.key, request.signingKey, receipt);
+    if (!tracked.has_value())
+    {
+        return tl::make_unexpected(tracked.error());
+    }
+
+    auto result = BroadcastTransactions(connection, transactions.value());
+    if (!result.has_value())
+    {
+        // Never sent, so this attempt can't be executed either
+        Receipt failed = receipt;
+        failed.status = Receipt::Failed;
+        Confirm(failed);
+        return tl::make_unexpected(result.error());
+    }
+
+    return receipt;
+}
+
+// ------------------------------------------------------------------------------------------------
+std::vector<Receipt> TransferRetrier::GetAttempts(const std::string& key) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    const auto it = m_lineages.find(key);
+    return it != m_lineages.end() ? it->second.attempts : std::vector<Receipt>{};
+}
+
+// ------------------------------------------------------------------------------------------------
+std::string TransferRetrier::GetKey(const std::string& hash) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    const auto it = m_keys.find(hash);
+    return it != m_keys.end() ? it->second : std::string{};
+}
@@ -7,6 +7,7 @@
 #include <iostream>
 
 #include "core/four_q.h"
+#include "crypto/fixed_base_table.hpp"
 
 // ------------------------------------------------------------------------------------------------
 bool IsValidSeed(std::string& outErrorMessage, const std::string& seed)
@@ -72,7 +73,7 @@ tl::expected<Wallet, WalletError> GenerateWallet(const std::string& seed)
 
     getSubseed((const uint8_t*)seed.data(), subseed);
     getPrivateKey(subseed, privateKey);
-    getPublicKey(privateKey, publicKey);
+    ComputePublicKey(privateKey, publicKey);
 
     getIdentity(privateKey, privateKeyAscii, true);
     getIdentity(publicKey, publicKeyAscii, true);
@@ -87,34 +88,45 @@ Wallet GenerateWallet() { return GenerateWallet(GenerateSeed()).value(); }
 // ------------------------------------------------------------------------------------------------
 bool GenerateWalletWithPrefix(Wallet& out_wallet, const std::string& prefix)
 {
-    auto seed = GenerateSeed();
+    // candidates per attempt, a multiple of four so the 4-way public key generation can be used
+    constexpr unsigned int candidateCount = 4;
 
-    uint8_t privateKey[32] = {0};
-    uint8_t publicKey[32] = {0};
+    std::string seeds[candidateCount];
+    uint8_t privateKeys[candidateCount][32] = {0};
+    uint8_t publicKeys[candidateCount][32] = {0};
     uint8_t subseed[32] = {0};
 
-    getSubseed((const uint8_t*)seed.data(), subseed);
-    getPrivateKey(subseed, privateKey);
-    getPublicKey(privateKey, publicKey);
-
-    char publicIdentity[61] = {0};
-    getIdentity(publicKey, publicIdentity, false);
-
-    // check prefix
-    if (memcmp(publicIdentity, prefix.c_str(), prefix.length()) != 0)
+    for (unsigned int i = 0; i < candidateCount; i++)
     {
-        return false;
+        seeds[i] = GenerateSeed();
+        getSubseed((const uint8_t*)seeds[i].data(), subseed);
+        getPrivateKey(subseed, privateKeys[i]);
     }
+    ComputePublicKeys(privateKeys[0], publicKeys[0], candidateCount);
 
-    // compute other identities
-    char privateKeyAscii[61] = {0};
-    char publicKeyAscii[61] = {0};
-    getIdentity(privateKey, privateKeyAscii, true);
-    getIdentity(publicKey, publicKeyAscii, true);
+    for (unsigned int i = 0; i < candidateCount; i++)
+    {
+        char publicIdentity[61] = {0};
+        getIdentity(publicKeys[i], publicIdentity, false);
 
-    out_wallet = Wallet{seed, publicKeyAscii, privateKeyAscii, publicIdentity};
+        // check prefix
+        if (memcmp(publicIdentity, prefix.c_str(), prefix.length()) != 0)
+        {
+            continue;
+        }
 
-    return true;
+        // compute other identities
+        char privateKeyAscii[61] = {0};
+        char publicKeyAscii[61] = {0};
+        getIdentity(privateKeys[i], privateKeyAscii, true);
+        getIdentity(publicKeys[i], publicKeyAscii, true);
+
+        out_wallet = Wallet{seeds[i], publicKeyAscii, privateKeyAscii, publicIdentity};
+
+        return true;
+    }
+
+    return false;
 }
 
 // ------------------------------------------------------------------------------------------------
@@ -0,0 +1,358 @@
+#include <catch.hpp>
+
+#include "network/async_engine.hpp"
+#include "network/entity.hpp"
+#include "network/tick.hpp"
+
+#ifndef _MSC_VER
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <set>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace
+{
+// ------------------------------------------------------------------------------------------------
+/**
+ * Answer tick info requests of any number of clients, one after the other, after a frame of
+ * another type
+ */
+class TickInfoServer
+{
+public:
+    /**
+     * Constructor, listens on an ephemeral loopback port
+     * @param bRespond `false` to accept clients without ever responding
+     * @param skippedSize The payload size of the frame before the response
+     */
+    explicit TickInfoServer(bool bRespond, unsigned int skippedSize = 0)
+    {
+        m_listener = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bind(m_listener, (const sockaddr*)&address, sizeof(address));
+        listen(m_listener, 512);
+
+        socklen_t length = sizeof(address);
+        getsockname(m_listener, (sockaddr*)&address, &length);
+        m_port = ntohs(address.sin_port);
+
+        m_thread = std::thread([this, bRespond, skippedSize]() {
+            std::vector<char> skipped(sizeof(RequestResponseHeader) + skippedSize);
+            RequestResponseHeader skippedHeader;
+            skippedHeader.checkAndSetSize((unsigned int)skipped.size());
+            skippedHeader.setType(1);
+            memcpy(skipped.data(), &skippedHeader, sizeof(skippedHeader));
+
+            std::vector<int> clients;
+            for (unsigned int tick = 1;; ++tick)
+            {
+                int client = accept(m_listener, nullptr, nullptr);
+                if (client < 0)
+                {
+                    break;
+                }
+                clients.push_back(client);
+
+                RequestResponseHeader request;
+                if (!bRespond || recv(client, &request, sizeof(request), MSG_WAITALL) <= 0)
+                {
+                    continue;
+                }
+
+                struct
+                {
+                    RequestResponseHeader header;
+                    CurrentTickInfo info;
+                } response{};
+                response.header.setSize<sizeof(response)>();
+                response.header.setType(RESPOND_CURRENT_TICK_INFO);
+                response.info.tick = tick;
+                send(client, skipped.data(), skipped.size(), MSG_NOSIGNAL);
+                send(client, &response, sizeof(response), MSG_NOSIGNAL);
+            }
+            for (int client : clients)
+            {
+                close(client);
+            }
+        });
+    }
+
+    /**
+     * Destructor
+     */
+    ~TickInfoServer()
+    {
+        shutdown(m_listener, SHUT_RDWR);
+        m_thread.join();
+        close(m_listener);
+    }
+
+    /**
+     * Get the node address
+     * @return The address of the server
+     */
+    NodeAddress GetNode() const { return {"127.0.0.1", m_port}; }
+
+private:
+    int m_listener;
+    unsigned short m_port;
+    std::thread m_thread;
+};
+} // namespace
+
+// ------------------------------------------------------------------------------------------------
+TEST_CASE("Asynchronous requests", "[AsyncEngine]")
+{
+    const auto backend = GENERATE(
+        AsyncEngineBackend::Threads,
+        AsyncEngineBackend::Epoll,
+        AsyncEngineBackend::IoUring);
+
+    SECTION("The preferred backend or a less efficient one is used")
+    {
+        AsyncEngine engine(backend);
+        REQUIRE(engine.GetBackend() <= backend);
+#ifdef __linux__
+        if (backend != AsyncEngineBackend::Threads)
+        {
+            REQUIRE(engine.GetBackend() != AsyncEngineBackend::Threads);
+        }
+#endif
+    }
+
+    SECTION("Many requests are in flight at once")
+    {
+        // the skipped frames take many receives
+        TickInfoServer server(true, 20000);
+        AsyncEngine engine(backend);
+
+        constexpr size_t requestCount = 200;
+        std::vector<std::future<tl::expected<CurrentTickInfo, ConnectionError>>> futures;
+        for (size_t i = 0; i < requestCount; ++i)
+        {
+            auto promise =
+                std::make_shared<std::promise<tl::expected<CurrentTickInfo, ConnectionError>>>();
+            futures.push_back(promise->get_future());
+            GetCurrentTickInfoAsync(engine, server.GetNode(), FulfillPromise(promise));
+        }
+
+        std::set<unsigned int> ticks;
+        for (auto& future : futures)
+        {
+            auto info = future.get();
+            REQUIRE(info.has_value());
+            ticks.insert(info->tick);
+        }
+
+        // every request got its own response
+        REQUIRE(ticks.size() == requestCount);
+        REQUIRE(engine.GetPendingCount() == 0);
+    }
+
+    SECTION("Requests time out")
+    {
+        TickInfoServer server(false);
+        AsyncEngine engine(backend);
+
+        auto promise =
+            std::make_shared<std::promise<tl::expected<CurrentTickInfo, ConnectionError>>>();
+        auto future = promise->get_future();
+        const auto start = std::chrono::steady_clock::now();
+        GetCurrentTickInfoAsync(
+            engine,
+            server.GetNode(),
+            FulfillPromise(promise),
+            std::chrono::milliseconds(100));
+
+        auto info = future.get();
+        REQUIRE_FALSE(info.has_value());
+        REQUIRE(info.error().message == "Request timed out: 127.0.0.1");
+        REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(900));
+    }
+
+    SECTION("Requests are cancelled")
+    {
+        TickInfoServer server(false);
+        AsyncEngine engine(backend);
+
+        CancellationToken token;
+        auto promise =
+            std::make_shared<std::promise<tl::expected<CurrentTickInfo, ConnectionError>>>();
+        auto future = promise->get_future();
+        const auto start = std::chrono::steady_clock::now();
+        GetCurrentTickInfoAsync(
+            engine,
+            server.GetNode(),
+            FulfillPromise(promise),
+            std::chrono::seconds(10),
+            token);
+        token.Cancel();
+
+        auto info = future.get();
+        REQUIRE_FALSE(info.has_value());
+        REQUIRE(info.error().message == "Request cancelled: 127.0.0.1");
+        REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(900));
+        REQUIRE(engine.GetPendingCount() == 0);
+    }
+
+    SECTION("Functions run after their delay")
+    {
+        AsyncEngine engine(backend);
+
+        std::promise<std::chrono::steady_clock::duration> ran;
+        CancellationToken cancelled;
+        const auto start = std::chrono::steady_clock::now();
+        engine.RunAfter(std::chrono::milliseconds(50), [&]() {
+            ran.set_value(std::chrono::steady_clock::now() - start);
+        });
+        engine.RunAfter(
+            std::chrono::milliseconds(10),
+            [&]() { ran.set_value(std::chrono::seconds(0)); },
+            cancelled);
+        cancelled.Cancel();
+
+        REQUIRE(ran.get_future().get() >= std::chrono::milliseconds(50));
+    }
+
+    SECTION("Invalid requests fail")
+    {
+        AsyncEngine engine(backend);
+
+        auto promise =
+            std::make_shared<std::promise<tl::expected<CurrentTickInfo, ConnectionError>>>();
+        auto future = promise->get_future();
+        GetCurrentTickInfoAsync(engine, {"not an ip-address", 21841}, FulfillPromise(promise));
+        auto info = future.get();
+        REQUIRE_FALSE(info.has_value());
+        REQUIRE(info.error().message == "Invalid ip-address: not an ip-address");
+
+        auto entityPromise =
+            std::make_shared<std::promise<tl::expected<RespondedEntity, ConnectionError>>>();
+        auto entity = entityPromise->get_future();
+        GetEntityAsync(engine, {"127.0.0.1", 21841}, "TOO SHORT", FulfillPromise(entityPromise));
+        REQUIRE_FALSE(entity.get().has_value());
+    }
+
+    SECTION("Pending requests fail when the engine stops")
+    {
+        TickInfoServer server(false);
+        auto promise =
+            std::make_shared<std::promise<tl::expected<CurrentTickInfo, ConnectionError>>>();
+        auto future = promise->get_future();
+        {
+            AsyncEngine engine(backend);
+            GetCurrentTickInfoAsync(engine, server.GetNode(), FulfillPromise(promise));
+            REQUIRE(engine.GetPendingCount() == 1);
+        }
+
+        auto info = future.get();
+        REQUIRE_FALSE(info.has_value());
+        REQUIRE(info.error().message == "Network engine stopped");
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+namespace
+{
+/**
+ * Query the tick info twice in a row, the second query only starts once the first completed
+ * @param engine The engine to run the requests on
+ * @param node The node to query
+ * @return The ticks of both responses
+ */
+Task<tl::expected<std::pair<unsigned int, unsigned int>, ConnectionError>> GetTwoTicks(
+    AsyncEngine& engine,
+    NodeAddress node)
+{
+    auto first = co_await GetCurrentTickInfoTask(engine, node);
+    if (!first.has_value())
+    {
+        co_return tl::make_unexpected(first.error());
+    }
+
+    auto second = co_await GetCurrentTickInfoTask(engine, node);
+    if (!second.has_value())
+    {
+        co_return tl::make_unexpected(second.error());
+    }
+    co_return std::make_pair(first->tick, second->tick);
+}
+} // namespace
+
+// ------------------------------------------------------------------------------------------------
+TEST_CASE("Coroutine requests", "[AsyncEngine]")
+{
+    const auto backend = GENERATE(
+        AsyncEngineBackend::Threads,
+        AsyncEngineBackend::Epoll,
+        AsyncEngineBackend::IoUring);
+
+    SECTION("Awaited requests run one after the other")
+    {
+        TickInfoServer server(true);
+        AsyncEngine engine(backend);
+
+        auto ticks = StartTask(GetTwoTicks(engine, server.GetNode())).get();
+        REQUIRE(ticks.has_value());
+        REQUIRE(ticks->first == 1);
+        REQUIRE(ticks->second == 2);
+        REQUIRE(engine.GetPendingCount() == 0);
+    }
+
+    SECTION("Many chains are in flight at once")
+    {
+        TickInfoServer server(true);
+        AsyncEngine engine(backend);
+
+        constexpr size_t chainCount = 50;
+        typedef tl::expected<std::pair<unsigned int, unsigned int>, ConnectionError> Ticks;
+        std::vector<std::future<Ticks>> futures;
+        for (size_t i = 0; i < chainCount; ++i)
+        {
+            futures.push_back(StartTask(GetTwoTicks(engine, server.GetNode())));
+        }
+
+        std::set<unsigned int> ticks;
+        for (auto& future : futures)
+        {
+            auto result = future.get();
+            REQUIRE(result.has_value());
+            REQUIRE(result->first != result->second);
+            ticks.insert(result->first);
+            ticks.insert(result->second);
+        }
+        REQUIRE(ticks.size() == 2 * chainCount);
+    }
+
+    SECTION("The connection of a task can be used for blocking requests")
+    {
+        TickInfoServer server(true);
+        AsyncEngine engine(backend);
+
+        auto connection = StartTask(CreateConnectionTask(engine, server.GetNode())).get();
+        REQUIRE(connection.has_value());
+        auto info = GetCurrentTickInfo(connection.value());
+        REQUIRE(info.has_value());
+        REQUIRE(info->tick == 1);
+    }
+
+    SECTION("Errors are returned to the awaiting coroutine")
+    {
+        AsyncEngine engine(backend);
+
+        auto ticks = StartTask(GetTwoTicks(engine, {"not an ip-address", 21841})).get();
+        REQUIRE_FALSE(ticks.has_value());
+        REQUIRE(ticks.error().message == "Invalid ip-address: not an ip-address");
+
+        auto connection =
+            StartTask(CreateConnectionTask(engine, {"not an ip-address", 21841})).get();
+        REQUIRE_FALSE(connection.has_value());
+    }
+}
+
+#endif
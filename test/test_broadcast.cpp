@@ -0,0 +1,85 @@
+#include <catch.hpp>
+
+#include "network/broadcast.hpp"
+
+#ifndef _MSC_VER
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+namespace
+{
+// ------------------------------------------------------------------------------------------------
+/**
+ * Open a listening socket on an ephemeral loopback port
+ * @param port The port of the socket
+ * @return The socket descriptor
+ */
+int Listen(unsigned short& port)
+{
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;
+    bind(listener, (const sockaddr*)&address, sizeof(address));
+    listen(listener, 4);
+
+    socklen_t length = sizeof(address);
+    getsockname(listener, (sockaddr*)&address, &length);
+    port = ntohs(address.sin_port);
+    return listener;
+}
+} // namespace
+
+// ------------------------------------------------------------------------------------------------
+TEST_CASE("Broadcast to multiple nodes", "[Broadcast]")
+{
+    using namespace std::chrono_literals;
+
+    unsigned short port = 0;
+    const int listener = Listen(port);
+
+    // a port nobody listens on anymore
+    unsigned short closedPort = 0;
+    close(Listen(closedPort));
+
+    const std::string data(100000, 'q');
+    std::string received;
+    std::thread server([&]() {
+        int client = accept(listener, nullptr, nullptr);
+        char buffer[4096];
+        ssize_t bytes = 0;
+        while ((bytes = recv(client, buffer, sizeof(buffer), 0)) > 0)
+        {
+            received.append(buffer, bytes);
+        }
+        close(client);
+    });
+
+    const std::vector<NodeAddress> nodes{
+        {"127.0.0.1", port},
+        {"127.0.0.256", port},
+        {"127.0.0.1", closedPort}};
+    const auto results = BroadcastToNodes(nodes, data.data(), data.size(), 2000ms);
+    server.join();
+    close(listener);
+
+    REQUIRE(results.size() == 3);
+    REQUIRE(results[0].bAccepted);
+    REQUIRE(results[0].node.port == port);
+    REQUIRE(received == data);
+
+    REQUIRE_FALSE(results[1].bAccepted);
+    REQUIRE(results[1].error == "Invalid ip-address: 127.0.0.256");
+
+    REQUIRE_FALSE(results[2].bAccepted);
+    REQUIRE(results[2].error == "Failed to connect with: 127.0.0.1");
+    REQUIRE(results[2].elapsed < 2000ms);
+}
+
+#endif
@@ -0,0 +1,205 @@
+#include <catch.hpp>
+
+#include "network/connection.hpp"
+#include "network_messages/tick.h"
+
+#ifndef _MSC_VER
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+namespace
+{
+// ------------------------------------------------------------------------------------------------
+/**
+ * Serve data to a single client
+ */
+class Server
+{
+public:
+    /**
+     * Constructor, listens on an ephemeral loopback port
+     */
+    Server()
+    {
+        m_listener = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bind(m_listener, (const sockaddr*)&address, sizeof(address));
+        listen(m_listener, 1);
+
+        socklen_t length = sizeof(address);
+        getsockname(m_listener, (sockaddr*)&address, &length);
+        m_port = ntohs(address.sin_port);
+    }
+
+    /**
+     * Destructor
+     */
+    ~Server()
+    {
+        if (m_thread.joinable())
+        {
+            m_thread.join();
+        }
+        close(m_listener);
+    }
+
+    /**
+     * Accept a client and send it data in chunks, keeping the connection open for a while
+     * @param chunks The chunks to send
+     */
+    void Serve(std::vector<std::string> chunks)
+    {
+        m_thread = std::thread([this, chunks]() {
+            int client = accept(m_listener, nullptr, nullptr);
+            for (const auto& chunk : chunks)
+            {
+                send(client, chunk.data(), chunk.size(), 0);
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            close(client);
+        });
+    }
+
+    /**
+     * Get the port
+     * @return The port of the server
+     */
+    unsigned short GetPort() const { return m_port; }
+
+private:
+    int m_listener;
+    unsigned short m_port;
+    std::thread m_thread;
+};
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Create a frame
+ * @param type The header type
+ * @param payload The payload
+ * @return The frame
+ */
+std::string Frame(unsigned char type, const std::string& payload)
+{
+    RequestResponseHeader header;
+    header.checkAndSetSize(sizeof(header) + payload.size());
+    header.setType(type);
+    header.setDejavu(0);
+    return std::string((const char*)&header, sizeof(header)) + payload;
+}
+} // namespace
+
+// ------------------------------------------------------------------------------------------------
+TEST_CASE("Receive frames in place", "[Connection]")
+{
+    Server server;
+
+    SECTION("Frames are parsed across reads and other types are skipped")
+    {
+        CurrentTickInfo info{};
+        info.tick = 1234;
+        info.epoch = 99;
+        const auto tickInfo = Frame(
+            RESPOND_CURRENT_TICK_INFO,
+            std::string((const char*)&info, sizeof(info)));
+
+        // a large frame of another type, then the tick info split over reads, then a second one
+        const auto other = Frame(1, std::string(50000, 'x'));
+        server.Serve(
+            {other.substr(0, 3),
+             other.substr(3) + tickInfo.substr(0, 10),
+             tickInfo.substr(10) + tickInfo});
+
+        auto connection = CreateConnection("127.0.0.1", server.GetPort()).value();
+
+        const auto start = std::chrono::steady_clock::now();
+        auto view = connection->ReceiveView<CurrentTickInfo>(RESPOND_CURRENT_TICK_INFO);
+        REQUIRE(view.has_value());
+        REQUIRE(view.value()->tick == 1234);
+        REQUIRE(view.value()->epoch == 99);
+
+        // returns as soon as the frame is complete instead of waiting for the timeout
+        REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(500));
+
+        // the second frame was buffered already
+        auto copy = connection->ReceiveAs<CurrentTickInfo>(RESPOND_CURRENT_TICK_INFO);
+        REQUIRE(copy.has_value());
+        REQUIRE(copy->tick == 1234);
+
+        REQUIRE_FALSE(connection->ReceiveAs<CurrentTickInfo>(RESPOND_CURRENT_TICK_INFO));
+    }
+
+    SECTION("Frames of size zero are rejected")
+    {
+        server.Serve({std::string(8, '\0')});
+
+        auto connection = CreateConnection("127.0.0.1", server.GetPort()).value();
+        auto view = connection->ReceiveView<CurrentTickInfo>(RESPOND_CURRENT_TICK_INFO);
+        REQUIRE_FALSE(view.has_value());
+        REQUIRE(view.error().message == "Response contained a frame with invalid size: 0");
+    }
+
+    SECTION("Payloads of the wrong size are rejected")
+    {
+        server.Serve({Frame(RESPOND_CURRENT_TICK_INFO, "abc")});
+
+        auto connection = CreateConnection("127.0.0.1", server.GetPort()).value();
+        auto view = connection->ReceiveView<CurrentTickInfo>(RESPOND_CURRENT_TICK_INFO);
+        REQUIRE_FALSE(view.has_value());
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+TEST_CASE("Stop calls at their deadline", "[Connection]")
+{
+    using namespace std::chrono_literals;
+    Server server;
+
+    SECTION("Receives fail once the deadline expires")
+    {
+        server.Serve({});
+
+        auto connection =
+            CreateConnection("127.0.0.1", server.GetPort(), Deadline::After(50ms)).value();
+        const auto start = std::chrono::steady_clock::now();
+        auto frame = connection->ReceiveFrame(RESPOND_CURRENT_TICK_INFO);
+        REQUIRE_FALSE(frame.has_value());
+        REQUIRE(frame.error().message == "Request deadline expired");
+        REQUIRE(std::chrono::steady_clock::now() - start < 150ms);
+    }
+
+    SECTION("Receives fail once the token is cancelled")
+    {
+        server.Serve({});
+
+        Deadline deadline;
+        auto connection = CreateConnection("127.0.0.1", server.GetPort(), deadline).value();
+        std::thread canceller([token = deadline.token]() {
+            std::this_thread::sleep_for(20ms);
+            token.Cancel();
+        });
+        auto frame = connection->ReceiveFrame(RESPOND_CURRENT_TICK_INFO);
+        canceller.join();
+        REQUIRE_FALSE(frame.has_value());
+        REQUIRE(frame.error().message == "Request was cancelled");
+    }
+
+    SECTION("Cancelled calls don't connect")
+    {
+        Deadline deadline;
+        deadline.token.Cancel();
+        auto connection = CreateConnection("127.0.0.1", server.GetPort(), deadline);
+        REQUIRE_FALSE(connection.has_value());
+        REQUIRE(connection.error().message == "Request was cancelled");
+    }
+}
+
+#endif
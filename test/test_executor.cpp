@@ -0,0 +1,271 @@
+#include <catch.hpp>
+
+#include "executor.hpp"
+
+#include <chrono>
+#include <set>
+#include <string>
+
+// ------------------------------------------------------------------------------------------------
+TEST_CASE("Run work on a pool of workers", "[Executor]")
+{
+    using namespace std::chrono_literals;
+
+    SECTION("Submitted work returns its result")
+    {
+        Executor executor(4);
+        REQUIRE(executor.GetThreadCount() == 4);
+
+        std::vector<std::future<size_t>> futures;
+        for (size_t i = 0; i < 1000; ++i)
+        {
+            const auto priority = (TaskPriority)(i % 3);
+            futures.push_back(
+                executor.Submit(priority, [i](const CancellationToken&) { return i * i; }));
+        }
+        for (size_t i = 0; i < futures.size(); ++i)
+        {
+            REQUIRE(futures[i].get() == i * i);
+        }
+    }
+
+    SECTION("Higher priority work runs first")
+    {
+        Executor executor(1);
+
+        // Occupy the only worker while the other work is queued
+        std::promise<void> release;
+        auto blocked = executor.Submit(
+            TaskPriority::Interactive,
+            [released = release.get_future().share()](const CancellationToken&) {
+                released.wait();
+            });
+
+        std::mutex mutex;
+        std::vector<TaskPriority> order;
+        std::vector<std::future<void>> futures;
+        for (auto priority :
+             {TaskPriority::Bulk, TaskPriority::Background, TaskPriority::Interactive})
+        {
+            futures.push_back(executor.Submit(priority, [&, priority](const CancellationToken&) {
+                std::lock_guard<std::mutex> lock(mutex);
+                order.push_back(priority);
+            }));
+        }
+        release.set_value();
+        for (auto& future : futures)
+        {
+            future.get();
+        }
+
+        REQUIRE(
+            order == std::vector<TaskPriority>{
+                         TaskPriority::Interactive,
+                         TaskPriority::Background,
+                         TaskPriority::Bulk});
+    }
+
+    SECTION("Bulk work leaves a worker for interactive work")
+    {
+        Executor executor(2);
+
+        std::promise<void> release;
+        auto released = release.get_future().share();
+        std::vector<std::future<void>> bulk;
+        for (int i = 0; i < 4; ++i)
+        {
+            bulk.push_back(executor.Submit(
+                TaskPriority::Bulk,
+                [released](const CancellationToken&) { released.wait(); }));
+        }
+
+        auto interactive =
+            executor.Submit(TaskPriority::Interactive, [](const CancellationToken&) { return 1; });
+        REQUIRE(interactive.wait_for(5s) == std::future_status::ready);
+        REQUIRE(interactive.get() == 1);
+
+        release.set_value();
+        for (auto& future : bulk)
+        {
+            future.get();
+        }
+    }
+
+    SECTION("Idle workers steal work queued by a busy worker")
+    {
+        Executor executor(2);
+
+        // The nested work is queued on the worker that waits for it
+        auto outer = executor.Submit(TaskPriority::Background, [&](const CancellationToken&) {
+            auto inner = executor.Submit(
+                TaskPriority::Background,
+                [](const CancellationToken&) { return std::this_thread::get_id(); });
+            if (inner.wait_for(5s) != std::future_status::ready)
+            {
+                return false;
+            }
+            return inner.get() != std::this_thread::get_id();
+        });
+        REQUIRE(outer.get());
+    }
+
+    SECTION("Cancelled work doesn't run")
+    {
+        Executor executor(1);
+
+        std::promise<void> release;
+        auto blocked = executor.Submit(
+            TaskPriority::Interactive,
+            [released = release.get_future().share()](const CancellationToken&) {
+                released.wait();
+            });
+
+        CancellationToken token;
+        std::atomic<bool> bRan = false;
+        auto cancelled = executor.Submit(
+            TaskPriority::Interactive,
+            [&](const CancellationToken&) { bRan = true; },
+            token);
+        token.Cancel();
+        release.set_value();
+
+        REQUIRE_THROWS_AS(cancelled.get(), std::future_error);
+        REQUIRE_FALSE(bRan);
+    }
+
+    SECTION("Linked tokens are cancelled with their parent")
+    {
+        CancellationToken parent;
+        auto linked = parent.CreateLinked();
+        auto other = parent.CreateLinked();
+
+        linked.Cancel();
+        REQUIRE(linked.IsCancelled());
+        REQUIRE_FALSE(parent.IsCancelled());
+        REQUIRE_FALSE(other.IsCancelled());
+
+        parent.Cancel();
+        REQUIRE(other.IsCancelled());
+    }
+
+    SECTION("Running work observes its token")
+    {
+        Executor executor(2);
+
+        CancellationToken token;
+        std::promise<void> started;
+        auto future = executor.Submit(
+            TaskPriority::Bulk,
+            [&](const CancellationToken& token) {
+                started.set_value();
+                while (!token.IsCancelled())
+                {
+                    std::this_thread::yield();
+                }
+                return true;
+            },
+            token);
+
+        started.get_future().wait();
+        token.Cancel();
+        REQUIRE(future.get());
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+TEST_CASE("Hand results back through completions", "[Executor]")
+{
+    using namespace std::chrono_literals;
+
+    SECTION("Completions run on the draining thread in order")
+    {
+        Executor executor(4);
+        REQUIRE(executor.DrainCompletions() == 0);
+
+        constexpr size_t workCount = 200;
+        std::vector<size_t> results;
+        std::set<std::thread::id> threads;
+        std::atomic<size_t> doneCount = 0;
+        for (size_t i = 0; i < workCount; ++i)
+        {
+            executor.Post(
+                TaskPriority::Interactive,
+                [i, &doneCount](const CancellationToken&) {
+                    ++doneCount;
+                    return i;
+                },
+                [&](size_t result) {
+                    results.push_back(result);
+                    threads.insert(std::this_thread::get_id());
+                });
+        }
+
+        // Like a frame loop
+        const auto deadline = std::chrono::steady_clock::now() + 10s;
+        while (results.size() < workCount && std::chrono::steady_clock::now() < deadline)
+        {
+            executor.DrainCompletions();
+            std::this_thread::sleep_for(1ms);
+        }
+
+        REQUIRE(results.size() == workCount);
+        REQUIRE(threads == std::set<std::thread::id>{std::this_thread::get_id()});
+        REQUIRE(std::set<size_t>(results.begin(), results.end()).size() == workCount);
+    }
+
+    SECTION("Completions of cancelled work are discarded")
+    {
+        Executor executor(1);
+
+        CancellationToken token;
+        bool bCompleted = false;
+        auto done = executor.Submit(TaskPriority::Interactive, [&](const CancellationToken&) {
+            executor.PostCompletion([&]() { bCompleted = true; }, token);
+        });
+        done.get();
+
+        token.Cancel();
+        REQUIRE(executor.DrainCompletions() == 0);
+        REQUIRE_FALSE(bCompleted);
+    }
+
+    SECTION("Completions posted by many threads")
+    {
+        CompletionQueue queue;
+        CancellationToken token;
+
+        constexpr size_t threadCount = 8;
+        constexpr size_t pushCount = 10000;
+        std::vector<std::vector<size_t>> received(threadCount);
+        std::vector<std::thread> threads;
+        for (size_t thread = 0; thread < threadCount; ++thread)
+        {
+            threads.emplace_back([&, thread]() {
+                for (size_t i = 0; i < pushCount; ++i)
+                {
+                    queue.Push([&, thread, i]() { received[thread].push_back(i); }, token);
+                }
+            });
+        }
+
+        size_t drainedCount = 0;
+        while (drainedCount < threadCount * pushCount)
+        {
+            drainedCount += queue.Drain();
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+
+        // Completions of each thread run in the order they were pushed
+        for (const auto& values : received)
+        {
+            REQUIRE(values.size() == pushCount);
+            for (size_t i = 0; i < pushCount; ++i)
+            {
+                REQUIRE(values[i] == i);
+            }
+        }
+    }
+}
@@ -0,0 +1,133 @@
+#include <catch.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <random>
+
+#include "core/four_q.h"
+#include "crypto/fixed_base_table.hpp"
+
+namespace
+{
+
+std::vector<std::vector<unsigned char>> TestPrivateKeys()
+{
+    std::mt19937 generator(12);
+
+    // zero, one, the curve order, all ones and random keys
+    std::vector<std::vector<unsigned char>> keys = {
+        std::vector<unsigned char>(32, 0),
+        {1},
+        {0xE1, 0x62, 0xE9, 0xD2, 0x8A, 0xE3, 0x13, 0x22, 0xB7, 0x52, 0xBE,
+         0xD4, 0xF4, 0x0E, 0x60, 0x1A, 0xB8, 0xF6, 0x6F, 0x0D, 0x7E, 0x71,
+         0x53, 0xD2, 0xB2, 0x86, 0xE9, 0x89, 0x96, 0x7A, 0x29, 0x00},
+        std::vector<unsigned char>(32, 0xFF)};
+    keys[1].resize(32);
+    for (int i = 0; i < 50; ++i)
+    {
+        std::vector<unsigned char> key(32);
+        for (auto& byte : key)
+        {
+            byte = (unsigned char)generator();
+        }
+        keys.push_back(key);
+    }
+    return keys;
+}
+
+} // namespace
+
+// ------------------------------------------------------------------------------------------------
+TEST_CASE("Fixed-base tables match getPublicKey", "[FixedBaseTable]")
+{
+    REQUIRE_FALSE(CreateFixedBaseTable(3));
+    REQUIRE_FALSE(CreateFixedBaseTable(17));
+
+    for (unsigned int windowWidth : {4u, 5u, 8u, 11u})
+    {
+        auto table = CreateFixedBaseTable(windowWidth);
+        REQUIRE(table);
+        REQUIRE((*table)->GetWindowWidth() == windowWidth);
+        REQUIRE(
+            (*table)->GetMemorySize() ==
+            (247 / windowWidth + 1) * (1u << (windowWidth - 1)) * 96);
+
+        for (const auto& key : TestPrivateKeys())
+        {
+            unsigned char expected[32], actual[32];
+            getPublicKey(key.data(), expected);
+            (*table)->GetPublicKey(key.data(), actual);
+            REQUIRE(memcmp(expected, actual, 32) == 0);
+        }
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+TEST_CASE("Fixed-base table cache file", "[FixedBaseTable]")
+{
+    const std::string path = "test_fixed_base_table.bin";
+    std::remove(path.c_str());
+
+    REQUIRE_FALSE(LoadFixedBaseTable(path));
+
+    // missing cache is created
+    auto created = LoadOrCreateFixedBaseTable(path, 6);
+    REQUIRE(created);
+    auto loaded = LoadFixedBaseTable(path);
+    REQUIRE(loaded);
+    REQUIRE((*loaded)->GetWindowWidth() == 6);
+
+    const auto key = TestPrivateKeys().back();
+    unsigned char expected[32], actual[32];
+    getPublicKey(key.data(), expected);
+    (*loaded)->GetPublicKey(key.data(), actual);
+    REQUIRE(memcmp(expected, actual, 32) == 0);
+
+    // different window width is rebuilt
+    auto rebuilt = LoadOrCreateFixedBaseTable(path, 7);
+    REQUIRE(rebuilt);
+    REQUIRE((*rebuilt)->GetWindowWidth() == 7);
+
+    // corrupted entry is rejected
+    {
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekg(1000);
+        const char byte = (char)file.get();
+        file.seekp(1000);
+        file.put((char)(byte ^ 1));
+    }
+    auto corrupted = LoadFixedBaseTable(path);
+    REQUIRE_FALSE(corrupted);
+    REQUIRE(corrupted.error().message == path + " is corrupted");
+
+    std::remove(path.c_str());
+}
+
+// ------------------------------------------------------------------------------------------------
+TEST_CASE("Fixed-base table selection", "[FixedBaseTable]")
+{
+    REQUIRE(GetSelectedFixedBaseTable() == nullptr);
+
+    auto table = CreateFixedBaseTable(8);
+    REQUIRE(table);
+    SelectFixedBaseTable(*table);
+    REQUIRE(GetSelectedFixedBaseTable() == *table);
+
+    const auto keys = TestPrivateKeys();
+    std::vector<unsigned char> privateKeys, publicKeys(32 * keys.size());
+    for (const auto& key : keys)
+    {
+        privateKeys.insert(privateKeys.end(), key.begin(), key.end());
+    }
+    ComputePublicKeys(privateKeys.data(), publicKeys.data(), (unsigned int)keys.size());
+
+    SelectFixedBaseTable(nullptr);
+    REQUIRE(GetSelectedFixedBaseTable() == nullptr);
+
+    for (size_t i = 0; i < keys.size(); ++i)
+    {
+        unsigned char expected[32];
+        ComputePublicKey(keys[i].data(), expected);
+        REQUIRE(memcmp(expected, &publicKeys[32 * i], 32) == 0);
+    }
+}
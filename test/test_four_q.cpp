@@ -0,0 +1,259 @@
+#include <catch.hpp>
+
+#include <random>
+
+#include "core/four_q.h"
+#include "core/four_q_x4.h"
+
+// ------------------------------------------------------------------------------------------------
+TEST_CASE("Field arithmetic backends are bit-identical", "[FourQ]")
+{
+    if (!isMulxSupported())
+    {
+        WARN("MULX/ADX not supported by this CPU, skipping backend comparison");
+        return;
+    }
+
+    std::mt19937_64 generator(1271);
+
+    // edge cases: 0, 1, p = 2^127-1, 2^127 and the largest unreduced inputs
+    std::vector<std::pair<unsigned long long, unsigned long long>> values = {
+        {0, 0},
+        {1, 0},
+        {0xFFFFFFFFFFFFFFFF, 0x7FFFFFFFFFFFFFFF},
+        {0, 0x8000000000000000},
+        {0xFFFFFFFFFFFFFFFF, 0x7FFFFFFFFFFFFFFE}};
+    for (int i = 0; i < 10000; ++i)
+    {
+        values.emplace_back(generator(), generator() & 0x7FFFFFFFFFFFFFFF);
+    }
+
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        const auto& x = values[i];
+        const auto& y = values[(i * 7 + 3) % values.size()];
+
+        felm_t a{x.first, x.second};
+        felm_t b{y.first, y.second};
+        felm_t expected, actual;
+
+        fpmul1271_portable(a, b, expected);
+        fpmul1271_mulx(a, b, actual);
+        REQUIRE(expected[0] == actual[0]);
+        REQUIRE(expected[1] == actual[1]);
+
+        fpsqr1271_portable(a, expected);
+        fpsqr1271_mulx(a, actual);
+        REQUIRE(expected[0] == actual[0]);
+        REQUIRE(expected[1] == actual[1]);
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+TEST_CASE("Sign and verify", "[FourQ]")
+{
+    unsigned char subseed[32], privateKey[32], publicKey[32];
+    unsigned char digest[32], signature[64];
+
+    getSubseed((const unsigned char*)"aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa", subseed);
+    getPrivateKey(subseed, privateKey);
+    getPublicKey(privateKey, publicKey);
+
+    KangarooTwelve((unsigned char*)"qwallet", 7, digest, 32);
+    sign(subseed, publicKey, digest, signature);
+    REQUIRE(verify(publicKey, digest, signature));
+
+    // tampered digest
+    digest[0] ^= 1;
+    REQUIRE_FALSE(verify(publicKey, digest, signature));
+}
+
+// ------------------------------------------------------------------------------------------------
+TEST_CASE("4-way field arithmetic matches the scalar field arithmetic", "[FourQ]")
+{
+    if (!useIfmaPointArithmetic)
+    {
+        WARN("AVX-512 IFMA not supported by this CPU, skipping 4-way comparison");
+        return;
+    }
+
+    std::mt19937_64 generator(52);
+
+    f2elm_t a[4] = {
+        {{0, 0}, {1, 0}},
+        {{0xFFFFFFFFFFFFFFFF, 0x7FFFFFFFFFFFFFFF}, {0xFFFFFFFFFFFFFFFE, 0x7FFFFFFFFFFFFFFF}},
+        {{0, 0x8000000000000000}, {0xFFFFFFFFFFFFFFFF, 0x7FFFFFFFFFFFFFFE}}};
+    f2elm_t b[4];
+    for (int i = 0; i < 1000; ++i)
+    {
+        for (int lane = (i == 0 ? 3 : 0); lane < 4; ++lane)
+        {
+            for (auto& element : a[lane])
+            {
+                element[0] = generator();
+                element[1] = generator() & 0x7FFFFFFFFFFFFFFF;
+            }
+        }
+        for (int lane = 0; lane < 4; ++lane)
+        {
+            b[lane][0][0] = generator();
+            b[lane][0][1] = generator() & 0x7FFFFFFFFFFFFFFF;
+            b[lane][1][0] = a[(lane + 1) % 4][0][0];
+            b[lane][1][1] = a[(lane + 1) % 4][0][1];
+        }
+
+        f2elm_x4_t x, y, product, square, difference;
+        fp2pack_x4(a[0], a[1], a[2], a[3], x);
+        fp2pack_x4(b[0], b[1], b[2], b[3], y);
+        fp2mul1271_x4(x, y, product);
+        fp2sqr1271_x4(x, square);
+        fp2sub1271_x4(x, y, difference);
+
+        f2elm_t actual[3][4];
+        fp2unpack_x4(product, actual[0][0], actual[0][1], actual[0][2], actual[0][3]);
+        fp2unpack_x4(square, actual[1][0], actual[1][1], actual[1][2], actual[1][3]);
+        fp2unpack_x4(difference, actual[2][0], actual[2][1], actual[2][2], actual[2][3]);
+
+        for (int lane = 0; lane < 4; ++lane)
+        {
+            f2elm_t expected[3];
+            fp2mul1271(a[lane], b[lane], expected[0]);
+            fp2sqr1271(a[lane], expected[1]);
+            fp2sub1271(a[lane], b[lane], expected[2]);
+            for (int operation = 0; operation < 3; ++operation)
+            {
+                for (int j = 0; j < 2; ++j)
+                {
+                    mod1271(expected[operation][j]);
+                    mod1271(actual[operation][lane][j]);
+                    REQUIRE(expected[operation][j][0] == actual[operation][lane][j][0]);
+                    REQUIRE(expected[operation][j][1] == actual[operation][lane][j][1]);
+                }
+            }
+        }
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+TEST_CASE("Batch public key generation matches getPublicKey", "[FourQ]")
+{
+    std::mt19937_64 generator(4);
+
+    // not a multiple of four, so the remainder path is exercised as well
+    constexpr unsigned int count = 23;
+    std::vector<unsigned long long> privateKeys(4 * count);
+    for (auto& word : privateKeys)
+    {
+        word = generator();
+    }
+    std::vector<unsigned char> publicKeys(32 * count);
+
+    getPublicKeys((const unsigned char*)privateKeys.data(), publicKeys.data(), count);
+
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        unsigned char expected[32];
+        getPublicKey((const unsigned char*)&privateKeys[4 * i], expected);
+        REQUIRE(memcmp(expected, &publicKeys[32 * i], 32) == 0);
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+TEST_CASE("Batch verification matches verify", "[FourQ]")
+{
+    std::mt19937 generator(246);
+
+    constexpr unsigned int count = 18;
+    std::vector<unsigned char> publicKeys(32 * count), digests(32 * count), signatures(64 * count);
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        unsigned char subseed[32], privateKey[32];
+        for (auto& byte : subseed)
+        {
+            byte = (unsigned char)generator();
+        }
+        for (unsigned int j = 0; j < 32; ++j)
+        {
+            digests[32 * i + j] = (unsigned char)generator();
+        }
+        getPrivateKey(subseed, privateKey);
+        getPublicKey(privateKey, &publicKeys[32 * i]);
+        sign(subseed, &publicKeys[32 * i], &digests[32 * i], &signatures[64 * i]);
+    }
+
+    // tampered digest, signature, public key and non-canonical encodings
+    digests[32 * 1] ^= 1;
+    signatures[64 * 2 + 5] ^= 0x10;
+    signatures[64 * 3 + 40] ^= 0x01;
+    publicKeys[32 * 5 + 3] ^= 0x80;
+    publicKeys[32 * 6 + 15] |= 0x80;
+    signatures[64 * 8 + 63] = 1;
+    for (unsigned int lane = 12; lane < 16; ++lane)
+    {
+        digests[32 * lane] ^= 1;
+    }
+
+    bool results[count];
+    verifyEach(publicKeys.data(), digests.data(), signatures.data(), count, results);
+
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        INFO("signature " << i);
+        REQUIRE(results[i] == verify(&publicKeys[32 * i], &digests[32 * i], &signatures[64 * i]));
+    }
+    REQUIRE(results[0]);
+    REQUIRE_FALSE(results[1]);
+    REQUIRE_FALSE(results[12]);
+}
+
+// ------------------------------------------------------------------------------------------------
+TEST_CASE("Batch verification with a randomized linear combination", "[FourQ]")
+{
+    std::mt19937 generator(29);
+
+    // spans two chunks, the second one partially filled
+    constexpr unsigned int count = VERIFY_BATCH_CHUNK + 9;
+    std::vector<unsigned char> publicKeys(32 * count), digests(32 * count), signatures(64 * count);
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        unsigned char subseed[32], privateKey[32];
+        for (auto& byte : subseed)
+        {
+            byte = (unsigned char)generator();
+        }
+        for (unsigned int j = 0; j < 32; ++j)
+        {
+            digests[32 * i + j] = (unsigned char)generator();
+        }
+        getPrivateKey(subseed, privateKey);
+        getPublicKey(privateKey, &publicKeys[32 * i]);
+        sign(subseed, &publicKeys[32 * i], &digests[32 * i], &signatures[64 * i]);
+    }
+
+    // the combination itself accepts valid chunks, not only the per-signature fallback
+    REQUIRE(verify_batch_chunk(publicKeys.data(), digests.data(), signatures.data(), 1));
+    REQUIRE(verify_batch_chunk(publicKeys.data(), digests.data(), signatures.data(), 17));
+    REQUIRE(verify_batch_chunk(
+        publicKeys.data(),
+        digests.data(),
+        signatures.data(),
+        VERIFY_BATCH_CHUNK));
+
+    bool results[count];
+    REQUIRE(verifyBatch(publicKeys.data(), digests.data(), signatures.data(), count, results));
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        REQUIRE(results[i]);
+    }
+
+    // invalid entries are identified by the fallback
+    digests[32 * 3] ^= 1;
+    signatures[64 * 40 + 33] ^= 0x04;
+    signatures[64 * (count - 1) + 7] ^= 0x20;
+    REQUIRE_FALSE(verifyBatch(publicKeys.data(), digests.data(), signatures.data(), count, results));
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        INFO("signature " << i);
+        REQUIRE(results[i] == (i != 3 && i != 40 && i != count - 1));
+    }
+}
@@ -0,0 +1,308 @@
+#include <catch.hpp>
+
+#include "network/entity.hpp"
+#include "network/hedging.hpp"
+#include "network/tick.hpp"
+
+#ifndef _MSC_VER
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace
+{
+// ------------------------------------------------------------------------------------------------
+/**
+ * Answer every request with the same response after a delay, one client after the other
+ */
+class DelayedServer
+{
+public:
+    /**
+     * Constructor, listens on an ephemeral loopback port
+     * @param response The frame to respond with
+     * @param delay The time between receiving a request and responding
+     */
+    DelayedServer(std::string response, std::chrono::milliseconds delay)
+    {
+        m_listener = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bind(m_listener, (const sockaddr*)&address, sizeof(address));
+        listen(m_listener, 64);
+
+        socklen_t length = sizeof(address);
+        getsockname(m_listener, (sockaddr*)&address, &length);
+        m_port = ntohs(address.sin_port);
+
+        m_thread = std::thread([this, response, delay]() {
+            while (true)
+            {
+                int client = accept(m_listener, nullptr, nullptr);
+                if (client < 0)
+                {
+                    break;
+                }
+
+                RequestResponseHeader request;
+                if (recv(client, &request, sizeof(request), MSG_WAITALL) > 0)
+                {
+                    std::this_thread::sleep_for(delay);
+                    send(client, response.data(), response.size(), MSG_NOSIGNAL);
+                }
+                close(client);
+            }
+        });
+    }
+
+    /**
+     * Destructor
+     */
+    ~DelayedServer()
+    {
+        shutdown(m_listener, SHUT_RDWR);
+        m_thread.join();
+        close(m_listener);
+    }
+
+    /**
+     * Get the node address
+     * @return The address of the server
+     */
+    NodeAddress GetNode() const { return {"127.0.0.1", m_port}; }
+
+private:
+    int m_listener;
+    unsigned short m_port;
+    std::thread m_thread;
+};
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Create a response frame
+ * @param type The header type
+ * @param payload The payload
+ * @return The frame
+ */
+template <typename T>
+std::string Frame(unsigned char type, const T& payload)
+{
+    RequestResponseHeader header;
+    header.checkAndSetSize(sizeof(header) + sizeof(payload));
+    header.setType(type);
+    header.setDejavu(0);
+    return std::string((const char*)&header, sizeof(header)) +
+           std::string((const char*)&payload, sizeof(payload));
+}
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Create a tick info response
+ * @param tick The tick of the response
+ * @return The frame
+ */
+std::string TickInfoFrame(unsigned int tick)
+{
+    CurrentTickInfo info{};
+    info.tick = tick;
+    return Frame(RESPOND_CURRENT_TICK_INFO, info);
+}
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Create an entity response
+ * @param balance The balance of the entity
+ * @param tick The tick of the response
+ * @return The frame
+ */
+std::string EntityFrame(long long balance, unsigned int tick)
+{
+    RespondedEntity entity{};
+    entity.entity.incomingAmount = balance;
+    entity.tick = tick;
+    return Frame(RESPOND_ENTITY, entity);
+}
+
+/// Node that refuses connections
+const NodeAddress deadNode{"127.0.0.1", 1};
+
+/// Identity of the entity requests
+const std::string identity = "BZBQFLLBNCXEMGLOBHUVFTLUPLVCPQUASSILFABOFFBCADQSSUPNWLZBQEXK";
+} // namespace
+
+// ------------------------------------------------------------------------------------------------
+TEST_CASE("Latency quantiles", "[Hedging]")
+{
+    using namespace std::chrono_literals;
+
+    LatencyTracker latencies(10);
+    REQUIRE_FALSE(latencies.GetQuantile(0.9).has_value());
+
+    for (int i = 20; i >= 1; --i)
+    {
+        latencies.AddLatency(std::chrono::milliseconds(i));
+    }
+
+    // Only the 10 most recent latencies are kept, 1 to 10
+    REQUIRE(latencies.GetSampleCount() == 10);
+    REQUIRE(latencies.GetQuantile(0.9).value() == 9ms);
+    REQUIRE(latencies.GetQuantile(0.5).value() == 5ms);
+    REQUIRE(latencies.GetQuantile(0.0).value() == 1ms);
+    REQUIRE(latencies.GetQuantile(1.0).value() == 10ms);
+}
+
+// ------------------------------------------------------------------------------------------------
+TEST_CASE("Hedged requests", "[Hedging]")
+{
+    using namespace std::chrono_literals;
+
+    AsyncEngine engine;
+    HedgingPolicy policy;
+    policy.defaultDelay = 100ms;
+    RequestHedger hedger(engine, policy);
+
+    const auto getTick = [&](const std::vector<NodeAddress>& nodes,
+                             std::chrono::milliseconds timeout) {
+        auto promise =
+            std::make_shared<std::promise<tl::expected<CurrentTickInfo, ConnectionError>>>();
+        auto future = promise->get_future();
+        GetCurrentTickInfoAsync(hedger, nodes, FulfillPromise(promise), timeout);
+        return future.get();
+    };
+
+    SECTION("A fast first node answers alone")
+    {
+        DelayedServer first(TickInfoFrame(1), 0ms);
+        DelayedServer second(TickInfoFrame(2), 0ms);
+
+        auto info = getTick({first.GetNode(), second.GetNode()}, 5s);
+        REQUIRE(info.has_value());
+        REQUIRE(info->tick == 1);
+        REQUIRE(hedger.GetLatencies().GetSampleCount() == 1);
+    }
+
+    SECTION("The next node is asked once the first is slow")
+    {
+        DelayedServer slow(TickInfoFrame(1), 2s);
+        DelayedServer fast(TickInfoFrame(2), 0ms);
+
+        const auto start = std::chrono::steady_clock::now();
+        auto info = getTick({slow.GetNode(), fast.GetNode()}, 5s);
+        REQUIRE(info.has_value());
+        REQUIRE(info->tick == 2);
+        REQUIRE(std::chrono::steady_clock::now() - start < 1s);
+    }
+
+    SECTION("A failing node is replaced right away")
+    {
+        DelayedServer server(TickInfoFrame(2), 0ms);
+
+        auto info = getTick({deadNode, server.GetNode()}, 5s);
+        REQUIRE(info.has_value());
+        REQUIRE(info->tick == 2);
+    }
+
+    SECTION("The last error is returned if every node fails")
+    {
+        auto info = getTick({deadNode, deadNode}, 5s);
+        REQUIRE_FALSE(info.has_value());
+
+        info = getTick({}, 5s);
+        REQUIRE_FALSE(info.has_value());
+        REQUIRE(info.error().message == "No nodes to send the request to");
+    }
+
+    SECTION("The delay follows the observed latencies")
+    {
+        DelayedServer server(TickInfoFrame(1), 0ms);
+        REQUIRE(hedger.GetDelay() == 100ms);
+
+        for (size_t i = 0; i < policy.minimumSampleCount; ++i)
+        {
+            REQUIRE(getTick({server.GetNode()}, 5s).has_value());
+        }
+        REQUIRE(hedger.GetDelay() < 100ms);
+        REQUIRE(hedger.GetDelay() >= policy.minimumDelay);
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+TEST_CASE("Hedged requests report to a node registry", "[Hedging]")
+{
+    using namespace std::chrono_literals;
+
+    AsyncEngine engine;
+    NodeRegistry registry;
+    RequestHedger hedger(engine, registry);
+    DelayedServer server(TickInfoFrame(1), 0ms);
+
+    auto promise =
+        std::make_shared<std::promise<tl::expected<CurrentTickInfo, ConnectionError>>>();
+    auto future = promise->get_future();
+    GetCurrentTickInfoAsync(hedger, {deadNode, server.GetNode()}, FulfillPromise(promise));
+    REQUIRE(future.get().has_value());
+
+    for (const auto& health : registry.GetHealth())
+    {
+        if (health.node.port == deadNode.port)
+        {
+            REQUIRE(health.consecutiveFailures == 1);
+        }
+        else
+        {
+            REQUIRE(health.lastSeen.has_value());
+            REQUIRE(health.roundTripTime > 0.0);
+        }
+    }
+    REQUIRE(registry.GetHealth().size() == 2);
+}
+
+// ------------------------------------------------------------------------------------------------
+TEST_CASE("Requests that nodes must agree on", "[Hedging]")
+{
+    using namespace std::chrono_literals;
+
+    AsyncEngine engine;
+    const auto getBalance = [&](const std::vector<NodeAddress>& nodes, size_t requiredCount) {
+        auto promise =
+            std::make_shared<std::promise<tl::expected<unsigned long long, ConnectionError>>>();
+        auto future = promise->get_future();
+        GetBalanceAsync(engine, nodes, identity, requiredCount, FulfillPromise(promise), 5s);
+        return future.get();
+    };
+
+    // Nodes at different ticks agree on the same balance
+    DelayedServer first(EntityFrame(5, 100), 0ms);
+    DelayedServer second(EntityFrame(5, 101), 20ms);
+    DelayedServer other(EntityFrame(7, 100), 0ms);
+
+    SECTION("Enough nodes agree")
+    {
+        auto balance = getBalance({first.GetNode(), other.GetNode(), second.GetNode()}, 2);
+        REQUIRE(balance.has_value());
+        REQUIRE(balance.value() == 5);
+    }
+
+    SECTION("Too few nodes agree")
+    {
+        auto balance = getBalance({first.GetNode(), other.GetNode(), second.GetNode()}, 3);
+        REQUIRE_FALSE(balance.has_value());
+        REQUIRE(balance.error().message.rfind("Only ", 0) == 0);
+
+        balance = getBalance({first.GetNode(), deadNode}, 2);
+        REQUIRE_FALSE(balance.has_value());
+    }
+
+    SECTION("Too few nodes are given")
+    {
+        auto balance = getBalance({first.GetNode()}, 2);
+        REQUIRE_FALSE(balance.has_value());
+        REQUIRE(balance.error().message == "Agreement of 2 nodes required, but 1 nodes given");
+    }
+}
+
+#endif
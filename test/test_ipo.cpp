@@ -0,0 +1,76 @@
+#include <catch.hpp>
+
+#include <memory>
+
+#include "core/four_q.h"
+#include "network/ipo.hpp"
+
+// ------------------------------------------------------------------------------------------------
+TEST_CASE("Contract IPO bids", "[IPO]")
+{
+    const auto signingKey =
+        CreateSigningKey("aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa").value();
+
+    SECTION("Order book")
+    {
+        auto ipo = std::make_unique<RespondContractIPO>();
+        memset(ipo.get(), 0, sizeof(RespondContractIPO));
+        REQUIRE(GetMinimumWinningPrice(*ipo) == 0);
+
+        for (unsigned int i = 0; i < NUMBER_OF_COMPUTORS; ++i)
+        {
+            ipo->prices[i] = 1000 + (i * 7919) % NUMBER_OF_COMPUTORS;
+            if (i % 100 == 0)
+            {
+                memcpy(ipo->publicKeys[i].m256i_u8, signingKey->GetPublicKey(), 32);
+            }
+        }
+        REQUIRE(GetMinimumWinningPrice(*ipo) == 1000);
+        REQUIRE(GetWinningShareCount(*ipo, signingKey->GetPublicKey()) == 7);
+    }
+
+    SECTION("Bid transaction")
+    {
+        TransactionBuilder builder(signingKey);
+        auto receipt = AddIPOBid(builder, 7, 5000, 3, 12345678);
+        REQUIRE(receipt.has_value());
+        REQUIRE(receipt->recipient == GetContractIdentity(7));
+        REQUIRE(receipt->amount == 0);
+
+        const char* data = builder.GetData();
+        Transaction transaction;
+        ContractIPOBid bid;
+        memcpy(&transaction, data + sizeof(RequestResponseHeader), sizeof(transaction));
+        memcpy(&bid, data + sizeof(RequestResponseHeader) + sizeof(transaction), sizeof(bid));
+        REQUIRE(transaction.destinationPublicKey.m256i_u64[0] == 7);
+        REQUIRE(transaction.inputType == 0);
+        REQUIRE(transaction.inputSize == sizeof(ContractIPOBid));
+        REQUIRE(transaction.tick == 12345678);
+        REQUIRE(bid.price == 5000);
+        REQUIRE(bid.quantity == 3);
+
+        REQUIRE_FALSE(AddIPOBid(builder, 7, 0, 3, 12345678).has_value());
+        REQUIRE_FALSE(AddIPOBid(builder, 7, 5000, 0, 12345678).has_value());
+        REQUIRE_FALSE(AddIPOBid(builder, 7, 5000, NUMBER_OF_COMPUTORS + 1, 12345678).has_value());
+        REQUIRE_FALSE(AddIPOBid(builder, 7, MAX_AMOUNT, 2, 12345678).has_value());
+        REQUIRE(builder.GetReceipts().size() == 1);
+    }
+
+    SECTION("Missed ticks are not submitted")
+    {
+        using namespace std::chrono_literals;
+
+        TickTracker tracker;
+        REQUIRE_FALSE(
+            SubmitIPOBidAtTick({}, signingKey, tracker, 7, 5000, 3, 1000, 3, 100ms).has_value());
+
+        CurrentTickInfo info{};
+        info.tickDuration = 2000;
+        info.tick = 1000;
+        tracker.AddSample(info, TickTracker::Clock::now());
+
+        auto result = SubmitIPOBidAtTick({}, signingKey, tracker, 7, 5000, 3, 1000, 3, 100ms);
+        REQUIRE_FALSE(result.has_value());
+        REQUIRE(result.error().message == "Missed tick 1000, the current tick is 1000");
+    }
+}
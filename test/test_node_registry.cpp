@@ -0,0 +1,233 @@
+#include <catch.hpp>
+
+#include "network/node_registry.hpp"
+
+#include <thread>
+
+#ifndef _MSC_VER
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#endif
+
+// ------------------------------------------------------------------------------------------------
+namespace
+{
+/**
+ * Check if two nodes are the same
+ * @param a The first node
+ * @param b The second node
+ * @return `true` if equal, else `false`
+ */
+bool IsSameNode(const NodeAddress& a, const NodeAddress& b)
+{
+    return a.ipAddress == b.ipAddress && a.port == b.port;
+}
+} // namespace
+
+// ------------------------------------------------------------------------------------------------
+TEST_CASE("Select nodes by health", "[NodeRegistry]")
+{
+    using namespace std::chrono_literals;
+
+    const NodeAddress fast{"10.0.0.1", 21841};
+    const NodeAddress slow{"10.0.0.2", 21841};
+    const NodeAddress unknown{"10.0.0.3", 21841};
+
+    NodeRegistry registry;
+    REQUIRE(registry.SelectNodes().empty());
+
+    registry.AddNode(unknown);
+    registry.ReportSuccess(slow, 300ms);
+    registry.ReportSuccess(fast, 20ms);
+
+    SECTION("Faster nodes first, unknown nodes after known ones")
+    {
+        auto nodes = registry.SelectNodes();
+        REQUIRE(nodes.size() == 3);
+        REQUIRE(IsSameNode(nodes[0], fast));
+        REQUIRE(IsSameNode(nodes[1], slow));
+        REQUIRE(IsSameNode(nodes[2], unknown));
+
+        nodes = registry.SelectNodes(1);
+        REQUIRE(nodes.size() == 1);
+        REQUIRE(IsSameNode(nodes[0], fast));
+    }
+
+    SECTION("Nodes that lag behind are selected later")
+    {
+        registry.ReportTick(slow, 1000);
+        registry.ReportTick(fast, 990);
+
+        auto nodes = registry.SelectNodes();
+        REQUIRE(IsSameNode(nodes[0], slow));
+
+        for (const auto& health : registry.GetHealth())
+        {
+            if (IsSameNode(health.node, fast))
+            {
+                REQUIRE(health.tickLag == 10);
+                REQUIRE(health.lastTick == 990);
+            }
+        }
+    }
+
+    SECTION("Failures raise the error rate")
+    {
+        registry.ReportFailure(fast);
+        registry.ReportSuccess(fast, 20ms);
+        registry.ReportFailure(fast);
+
+        for (const auto& health : registry.GetHealth())
+        {
+            if (IsSameNode(health.node, fast))
+            {
+                REQUIRE(health.errorRate > 0.1);
+                REQUIRE(health.consecutiveFailures == 1);
+                REQUIRE_FALSE(health.retryTime.has_value());
+            }
+        }
+    }
+
+    SECTION("Removed nodes are not selected")
+    {
+        registry.RemoveNode(fast);
+        REQUIRE(registry.SelectNodes().size() == 2);
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+TEST_CASE("Circuit breakers of failing nodes", "[NodeRegistry]")
+{
+    using namespace std::chrono_literals;
+
+    const NodeAddress healthy{"10.0.0.1", 21841};
+    const NodeAddress failing{"10.0.0.2", 21841};
+
+    NodeRegistry registry;
+    registry.ReportSuccess(healthy, 500ms);
+    registry.ReportSuccess(failing, 10ms);
+
+    for (unsigned int i = 0; i < NodeRegistry::failureThreshold; ++i)
+    {
+        REQUIRE(registry.SelectNodes().size() == 2);
+        registry.ReportFailure(failing);
+    }
+
+    // Tripped, skipped until the backoff passed
+    auto nodes = registry.SelectNodes();
+    REQUIRE(nodes.size() == 1);
+    REQUIRE(IsSameNode(nodes[0], healthy));
+
+    // Failures of calls that were in flight don't extend the backoff
+    registry.ReportFailure(failing);
+
+    // Selected after the healthy nodes once the backoff passed
+    std::this_thread::sleep_for(NodeRegistry::minimumBackoff + 50ms);
+    nodes = registry.SelectNodes();
+    REQUIRE(nodes.size() == 2);
+    REQUIRE(IsSameNode(nodes[1], failing));
+
+    SECTION("Failing again doubles the backoff")
+    {
+        const auto start = NodeHealth::Clock::now();
+        registry.ReportFailure(failing);
+        REQUIRE(registry.SelectNodes().size() == 1);
+
+        for (const auto& health : registry.GetHealth())
+        {
+            if (IsSameNode(health.node, failing))
+            {
+                REQUIRE(health.retryTime.value() - start >= 2 * NodeRegistry::minimumBackoff);
+            }
+        }
+    }
+
+    SECTION("A success closes the breaker")
+    {
+        registry.ReportSuccess(failing, 10ms);
+        nodes = registry.SelectNodes();
+        REQUIRE(nodes.size() == 2);
+        REQUIRE(IsSameNode(nodes[0], failing));
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+TEST_CASE("Timeouts follow the latencies of a node", "[NodeRegistry]")
+{
+    using namespace std::chrono_literals;
+
+    const NodeAddress node{"10.0.0.1", 21841};
+    NodeRegistry registry;
+    REQUIRE(registry.GetTimeout(node) == NodeRegistry::defaultTimeout);
+
+    for (int i = 0; i < 20; ++i)
+    {
+        registry.ReportSuccess(node, 100ms);
+    }
+    REQUIRE(registry.GetLatency(node, 0.9).value() == 100ms);
+    REQUIRE(registry.GetTimeout(node) == 300ms);
+
+    const NodeAddress nearNode{"10.0.0.2", 21841};
+    for (int i = 0; i < 20; ++i)
+    {
+        registry.ReportSuccess(nearNode, 1ms);
+    }
+    REQUIRE(registry.GetTimeout(nearNode) == NodeRegistry::minimumTimeout);
+}
+
+#ifndef _MSC_VER
+
+// ------------------------------------------------------------------------------------------------
+TEST_CASE("Connect to the best available node", "[NodeRegistry]")
+{
+    // Accepts connections without ever answering
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(listener, (const sockaddr*)&address, sizeof(address));
+    listen(listener, 16);
+    socklen_t length = sizeof(address);
+    getsockname(listener, (sockaddr*)&address, &length);
+
+    const NodeAddress live{"127.0.0.1", ntohs(address.sin_port)};
+    const NodeAddress dead{"127.0.0.1", 1};
+
+    NodeRegistry registry;
+    REQUIRE_FALSE(CreateConnection(registry).has_value());
+
+    registry.AddNode(dead);
+    registry.AddNode(live);
+    REQUIRE(CreateConnection(registry).has_value());
+
+    // Every failure is reported, until the dead node trips
+    for (unsigned int i = 0; i < NodeRegistry::failureThreshold; ++i)
+    {
+        REQUIRE_FALSE(CreateConnection(registry, dead).has_value());
+    }
+    auto nodes = registry.SelectNodes();
+    REQUIRE(nodes.size() == 1);
+    REQUIRE(IsSameNode(nodes[0], live));
+
+    // Cancelled calls don't count against the node
+    Deadline deadline;
+    deadline.token.Cancel();
+    REQUIRE_FALSE(CreateConnection(registry, live, deadline).has_value());
+    for (const auto& health : registry.GetHealth())
+    {
+        if (IsSameNode(health.node, live))
+        {
+            REQUIRE(health.lastSeen.has_value());
+            REQUIRE(health.consecutiveFailures == 0);
+        }
+    }
+
+    close(listener);
+}
+
+#endif
@@ -0,0 +1,308 @@
+#include <catch.hpp>
+
+#include "network/peer_crawler.hpp"
+#include "network_messages/tick.h"
+
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+#ifndef _MSC_VER
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#endif
+
+// ------------------------------------------------------------------------------------------------
+namespace
+{
+/**
+ * Check if two nodes are the same
+ * @param a The first node
+ * @param b The second node
+ * @return `true` if equal, else `false`
+ */
+bool IsSameNode(const NodeAddress& a, const NodeAddress& b)
+{
+    return a.ipAddress == b.ipAddress && a.port == b.port;
+}
+
+/**
+ * Create a peer exchange
+ * @param peers The ip-addresses of the peers, unused slots are zero
+ * @return The peer exchange
+ */
+ExchangePublicPeers CreatePeers(std::vector<std::array<unsigned char, 4>> peers)
+{
+    ExchangePublicPeers exchange{};
+    for (size_t i = 0; i < peers.size() && i < NUMBER_OF_EXCHANGED_PEERS; ++i)
+    {
+        memcpy(exchange.peers[i].u8, peers[i].data(), 4);
+    }
+    return exchange;
+}
+
+#ifndef _MSC_VER
+
+// ------------------------------------------------------------------------------------------------
+/**
+ * Node that shares its peers on accepting a connection and answers tick info requests, one client
+ * after the other
+ */
+class PeerServer
+{
+public:
+    /**
+     * Constructor, listens on an ephemeral port
+     * @param peers The peers to share
+     * @param bAllLoopback `true` to accept connections on every loopback address, e.g. 127.0.0.2,
+     * else only on 127.0.0.1
+     */
+    PeerServer(const ExchangePublicPeers& peers, bool bAllLoopback)
+    {
+        m_listener = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(bAllLoopback ? INADDR_ANY : INADDR_LOOPBACK);
+        bind(m_listener, (const sockaddr*)&address, sizeof(address));
+        listen(m_listener, 64);
+
+        socklen_t length = sizeof(address);
+        getsockname(m_listener, (sockaddr*)&address, &length);
+        m_port = ntohs(address.sin_port);
+
+        m_thread = std::thread([this, peers]() {
+            while (true)
+            {
+                int client = accept(m_listener, nullptr, nullptr);
+                if (client < 0)
+                {
+                    break;
+                }
+
+                Send(client, ExchangePublicPeers::type, peers);
+
+                RequestResponseHeader request;
+                if (recv(client, &request, sizeof(request), MSG_WAITALL) > 0)
+                {
+                    CurrentTickInfo info{};
+                    info.tick = 1000;
+                    Send(client, RESPOND_CURRENT_TICK_INFO, info);
+                }
+                close(client);
+            }
+        });
+    }
+
+    /**
+     * Destructor
+     */
+    ~PeerServer()
+    {
+        shutdown(m_listener, SHUT_RDWR);
+        m_thread.join();
+        close(m_listener);
+    }
+
+    /**
+     * Get the node address
+     * @return The address of the server
+     */
+    NodeAddress GetNode() const { return {"127.0.0.1", m_port}; }
+
+private:
+    /**
+     * Send a frame
+     * @param client The client socket
+     * @param type The header type
+     * @param payload The payload
+     */
+    template <typename T>
+    static void Send(int client, unsigned char type, const T& payload)
+    {
+        RequestResponseHeader header;
+        header.checkAndSetSize(sizeof(header) + sizeof(payload));
+        header.setType(type);
+        header.setDejavu(0);
+        std::string frame((const char*)&header, sizeof(header));
+        frame.append((const char*)&payload, sizeof(payload));
+        send(client, frame.data(), frame.size(), MSG_NOSIGNAL);
+    }
+
+private:
+    int m_listener;
+    unsigned short m_port;
+    std::thread m_thread;
+};
+
+#endif
+} // namespace
+
+// ------------------------------------------------------------------------------------------------
+TEST_CASE("Read shared peers", "[PeerCrawler]")
+{
+    auto nodes = GetPeerNodes(CreatePeers({{1, 2, 3, 4}, {0, 0, 0, 0}, {10, 0, 0, 255}}), 21841);
+    REQUIRE(nodes.size() == 2);
+    REQUIRE(IsSameNode(nodes[0], {"1.2.3.4", 21841}));
+    REQUIRE(IsSameNode(nodes[1], {"10.0.0.255", 21841}));
+
+    REQUIRE(GetPeerNodes(CreatePeers({}), 21841).empty());
+}
+
+// ------------------------------------------------------------------------------------------------
+TEST_CASE("Save and load the peer table", "[PeerCrawler]")
+{
+    using namespace std::chrono_literals;
+
+    const auto path = (std::filesystem::temp_directory_path() / "qwallet_test_peers.txt").string();
+    std::filesystem::remove(path);
+
+    const NodeAddress fast{"10.0.0.1", 21841};
+    const NodeAddress slow{"10.0.0.2", 21841};
+    const NodeAddress unknown{"10.0.0.3", 21841};
+
+    SECTION("Nodes are loaded in the order they were ranked")
+    {
+        NodeRegistry registry;
+        registry.AddNode(unknown);
+        registry.ReportSuccess(slow, 300ms);
+        registry.ReportSuccess(fast, 20ms);
+
+        auto saved = SavePeerTable(registry, path);
+        REQUIRE(saved.has_value());
+        REQUIRE(saved.value() == 3);
+
+        NodeRegistry loaded;
+        auto count = LoadPeerTable(loaded, path);
+        REQUIRE(count.has_value());
+        REQUIRE(count.value() == 3);
+
+        auto nodes = loaded.SelectNodes();
+        REQUIRE(nodes.size() == 3);
+        REQUIRE(IsSameNode(nodes[0], fast));
+        REQUIRE(IsSameNode(nodes[1], slow));
+        REQUIRE(IsSameNode(nodes[2], unknown));
+
+        // Only the best nodes are saved
+        REQUIRE(SavePeerTable(registry, path, 1).value() == 1);
+        NodeRegistry best;
+        REQUIRE(LoadPeerTable(best, path).value() == 1);
+        REQUIRE(IsSameNode(best.SelectNodes()[0], fast));
+    }
+
+    SECTION("Invalid lines are skipped")
+    {
+        {
+            std::ofstream file(path);
+            file << "10.0.0.1 21841 20\n"
+                 << "garbage\n"
+                 << "300.0.0.1 21841 5\n"
+                 << "10.0.0.2 0 5\n"
+                 << "10.0.0.3 21841\n";
+        }
+
+        NodeRegistry registry;
+        REQUIRE(LoadPeerTable(registry, path).value() == 1);
+        REQUIRE(registry.GetHealth().size() == 1);
+    }
+
+    SECTION("A missing table is an error")
+    {
+        NodeRegistry registry;
+        REQUIRE_FALSE(LoadPeerTable(registry, path).has_value());
+    }
+
+    std::filesystem::remove(path);
+}
+
+#ifndef _MSC_VER
+
+// ------------------------------------------------------------------------------------------------
+TEST_CASE("Crawl the peers of nodes", "[PeerCrawler]")
+{
+    using namespace std::chrono_literals;
+
+    SECTION("Shared peers are probed and added")
+    {
+        // Every loopback address reaches the same server
+        PeerServer server(CreatePeers({{127, 0, 0, 2}, {127, 0, 0, 3}}), true);
+        NodeRegistry registry;
+        registry.AddNode(server.GetNode());
+
+        PeerCrawler crawler(registry);
+        REQUIRE(crawler.Crawl() == 2);
+
+        auto health = registry.GetHealth();
+        REQUIRE(health.size() == 3);
+        for (const auto& node : health)
+        {
+            REQUIRE(node.node.port == server.GetNode().port);
+            REQUIRE(node.lastTick == 1000);
+            REQUIRE(node.lastSeen.has_value());
+        }
+
+        // Nothing new the next round
+        REQUIRE(crawler.Crawl() == 0);
+    }
+
+    SECTION("Peers that never answer are dropped")
+    {
+        // Only 127.0.0.1 reaches the server
+        PeerServer server(CreatePeers({{127, 0, 0, 2}}), false);
+        const NodeAddress dead{"127.0.0.2", server.GetNode().port};
+        NodeRegistry registry;
+        registry.AddNode(server.GetNode());
+
+        PeerCrawler crawler(registry);
+        REQUIRE(crawler.Crawl() == 1);
+        REQUIRE(registry.GetHealth().size() == 2);
+
+        for (unsigned int i = 0; i < NodeRegistry::failureThreshold; ++i)
+        {
+            registry.ReportFailure(dead);
+        }
+        REQUIRE(crawler.Crawl() == 0);
+
+        auto health = registry.GetHealth();
+        REQUIRE(health.size() == 1);
+        REQUIRE(IsSameNode(health[0].node, server.GetNode()));
+
+        // Not added again once dropped
+        REQUIRE(crawler.Crawl() == 0);
+        REQUIRE(registry.GetHealth().size() == 1);
+    }
+
+    SECTION("The background crawler writes the peer table")
+    {
+        const auto path =
+            (std::filesystem::temp_directory_path() / "qwallet_test_crawled_peers.txt").string();
+        std::filesystem::remove(path);
+
+        PeerServer server(CreatePeers({{127, 0, 0, 2}}), true);
+        NodeRegistry registry;
+        registry.AddNode(server.GetNode());
+
+        {
+            PeerCrawler crawler(registry, path, 50ms);
+            crawler.Start();
+
+            const auto deadline = std::chrono::steady_clock::now() + 10s;
+            while (!std::filesystem::exists(path) && std::chrono::steady_clock::now() < deadline)
+            {
+                std::this_thread::sleep_for(10ms);
+            }
+        }
+
+        NodeRegistry loaded;
+        REQUIRE(LoadPeerTable(loaded, path).value() == 2);
+        std::filesystem::remove(path);
+    }
+}
+
+#endif
@@ -0,0 +1,136 @@
+#include <catch.hpp>
+
+#include "network/request_coalescer.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+// ------------------------------------------------------------------------------------------------
+TEST_CASE("Share identical requests in flight", "[RequestCoalescer]")
+{
+    using namespace std::chrono_literals;
+
+    RequestCoalescer coalescer;
+    const RequestKey key{1, "payload"};
+
+    SECTION("Callers of a key in flight receive the response of the first")
+    {
+        int startCount = 0;
+        AsyncCallback<int> complete;
+        const auto start = [&](AsyncCallback<int> completion) {
+            ++startCount;
+            complete = std::move(completion);
+        };
+
+        std::vector<int> results;
+        for (int i = 0; i < 3; ++i)
+        {
+            coalescer.Join<int>(
+                key,
+                [&](tl::expected<int, ConnectionError> result) { results.push_back(*result); },
+                start);
+        }
+        REQUIRE(startCount == 1);
+        REQUIRE(coalescer.GetInFlightCount() == 1);
+        REQUIRE(results.empty());
+
+        complete(42);
+        REQUIRE(results == std::vector<int>{42, 42, 42});
+        REQUIRE(coalescer.GetInFlightCount() == 0);
+
+        // Nothing is cached, the next caller starts a new request
+        coalescer.Join<int>(key, [&](tl::expected<int, ConnectionError>) {}, start);
+        REQUIRE(startCount == 2);
+        complete(43);
+    }
+
+    SECTION("Requests of different keys or types are not shared")
+    {
+        int startCount = 0;
+        std::vector<AsyncCallback<int>> intCompletions;
+        const auto start = [&](AsyncCallback<int> completion) {
+            ++startCount;
+            intCompletions.push_back(std::move(completion));
+        };
+        const auto ignore = [](tl::expected<int, ConnectionError>) {};
+
+        coalescer.Join<int>(key, ignore, start);
+        coalescer.Join<int>({2, "payload"}, ignore, start);
+        coalescer.Join<int>({1, "other payload"}, ignore, start);
+        coalescer.Join<int>({1, "payload", "127.0.0.1:21841"}, ignore, start);
+        REQUIRE(startCount == 4);
+
+        bool bStarted = false;
+        coalescer.Join<long long>(
+            key,
+            [](tl::expected<long long, ConnectionError>) {},
+            [&](AsyncCallback<long long> completion) {
+                bStarted = true;
+                completion(1);
+            });
+        REQUIRE(bStarted);
+        REQUIRE(coalescer.GetInFlightCount() == 4);
+
+        for (auto& complete : intCompletions)
+        {
+            complete(0);
+        }
+        REQUIRE(coalescer.GetInFlightCount() == 0);
+    }
+
+    SECTION("Errors are shared too")
+    {
+        std::vector<std::string> errors;
+        AsyncCallback<int> complete;
+        for (int i = 0; i < 2; ++i)
+        {
+            coalescer.Join<int>(
+                key,
+                [&](tl::expected<int, ConnectionError> result) {
+                    errors.push_back(result.error().message);
+                },
+                [&](AsyncCallback<int> completion) { complete = std::move(completion); });
+        }
+
+        complete(tl::make_unexpected(ConnectionError{"Failed"}));
+        REQUIRE(errors == std::vector<std::string>{"Failed", "Failed"});
+    }
+
+    SECTION("Blocking callers wait for the request in flight")
+    {
+        std::atomic<int> requestCount = 0;
+        std::promise<void> release;
+        auto released = release.get_future().share();
+        const auto request = [&]() -> tl::expected<int, ConnectionError> {
+            ++requestCount;
+            released.wait();
+            return 7;
+        };
+
+        std::vector<std::thread> threads;
+        std::vector<int> results(8);
+        threads.emplace_back([&]() { results[0] = coalescer.Run<int>(key, request).value(); });
+        while (coalescer.GetInFlightCount() == 0)
+        {
+            std::this_thread::yield();
+        }
+        for (size_t i = 1; i < results.size(); ++i)
+        {
+            threads.emplace_back(
+                [&, i]() { results[i] = coalescer.Run<int>(key, request).value(); });
+        }
+
+        // Give the callers time to join, the request can't complete before
+        std::this_thread::sleep_for(100ms);
+        release.set_value();
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+
+        REQUIRE(requestCount == 1);
+        REQUIRE(results == std::vector<int>(8, 7));
+        REQUIRE(coalescer.GetInFlightCount() == 0);
+    }
+}
@@ -0,0 +1,112 @@
+#include <catch.hpp>
+
+#include <random>
+
+#include "core/four_q.h"
+#include "network/send_to_many.hpp"
+
+// ------------------------------------------------------------------------------------------------
+TEST_CASE("Pay out transfers with SendToMany", "[SendToMany]")
+{
+    std::mt19937 generator(34);
+
+    const auto signingKey =
+        CreateSigningKey("aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa").value();
+
+    std::vector<Transfer> transfers(53);
+    for (auto& transfer : transfers)
+    {
+        unsigned char publicKey[32];
+        for (auto& byte : publicKey)
+        {
+            byte = (unsigned char)generator();
+        }
+        char identity[61] = {0};
+        getIdentity(publicKey, identity, false);
+        transfer.recipient = identity;
+        transfer.amount = 1 + generator() % 1000000;
+    }
+
+    REQUIRE(GetQutilIdentity() == "EAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAVWRF");
+    REQUIRE(GetSendToManyCallCount(0) == 0);
+    REQUIRE(GetSendToManyCallCount(25) == 1);
+    REQUIRE(GetSendToManyCallCount(53) == 3);
+
+    long long total = 0;
+    for (const auto& transfer : transfers)
+    {
+        total += transfer.amount;
+    }
+    REQUIRE(GetSendToManyCost(transfers) == total + 3 * sendToManyFee);
+
+    SECTION("Transfers are split over calls at consecutive ticks")
+    {
+        const unsigned int tick = 12345678;
+        TransactionBuilder builder(signingKey);
+        auto receipts = AddSendToMany(builder, transfers, tick);
+        REQUIRE(receipts.has_value());
+        REQUIRE(receipts->size() == 3);
+
+        const char* data = builder.GetData();
+        size_t offset = 0;
+        for (size_t i = 0; i < receipts->size(); ++i)
+        {
+            INFO("call " << i);
+            const auto& receipt = receipts->at(i);
+            REQUIRE(receipt.recipient == GetQutilIdentity());
+            REQUIRE(receipt.tick == tick + i);
+
+            RequestResponseHeader header;
+            Transaction transaction;
+            SendToManyInput input;
+            memcpy(&header, data + offset, sizeof(header));
+            memcpy(&transaction, data + offset + sizeof(header), sizeof(transaction));
+            memcpy(&input, data + offset + sizeof(header) + sizeof(transaction), sizeof(input));
+            REQUIRE(transaction.inputType == sendToManyInputType);
+            REQUIRE(transaction.inputSize == sizeof(SendToManyInput));
+
+            long long amount = sendToManyFee;
+            for (size_t slot = 0; slot < sendToManyMaxRecipients; ++slot)
+            {
+                const size_t j = i * sendToManyMaxRecipients + slot;
+                if (j < transfers.size())
+                {
+                    unsigned char publicKey[32];
+                    getPublicKeyFromIdentity(
+                        (const unsigned char*)transfers[j].recipient.data(),
+                        publicKey);
+                    REQUIRE(memcmp(input.publicKeys[slot], publicKey, 32) == 0);
+                    REQUIRE(input.amounts[slot] == transfers[j].amount);
+                    amount += transfers[j].amount;
+                }
+                else
+                {
+                    REQUIRE(input.amounts[slot] == 0);
+                }
+            }
+            REQUIRE(transaction.amount == amount);
+            REQUIRE(receipt.amount == amount);
+
+            offset += header.size();
+        }
+        REQUIRE(offset == builder.GetSize());
+    }
+
+    SECTION("Invalid transfers add nothing")
+    {
+        TransactionBuilder builder(signingKey);
+
+        REQUIRE_FALSE(AddSendToMany(builder, {}, 1).has_value());
+
+        transfers[40].amount = 0;
+        REQUIRE_FALSE(AddSendToMany(builder, transfers, 1).has_value());
+
+        transfers[40].amount = 1;
+        transfers[52].recipient[0] = 'a';
+        auto result = AddSendToMany(builder, transfers, 1);
+        REQUIRE_FALSE(result.has_value());
+        REQUIRE(result.error().message.find("identity") != std::string::npos);
+
+        REQUIRE(builder.GetSize() == 0);
+    }
+}
@@ -0,0 +1,93 @@
+#include <catch.hpp>
+
+#include <random>
+
+#include "core/four_q.h"
+#include "crypto/signing_key.hpp"
+#include "wallet.hpp"
+
+// ------------------------------------------------------------------------------------------------
+TEST_CASE("Signing key creation", "[SigningKey]")
+{
+    // invalid seed
+    {
+        auto result = CreateSigningKey("abcde");
+        REQUIRE(result.has_value() == false);
+        REQUIRE(result.error().message == "The seed length is invalid");
+    }
+
+    // valid seed
+    {
+        const std::string seed = "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa";
+
+        auto result = CreateSigningKey(seed);
+        REQUIRE(result.has_value());
+
+        auto wallet = GenerateWallet(seed).value();
+        REQUIRE(result.value()->GetIdentity() == wallet.identity);
+
+        unsigned char publicKey[32];
+        REQUIRE(getPublicKeyFromIdentity(
+            (const unsigned char*)wallet.identity.data(),
+            publicKey));
+        REQUIRE(memcmp(result.value()->GetPublicKey(), publicKey, 32) == 0);
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+TEST_CASE("Signing key signatures match sign", "[SigningKey]")
+{
+    std::mt19937 generator(31);
+
+    std::string seed(55, 'a');
+    for (auto& c : seed)
+    {
+        c = (char)('a' + generator() % 26);
+    }
+    const auto signingKey = CreateSigningKey(seed).value();
+
+    unsigned char subseed[32];
+    getSubseed((const unsigned char*)seed.data(), subseed);
+
+    for (int i = 0; i < 20; ++i)
+    {
+        unsigned char digest[32], expected[64], actual[64];
+        for (auto& byte : digest)
+        {
+            byte = (unsigned char)generator();
+        }
+
+        sign(subseed, signingKey->GetPublicKey(), digest, expected);
+        signingKey->Sign(digest, actual);
+        REQUIRE(memcmp(expected, actual, 64) == 0);
+        REQUIRE(verify(signingKey->GetPublicKey(), digest, actual));
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+TEST_CASE("Signing key batch signatures match single signatures", "[SigningKey]")
+{
+    std::mt19937 generator(32);
+
+    const auto signingKey =
+        CreateSigningKey("bbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbb").value();
+
+    // not a multiple of four, so the remainder path is exercised as well
+    constexpr unsigned int count = 11;
+    unsigned char digests[count][32], signatures[count][64];
+    for (auto& digest : digests)
+    {
+        for (auto& byte : digest)
+        {
+            byte = (unsigned char)generator();
+        }
+    }
+
+    signingKey->Sign(digests[0], count, signatures[0]);
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        unsigned char expected[64];
+        signingKey->Sign(digests[i], expected);
+        REQUIRE(memcmp(expected, signatures[i], 64) == 0);
+    }
+}
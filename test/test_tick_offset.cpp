@@ -0,0 +1,97 @@
+#include <catch.hpp>
+
+#include "network/tick_offset.hpp"
+
+// ------------------------------------------------------------------------------------------------
+TEST_CASE("Estimate tick offset", "[TickOffsetEstimator]")
+{
+    TickOffsetEstimator estimator(0.9);
+    REQUIRE(estimator.GetTickOffset() == TickOffsetEstimator::defaultOffset);
+
+    SECTION("Offset follows tick duration and latency")
+    {
+        for (int i = 0; i < 20; ++i)
+        {
+            estimator.AddTickDuration(2000);
+            estimator.AddLatency(500);
+        }
+        REQUIRE(estimator.GetTickOffset() == TickOffsetEstimator::minimumOffset + 1);
+
+        // a slow tail of latencies beyond the target quantile is ignored
+        estimator.AddLatency(30000);
+        REQUIRE(estimator.GetTickOffset() == TickOffsetEstimator::minimumOffset + 1);
+
+        // slow connections need more ticks
+        for (int i = 0; i < 20; ++i)
+        {
+            estimator.AddLatency(5000);
+        }
+        REQUIRE(estimator.GetTickOffset() == TickOffsetEstimator::minimumOffset + 3);
+
+        // faster ticks need more ticks as well
+        for (int i = 0; i < 64; ++i)
+        {
+            estimator.AddTickDuration(1000);
+        }
+        REQUIRE(estimator.GetTickOffset() == TickOffsetEstimator::minimumOffset + 5);
+
+        // zero durations are ignored
+        estimator.AddTickDuration(0);
+        REQUIRE(estimator.GetTickOffset() == TickOffsetEstimator::minimumOffset + 5);
+    }
+
+    SECTION("Outcomes correct the model")
+    {
+        for (int i = 0; i < 20; ++i)
+        {
+            estimator.AddTickDuration(2000);
+            estimator.AddLatency(500);
+        }
+        const auto offset = estimator.GetTickOffset();
+
+        // too few outcomes are not trusted
+        for (int i = 0; i < 5; ++i)
+        {
+            estimator.AddOutcome(offset, false);
+        }
+        REQUIRE(estimator.GetTickOffset() == offset);
+
+        // the model offset misses the target
+        for (int i = 0; i < 5; ++i)
+        {
+            estimator.AddOutcome(offset, i < 3);
+        }
+        REQUIRE(estimator.GetTickOffset() == offset + 1);
+
+        // the next offset misses the target as well
+        for (int i = 0; i < 10; ++i)
+        {
+            estimator.AddOutcome(offset + 1, i < 8);
+        }
+        REQUIRE(estimator.GetTickOffset() == offset + 2);
+
+        // the next offset recovers, the failing model offset keeps it from going lower
+        for (int i = 0; i < 10; ++i)
+        {
+            estimator.AddOutcome(offset + 1, true);
+            estimator.AddOutcome(offset - 1, true);
+        }
+        REQUIRE(estimator.GetTickOffset() == offset + 1);
+    }
+
+    SECTION("Smaller offsets that meet the target are preferred")
+    {
+        for (int i = 0; i < 20; ++i)
+        {
+            estimator.AddTickDuration(2000);
+            estimator.AddLatency(500);
+        }
+        const auto offset = estimator.GetTickOffset();
+
+        for (int i = 0; i < 10; ++i)
+        {
+            estimator.AddOutcome(offset - 1, true);
+        }
+        REQUIRE(estimator.GetTickOffset() == offset - 1);
+    }
+}
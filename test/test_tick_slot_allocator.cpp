@@ -0,0 +1,107 @@
+#include <catch.hpp>
+
+#include <set>
+#include <thread>
+
+#include "network/tick_slot_allocator.hpp"
+
+// ------------------------------------------------------------------------------------------------
+TEST_CASE("Allocate tick slots", "[TickSlotAllocator]")
+{
+    std::vector<SigningKeyPtr> sources;
+    for (char c : {'a', 'b', 'c'})
+    {
+        sources.push_back(CreateSigningKey(std::string(55, c)).value());
+    }
+
+    TickSlotAllocator allocator(sources);
+    REQUIRE(allocator.GetSourceCount() == 3);
+    REQUIRE(allocator.SetBalance(sources[0]->GetIdentity(), 100));
+    REQUIRE(allocator.SetBalance(sources[1]->GetIdentity(), 300));
+    REQUIRE(allocator.SetBalance(sources[2]->GetIdentity(), 200));
+    REQUIRE_FALSE(allocator.SetBalance(std::string(60, 'A'), 100));
+
+    SECTION("Load is spread over the pool")
+    {
+        // each source gets one slot at the minimum tick, largest balance first
+        auto slot = allocator.Allocate(50, 1000);
+        REQUIRE(slot.has_value());
+        REQUIRE(slot->source == sources[1]);
+        REQUIRE(slot->tick == 1000);
+
+        slot = allocator.Allocate(50, 1000);
+        REQUIRE(slot->source == sources[2]);
+        REQUIRE(slot->tick == 1000);
+
+        slot = allocator.Allocate(50, 1000);
+        REQUIRE(slot->source == sources[0]);
+        REQUIRE(slot->tick == 1000);
+
+        slot = allocator.Allocate(50, 1000);
+        REQUIRE(slot->source == sources[1]);
+        REQUIRE(slot->tick == 1001);
+
+        REQUIRE(allocator.GetBalance(sources[0]->GetIdentity()) == 50);
+        REQUIRE(allocator.GetBalance(sources[1]->GetIdentity()) == 200);
+
+        // a later minimum tick skips the gap
+        slot = allocator.Allocate(50, 2000);
+        REQUIRE(slot->tick == 2000);
+    }
+
+    SECTION("Sources that cannot afford a transfer are skipped")
+    {
+        auto slot = allocator.Allocate(250, 1000);
+        REQUIRE(slot->source == sources[1]);
+
+        REQUIRE_FALSE(allocator.Allocate(250, 1000).has_value());
+        REQUIRE_FALSE(allocator.Allocate(-1, 1000).has_value());
+
+        allocator.Release(slot.value(), 250);
+        REQUIRE(allocator.GetBalance(sources[1]->GetIdentity()) == 300);
+
+        // the released tick is not reused, the transaction may still be pending
+        slot = allocator.Allocate(250, 1000);
+        REQUIRE(slot->source == sources[1]);
+        REQUIRE(slot->tick == 1001);
+    }
+
+    SECTION("Concurrent allocations never collide")
+    {
+        for (const auto& source : sources)
+        {
+            allocator.SetBalance(source->GetIdentity(), 1000000);
+        }
+
+        std::vector<std::vector<TickSlot>> slots(4);
+        std::vector<std::thread> threads;
+        for (auto& threadSlots : slots)
+        {
+            threads.emplace_back([&] {
+                for (int i = 0; i < 250; ++i)
+                {
+                    threadSlots.push_back(allocator.Allocate(1, 1000).value());
+                }
+            });
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+
+        std::set<std::pair<std::string, unsigned int>> unique;
+        unsigned int lastTick = 0;
+        for (const auto& threadSlots : slots)
+        {
+            for (const auto& slot : threadSlots)
+            {
+                unique.emplace(slot.source->GetIdentity(), slot.tick);
+                lastTick = std::max(lastTick, slot.tick);
+            }
+        }
+        REQUIRE(unique.size() == 1000);
+
+        // 1000 transfers over 3 sources take 334 ticks
+        REQUIRE(lastTick == 1333);
+    }
+}
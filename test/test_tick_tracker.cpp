@@ -0,0 +1,62 @@
+#include <catch.hpp>
+
+#include "network/tick_tracker.hpp"
+
+// ------------------------------------------------------------------------------------------------
+TEST_CASE("Track the current tick", "[TickTracker]")
+{
+    using namespace std::chrono_literals;
+
+    TickTracker tracker;
+    REQUIRE_FALSE(tracker.GetTick().has_value());
+    REQUIRE_FALSE(tracker.GetTickInfo().has_value());
+    REQUIRE(tracker.GetTickDuration() == 0.0);
+
+    const auto start = TickTracker::Clock::now();
+    CurrentTickInfo info{};
+    info.tickDuration = 2000;
+    info.epoch = 100;
+    info.tick = 1000;
+    tracker.AddSample(info, start);
+
+    REQUIRE(tracker.GetTickInfo()->tick == 1000);
+    REQUIRE(tracker.GetTickDuration() == 2000.0);
+    REQUIRE(tracker.PredictTick(start - 1s).value() == 1000);
+    REQUIRE(tracker.PredictTick(start + 1s).value() == 1000);
+    REQUIRE(tracker.PredictTick(start + 5s).value() == 1002);
+
+    SECTION("Prediction is bounded")
+    {
+        REQUIRE(
+            tracker.PredictTick(start + 1h).value() == 1000 + TickTracker::maximumPredictedTicks);
+    }
+
+    SECTION("Tick start is estimated between samples")
+    {
+        // still the same tick one second later, the next tick is seen a second after that
+        tracker.AddSample(info, start + 1s);
+        info.tick = 1001;
+        tracker.AddSample(info, start + 2s);
+
+        // so tick 1001 started around 1.5 seconds
+        REQUIRE(tracker.PredictTick(start + 3400ms).value() == 1001);
+        REQUIRE(tracker.PredictTick(start + 3600ms).value() == 1002);
+    }
+
+    SECTION("Lagging nodes and tick durations")
+    {
+        // a node that lags behind doesn't move the tick back
+        info.tick = 999;
+        info.tickDuration = 4000;
+        tracker.AddSample(info, start + 1s);
+        REQUIRE(tracker.GetTickInfo()->tick == 1000);
+
+        // but its tick duration is averaged in
+        REQUIRE(tracker.GetTickDuration() == Approx(2400.0));
+
+        // unknown durations are ignored
+        info.tickDuration = 0;
+        tracker.AddSample(info, start + 1s);
+        REQUIRE(tracker.GetTickDuration() == Approx(2400.0));
+    }
+}
@@ -0,0 +1,157 @@
+#include <catch.hpp>
+
+#include <random>
+
+#include "core/four_q.h"
+#include "network/transactions.hpp"
+
+// ------------------------------------------------------------------------------------------------
+TEST_CASE("Sign transactions", "[Transactions]")
+{
+    std::mt19937 generator(32);
+
+    const auto signingKey =
+        CreateSigningKey("aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa").value();
+
+    // not a multiple of the signing group or four, spread over several threads
+    std::vector<Transfer> transfers(1003);
+    for (auto& transfer : transfers)
+    {
+        unsigned char publicKey[32];
+        for (auto& byte : publicKey)
+        {
+            byte = (unsigned char)generator();
+        }
+        char identity[61] = {0};
+        getIdentity(publicKey, identity, false);
+        transfer.recipient = identity;
+        transfer.amount = generator() % 1000000;
+    }
+
+    const unsigned int tick = 12345678;
+    auto result = SignTransactions(*signingKey, transfers, tick, 4);
+    REQUIRE(result.has_value());
+    REQUIRE(result->packets.size() == transfers.size());
+    REQUIRE(result->receipts.size() == transfers.size());
+
+    for (size_t i = 0; i < transfers.size(); ++i)
+    {
+        INFO("transfer " << i);
+        auto& packet = result->packets[i];
+        const auto& receipt = result->receipts[i];
+
+        REQUIRE(packet.header.size() == sizeof(TransactionPacket));
+        REQUIRE(packet.header.type() == BROADCAST_TRANSACTION);
+        REQUIRE(packet.transaction.amount == transfers[i].amount);
+        REQUIRE(packet.transaction.tick == tick);
+
+        unsigned char digest[32];
+        KangarooTwelve(
+            (unsigned char*)&packet.transaction,
+            sizeof(packet.transaction),
+            digest,
+            32);
+        REQUIRE(verify(signingKey->GetPublicKey(), digest, packet.signature));
+
+        KangarooTwelve(
+            (unsigned char*)&packet.transaction,
+            sizeof(packet.transaction) + SIGNATURE_SIZE,
+            digest,
+            32);
+        char hash[61] = {0};
+        getIdentity(digest, hash, true);
+        REQUIRE(receipt.hash == hash);
+        REQUIRE(receipt.sender == signingKey->GetIdentity());
+        REQUIRE(receipt.recipient == transfers[i].recipient);
+        REQUIRE(receipt.tick == tick);
+    }
+
+    // the single threaded path produces the same packets
+    auto single = SignTransactions(*signingKey, transfers, tick, 1);
+    REQUIRE(single.has_value());
+    REQUIRE(
+        memcmp(
+            single->packets.data(),
+            result->packets.data(),
+            transfers.size() * sizeof(TransactionPacket)) == 0);
+
+    // invalid recipient
+    transfers[700].recipient[3] = 'a';
+    auto invalid = SignTransactions(*signingKey, transfers, tick);
+    REQUIRE(invalid.has_value() == false);
+    REQUIRE(
+        invalid.error().message ==
+        "Failed to compute public key from identity: " + transfers[700].recipient);
+}
+
+// ------------------------------------------------------------------------------------------------
+TEST_CASE("Build transactions with input", "[Transactions]")
+{
+    const auto signingKey =
+        CreateSigningKey("aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa").value();
+    const std::string contract = "BAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAD";
+    const unsigned int tick = 12345678;
+
+    TransactionBuilder builder(signingKey);
+    ContractIPOBid bid;
+    bid.price = 1000;
+    bid.quantity = 3;
+    REQUIRE(builder.Add(contract, 0, tick, 1, bid).has_value());
+
+    unsigned char input[MAX_INPUT_SIZE];
+    for (size_t i = 0; i < sizeof(input); ++i)
+    {
+        input[i] = (unsigned char)i;
+    }
+    REQUIRE(builder.Add(contract, 1, tick, 2, input, MAX_INPUT_SIZE).has_value());
+    REQUIRE(builder.Add(signingKey->GetIdentity(), 5, tick).has_value());
+
+    SECTION("Invalid input is rejected")
+    {
+        const auto size = builder.GetSize();
+        REQUIRE_FALSE(builder.Add(contract, 0, tick, 2, input, MAX_INPUT_SIZE + 1).has_value());
+        REQUIRE_FALSE(builder.Add(contract, -1, tick).has_value());
+        REQUIRE(builder.GetSize() == size);
+        REQUIRE(builder.GetReceipts().size() == 3);
+    }
+
+    const unsigned short inputSizes[] = {sizeof(bid), MAX_INPUT_SIZE, 0};
+    const char* data = builder.GetData();
+    size_t offset = 0;
+    for (size_t i = 0; i < 3; ++i)
+    {
+        INFO("transaction " << i);
+        RequestResponseHeader header;
+        memcpy(&header, data + offset, sizeof(header));
+        REQUIRE(header.type() == BROADCAST_TRANSACTION);
+        REQUIRE(header.size() == sizeof(header) + sizeof(Transaction) + inputSizes[i] + 64);
+
+        std::vector<unsigned char> transaction(
+            data + offset + sizeof(header),
+            data + offset + header.size());
+        Transaction fields;
+        memcpy(&fields, transaction.data(), sizeof(fields));
+        REQUIRE(fields.inputSize == inputSizes[i]);
+        REQUIRE(fields.tick == tick);
+
+        // digest and hash equal hashing each from scratch
+        unsigned char digest[32];
+        KangarooTwelve(transaction.data(), sizeof(Transaction) + inputSizes[i], digest, 32);
+        REQUIRE(verify(
+            signingKey->GetPublicKey(),
+            digest,
+            transaction.data() + sizeof(Transaction) + inputSizes[i]));
+
+        KangarooTwelve(transaction.data(), (unsigned int)transaction.size(), digest, 32);
+        char hash[61] = {0};
+        getIdentity(digest, hash, true);
+        REQUIRE(builder.GetReceipts()[i].hash == hash);
+
+        offset += header.size();
+    }
+    REQUIRE(offset == builder.GetSize());
+
+    builder.Clear();
+    REQUIRE(builder.GetSize() == 0);
+    REQUIRE(builder.GetReceipts().empty());
+}
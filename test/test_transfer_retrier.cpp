@@ -0,0 +1,82 @@
+#include <catch.hpp>
+
+#include "network/transfer_retrier.hpp"
+
+// ------------------------------------------------------------------------------------------------
+TEST_CASE("Retry failed transfers", "[TransferRetrier]")
+{
+    const auto signingKey =
+        CreateSigningKey("aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa").value();
+    const auto recipient = signingKey->GetIdentity();
+
+    // the attempts of a transfer at successive ticks
+    std::vector<Receipt> attempts;
+    for (unsigned int tick = 1000; tick < 1004; ++tick)
+    {
+        attempts.push_back(
+            SignTransactions(*signingKey, {{recipient, 100}}, tick, 1)->receipts.front());
+    }
+
+    TransferRetrier retrier(3);
+    REQUIRE(retrier.CanBroadcast("payout-1"));
+    REQUIRE(retrier.Track("payout-1", signingKey, attempts[0]).has_value());
+    REQUIRE(retrier.GetKey(attempts[0].hash) == "payout-1");
+
+    // a pending attempt blocks new attempts
+    REQUIRE_FALSE(retrier.CanBroadcast("payout-1"));
+    REQUIRE_FALSE(retrier.Track("payout-1", signingKey, attempts[1]).has_value());
+
+    SECTION("Successful transfers are not retried")
+    {
+        auto confirmed = attempts[0];
+        confirmed.status = Receipt::Success;
+        REQUIRE_FALSE(retrier.Confirm(confirmed).has_value());
+        REQUIRE_FALSE(retrier.CanBroadcast("payout-1"));
+        REQUIRE(retrier.GetAttempts("payout-1").front().status == Receipt::Success);
+    }
+
+    SECTION("Failed transfers are retried until the limit")
+    {
+        for (size_t i = 0; i < 3; ++i)
+        {
+            auto failed = attempts[i];
+            failed.status = Receipt::Failed;
+            auto request = retrier.Confirm(failed);
+
+            if (i == 2)
+            {
+                REQUIRE_FALSE(request.has_value());
+                REQUIRE(request.error().message == "Transfer payout-1 has no attempts left");
+                break;
+            }
+
+            REQUIRE(request.has_value());
+            REQUIRE(request->key == "payout-1");
+            REQUIRE(request->signingKey == signingKey);
+            REQUIRE(request->transfer.recipient == recipient);
+            REQUIRE(request->transfer.amount == 100);
+            REQUIRE(request->attempts == i + 1);
+
+            // confirming the same failure again doesn't produce a second retry
+            REQUIRE(retrier.Track(request->key, signingKey, attempts[i + 1]).has_value());
+            REQUIRE_FALSE(retrier.Confirm(failed).has_value());
+        }
+
+        // the lineage runs from the original receipt to the last retry
+        const auto lineage = retrier.GetAttempts("payout-1");
+        REQUIRE(lineage.size() == 3);
+        for (size_t i = 0; i < lineage.size(); ++i)
+        {
+            REQUIRE(lineage[i].hash == attempts[i].hash);
+            REQUIRE(lineage[i].status == Receipt::Failed);
+        }
+        REQUIRE_FALSE(retrier.CanBroadcast("payout-1"));
+    }
+
+    SECTION("Unknown transactions are ignored")
+    {
+        REQUIRE_FALSE(retrier.Confirm(attempts[3]).has_value());
+        REQUIRE(retrier.GetKey(attempts[3].hash).empty());
+        REQUIRE(retrier.GetAttempts("payout-2").empty());
+    }
+}
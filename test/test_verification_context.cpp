@@ -0,0 +1,63 @@
+#include <catch.hpp>
+
+#include <random>
+
+#include "core/four_q.h"
+#include "crypto/verification_context.hpp"
+
+// ------------------------------------------------------------------------------------------------
+TEST_CASE("Verification context matches verify", "[VerificationContext]")
+{
+    std::mt19937 generator(30);
+
+    constexpr unsigned int keyCount = 5;
+    constexpr unsigned int count = 40;
+    unsigned char subseeds[keyCount][32], publicKeys[keyCount][32];
+    for (unsigned int i = 0; i < keyCount; ++i)
+    {
+        unsigned char privateKey[32];
+        for (auto& byte : subseeds[i])
+        {
+            byte = (unsigned char)generator();
+        }
+        getPrivateKey(subseeds[i], privateKey);
+        getPublicKey(privateKey, publicKeys[i]);
+    }
+
+    // three keys fit, so the keys are evicted and decoded again as they rotate
+    VerificationContext context(3);
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        const unsigned int key = (i * 7) % keyCount;
+        unsigned char publicKey[32], digest[32], signature[64];
+        for (auto& byte : digest)
+        {
+            byte = (unsigned char)generator();
+        }
+        memcpy(publicKey, publicKeys[key], 32);
+        sign(subseeds[key], publicKey, digest, signature);
+
+        switch (i % 4)
+        {
+        case 1:
+            digest[generator() % 32] ^= 1;
+            break;
+        case 2:
+            signature[generator() % 64] ^= 0x08;
+            break;
+        case 3:
+            publicKey[generator() % 32] ^= 0x02;
+            break;
+        }
+
+        INFO("signature " << i);
+        const bool expected = verify(publicKey, digest, signature);
+        REQUIRE(context.Verify(publicKey, digest, signature) == expected);
+        REQUIRE(context.Verify(publicKey, digest, signature) == expected);
+        REQUIRE(expected == (i % 4 == 0));
+        REQUIRE(context.GetSize() <= context.GetCapacity());
+    }
+
+    context.Clear();
+    REQUIRE(context.GetSize() == 0);
+}